@@ -0,0 +1,338 @@
+/*!
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 INRIA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * \file ex_parser_benchmark.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ *
+ * Status packet parser microbenchmark: generate a stream of Dynamixel status
+ * packets (with various sizes, and some protocol v2 byte stuffing), then feed it
+ * in small chunks (as read from a serial port) to:
+ * - a multi-pass reference, working like the previous receive path: the header
+ *   is searched again from the beginning of the buffer every time new bytes
+ *   arrive, then the packet is copied, checked and unstuffed in separate passes,
+ *   and the buffer is shifted.
+ * - the DynamixelParser streaming parser, which consumes each byte only once.
+ *
+ * Usage: ex_parser_benchmark [-protocol 1|2] [-packets count] [-chunk size]
+ */
+
+// Smart Servo Framework
+#include "../src/DynamixelParser.h"
+#include "../src/DynamixelTools.h"
+#include "../src/Deadline.h"
+
+// C++ standard library
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+/* ************************************************************************** */
+
+/*!
+ * \brief Append a status packet to a stream.
+ */
+static void addStatusPacket(std::vector <unsigned char> &stream, const int protocol, const int id, const std::vector <unsigned char> &params)
+{
+    size_t start = stream.size();
+
+    if (protocol == 2)
+    {
+        // Error and parameters, stuffed
+        std::vector <unsigned char> payload(1, 0x00);
+        payload.insert(payload.end(), params.begin(), params.end());
+
+        std::vector <unsigned char> stuffed(1, 0x55);
+        for (size_t i = 0; i < payload.size(); i++)
+        {
+            stuffed.push_back(payload[i]);
+            size_t s = stuffed.size();
+            if (s >= 3 && stuffed[s-1] == 0xFD && stuffed[s-2] == 0xFF && stuffed[s-3] == 0xFF)
+            {
+                stuffed.push_back(0xFD);
+            }
+        }
+
+        int length = static_cast<int>(stuffed.size()) + 2;
+        unsigned char header[] = {0xFF, 0xFF, 0xFD, 0x00, static_cast<unsigned char>(id),
+                                  static_cast<unsigned char>(length & 0xFF), static_cast<unsigned char>(length >> 8)};
+        stream.insert(stream.end(), header, header + sizeof(header));
+        stream.insert(stream.end(), stuffed.begin(), stuffed.end());
+
+        unsigned short crc = dxl2_crc16(0, &stream[start], static_cast<int>(stream.size() - start));
+        stream.push_back(static_cast<unsigned char>(crc & 0xFF));
+        stream.push_back(static_cast<unsigned char>(crc >> 8));
+    }
+    else
+    {
+        unsigned char header[] = {0xFF, 0xFF, static_cast<unsigned char>(id),
+                                  static_cast<unsigned char>(params.size() + 2), 0x00};
+        stream.insert(stream.end(), header, header + sizeof(header));
+        stream.insert(stream.end(), params.begin(), params.end());
+
+        unsigned char checksum = 0;
+        for (size_t i = start + 2; i < stream.size(); i++)
+        {
+            checksum += stream[i];
+        }
+        stream.push_back(static_cast<unsigned char>(~checksum));
+    }
+}
+
+/*!
+ * \brief Byte-wise table CRC, as computed by the multi-pass receive path.
+ */
+static unsigned short referenceCrc16(const unsigned char *data, const int size)
+{
+    static unsigned short table[256] = {0};
+
+    if (table[1] == 0)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            unsigned short crc = static_cast<unsigned short>(i << 8);
+            for (int b = 0; b < 8; b++)
+            {
+                crc = (crc & 0x8000) ? static_cast<unsigned short>((crc << 1) ^ 0x8005) : static_cast<unsigned short>(crc << 1);
+            }
+            table[i] = crc;
+        }
+    }
+
+    unsigned short crc = 0;
+    for (int i = 0; i < size; i++)
+    {
+        crc = static_cast<unsigned short>((crc << 8) ^ table[((crc >> 8) ^ data[i]) & 0xFF]);
+    }
+
+    return crc;
+}
+
+/*!
+ * \brief Multi-pass reference parser.
+ * \return The number of valid packets found.
+ *
+ * Mirrors the receive path used before the streaming parser: bytes are
+ * queued into a ring buffer, the header is searched one peek at a time, then
+ * the complete packet is extracted, checked, and unstuffed in separate passes.
+ */
+static unsigned referenceParse(const std::vector <unsigned char> &stream, const int protocol, const int chunk)
+{
+    const unsigned ringSize = 4096;
+    std::vector <unsigned char> ring(ringSize);
+    unsigned head = 0, tail = 0;
+
+    std::vector <unsigned char> packet(MAX_PACKET_LENGTH_dxlv2);
+    int headerSize = (protocol == 2) ? 4 : 2;
+    int minSize = (protocol == 2) ? 11 : 6;
+    unsigned count = 0;
+
+    for (size_t pos = 0; pos < stream.size(); pos += chunk)
+    {
+        size_t end = std::min(stream.size(), pos + chunk);
+        for (size_t i = pos; i < end; i++)
+        {
+            ring[tail++ & (ringSize - 1)] = stream[i];
+        }
+
+        while (true)
+        {
+            // Find the header, dropping the bytes in front of it
+            while (static_cast<int>(tail - head) >= headerSize &&
+                   !(ring[head & (ringSize - 1)] == 0xFF && ring[(head + 1) & (ringSize - 1)] == 0xFF &&
+                     (protocol == 1 || (ring[(head + 2) & (ringSize - 1)] == 0xFD && ring[(head + 3) & (ringSize - 1)] == 0x00))))
+            {
+                head++;
+            }
+
+            if (static_cast<int>(tail - head) < minSize)
+            {
+                break;
+            }
+
+            int size = (protocol == 2) ? ((ring[(head + 5) & (ringSize - 1)] | (ring[(head + 6) & (ringSize - 1)] << 8)) + 7)
+                                       : (ring[(head + 3) & (ringSize - 1)] + 4);
+            if (size > static_cast<int>(ringSize) / 2)
+            {
+                head++;
+                continue;
+            }
+            if (static_cast<int>(tail - head) < size)
+            {
+                break;
+            }
+
+            // Extract, check, then unstuff the packet
+            for (int i = 0; i < size; i++)
+            {
+                packet[i] = ring[head++ & (ringSize - 1)];
+            }
+
+            bool valid = false;
+            if (protocol == 2)
+            {
+                unsigned short crc = referenceCrc16(packet.data(), size - 2);
+                valid = (packet[size - 2] == (crc & 0xFF) && packet[size - 1] == (crc >> 8));
+
+                int out = 7;
+                for (int in = 7; in < size - 2; in++, out++)
+                {
+                    packet[out] = packet[in];
+                    if (packet[out] == 0xFD && out >= 9 && packet[out-1] == 0xFF && packet[out-2] == 0xFF &&
+                        (in + 1) < (size - 2) && packet[in+1] == 0xFD)
+                    {
+                        in++;
+                    }
+                }
+            }
+            else
+            {
+                unsigned char checksum = 0;
+                for (int i = 2; i < size - 1; i++)
+                {
+                    checksum += packet[i];
+                }
+                valid = (packet[size - 1] == static_cast<unsigned char>(~checksum));
+            }
+
+            if (valid == true)
+            {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*!
+ * \brief Streaming parser.
+ * \return The number of valid packets found.
+ */
+static unsigned streamingParse(const std::vector <unsigned char> &stream, const int protocol, const int chunk)
+{
+    DynamixelParser parser(protocol);
+    unsigned count = 0;
+
+    for (size_t pos = 0; pos < stream.size(); pos += chunk)
+    {
+        const unsigned char *data = &stream[pos];
+        int available = static_cast<int>(std::min(stream.size() - pos, static_cast<size_t>(chunk)));
+
+        while (available > 0)
+        {
+            int consumed = 0;
+            if (parser.parse(data, available, consumed) == PARSER_FRAME)
+            {
+                count++;
+            }
+            data += consumed;
+            available -= consumed;
+        }
+    }
+
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << std::endl << "======== Smart Servo Framework Parser Benchmark ========" << std::endl;
+
+    int protocol = 2, packets = 200000, chunk = 32;
+
+    // Argument(s) parsing
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-protocol", sizeof("-protocol")) == 0 && argv[i+1] != NULL)
+        {
+            protocol = (std::atoi(argv[++i]) == 1) ? 1 : 2;
+        }
+        else if (strncmp(argv[i], "-packets", sizeof("-packets")) == 0 && argv[i+1] != NULL)
+        {
+            packets = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (strncmp(argv[i], "-chunk", sizeof("-chunk")) == 0 && argv[i+1] != NULL)
+        {
+            chunk = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::cerr << "ex_parser_benchmark: unknown argument '" << argv[i] << "'" << std::endl;
+        }
+    }
+
+    // Generate the stream: position reads, full table reads, and a few packets
+    // with parameters that need byte stuffing, separated by some line noise
+    std::vector <unsigned char> stream;
+    srand(42);
+
+    for (int i = 0; i < packets; i++)
+    {
+        std::vector <unsigned char> params((i % 10 == 0) ? 64 : 2 + (i % 4) * 2);
+        for (size_t j = 0; j < params.size(); j++)
+        {
+            params[j] = static_cast<unsigned char>(rand() & 0xFF);
+        }
+        if (i % 16 == 0 && params.size() >= 3)
+        {
+            params[0] = 0xFF; params[1] = 0xFF; params[2] = 0xFD;
+        }
+        if (i % 50 == 0)
+        {
+            stream.push_back(0x00);
+        }
+
+        addStatusPacket(stream, protocol, 1 + (i % 20), params);
+    }
+
+    std::cout << "> " << packets << " protocol v" << protocol << " status packets, "
+              << stream.size() << " bytes, fed by chunks of " << chunk << " bytes" << std::endl << std::endl;
+
+    // Best of a few runs, to keep the cold caches out of the measure
+    unsigned refCount = 0, streamCount = 0;
+    int64_t refTime = INT64_MAX, streamTime = INT64_MAX;
+
+    for (int run = 0; run < 5; run++)
+    {
+        int64_t start = getTimeNs();
+        refCount = referenceParse(stream, protocol, chunk);
+        refTime = std::min(refTime, getTimeNs() - start);
+
+        start = getTimeNs();
+        streamCount = streamingParse(stream, protocol, chunk);
+        streamTime = std::min(streamTime, getTimeNs() - start);
+    }
+
+    std::cout << "Multi-pass reference: " << refCount << " packets in " << refTime / 1000 << " us ("
+              << (stream.size() * 1000.0) / refTime << " MB/s)" << std::endl;
+    std::cout << "Streaming parser:     " << streamCount << " packets in " << streamTime / 1000 << " us ("
+              << (stream.size() * 1000.0) / streamTime << " MB/s)" << std::endl;
+
+    if (streamTime > 0)
+    {
+        std::cout << "Speedup: x" << static_cast<double>(refTime) / streamTime << std::endl;
+    }
+
+    return (refCount == streamCount && streamCount == static_cast<unsigned>(packets)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,256 @@
+/*!
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 INRIA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * \file ex_registers_benchmark.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ *
+ * Register metadata lookup microbenchmark: compare the cost of a getter going
+ * through:
+ * - a linear reference, working like the previous lookup: the control table is
+ *   scanned for the register name, and the register count is searched again
+ *   (looking for the table end marker) at every step of the scan.
+ * - the getRegisterInfos() lookup, using the per control table index.
+ * - the Servo::getValue() getter, which adds the servo lock on top of it.
+ *
+ * It then indexes more control tables than the index can hold, and checks that
+ * the lookups falling back to a linear scan give the same results.
+ *
+ * Usage: ex_registers_benchmark [-lookups count]
+ */
+
+// Smart Servo Framework
+#include "../src/ControlTables.h"
+#include "../src/ServoMX.h"
+#include "../src/ServoDRS.h"
+#include "../src/Deadline.h"
+
+// C++ standard library
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+/* ************************************************************************** */
+
+/*!
+ * \brief Copies of a control table, used to fill the control table index up.
+ *
+ * The index keeps the address of every table it has seen, so these tables have
+ * to stay valid until the end of the process.
+ */
+static int tableCopies[CONTROL_TABLE_INDEX_MAX + 1][65][8];
+
+/*!
+ * \brief Register count, found by scanning for the table end marker.
+ */
+static unsigned referenceCount(const int ct[][8])
+{
+    for (unsigned i = 0; i < 64; i++)
+    {
+        if (ct[i][0] == 999)
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Linear reference lookup.
+ * \return 1 if the register has been found, -1 otherwise.
+ */
+static int referenceInfos(const int ct[][8], const int reg_name, RegisterInfos &infos)
+{
+    for (unsigned i = 0; i < referenceCount(ct); i++)
+    {
+        if (ct[i][0] == reg_name)
+        {
+            infos.reg_index = i;
+            infos.reg_addr_rom = ct[i][3];
+            infos.reg_addr_ram = ct[i][4];
+            infos.reg_addr = (ct[i][3] != -1) ? ct[i][3] : ct[i][4];
+            infos.reg_size = ct[i][1];
+            infos.reg_access_mode = ct[i][2];
+            infos.reg_value_def = ct[i][5];
+            infos.reg_value_min = ct[i][6];
+            infos.reg_value_max = ct[i][7];
+            return 1;
+        }
+    }
+
+    return -1;
+}
+
+/*!
+ * \brief Compare every lookup of a control table against another (indexed) table with the same content.
+ * \return true if all the lookups match.
+ */
+static bool checkLookups(const int ct[][8], const int ref[][8])
+{
+    unsigned count = getRegisterCount(ref);
+
+    if (getRegisterCount(ct) != count)
+    {
+        return false;
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        int reg = getRegisterName(ref, i);
+        RegisterInfos a, b;
+
+        if (getRegisterName(ct, i) != reg ||
+            getRegisterInfos(ct, reg, a) != 1 ||
+            getRegisterInfos(ref, reg, b) != 1 ||
+            std::memcmp(&a, &b, sizeof(RegisterInfos)) != 0 ||
+            getRegisterAddr(ct, reg) != getRegisterAddr(ref, reg))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Run a lookup over a list of register names, and report its cost.
+ * \return Checksum of the register indexes found, so the lookups can't be optimized away.
+ */
+template <typename Lookup>
+static long long runLookups(const char *name, const std::vector <int> &regs, const int lookups, Lookup lookup)
+{
+    long long checksum = 0;
+    int64_t best = INT64_MAX;
+
+    // Best of a few runs, to keep the cold caches out of the measure
+    for (int run = 0; run < 5; run++)
+    {
+        checksum = 0;
+        int64_t start = getTimeNs();
+
+        for (int i = 0; i < lookups; i++)
+        {
+            checksum += lookup(regs[i % regs.size()]);
+        }
+
+        best = std::min(best, getTimeNs() - start);
+    }
+
+    std::cout << name << static_cast<double>(best) / lookups << " ns per lookup" << std::endl;
+
+    return checksum;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << std::endl << "======== Smart Servo Framework Registers Benchmark ========" << std::endl;
+
+    int lookups = 2000000;
+
+    // Argument(s) parsing
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-lookups", sizeof("-lookups")) == 0 && argv[i+1] != NULL)
+        {
+            lookups = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::cerr << "ex_registers_benchmark: unknown argument '" << argv[i] << "'" << std::endl;
+        }
+    }
+
+    bool success = true;
+
+    ServoMX mx(1, 0x1D);             // MX-28 model number
+    ServoDRS drs(2, 0x0101);         // DRS-0101 model number
+    Servo *servos[] = {&mx, &drs};
+
+    for (Servo *s: servos)
+    {
+        const int (*ct)[8] = s->getControlTable();
+
+        // Look every register of the table up, in order
+        std::vector <int> regs;
+        for (int i = 0; i < s->getRegisterCount(); i++)
+        {
+            regs.push_back(getRegisterName(ct, i));
+        }
+
+        std::cout << std::endl << "> " << regs.size() << " registers control table, "
+                  << lookups << " lookups" << std::endl;
+
+        long long ref = runLookups("Linear reference:  ", regs, lookups, [ct](int reg)
+        {
+            RegisterInfos infos;
+            return (referenceInfos(ct, reg, infos) == 1) ? infos.reg_index : -1;
+        });
+
+        long long idx = runLookups("getRegisterInfos:  ", regs, lookups, [ct](int reg)
+        {
+            RegisterInfos infos;
+            return (getRegisterInfos(ct, reg, infos) == 1) ? infos.reg_index : -1;
+        });
+
+        runLookups("Servo::getValue(): ", regs, lookups, [s](int reg)
+        {
+            return s->getValue(reg);
+        });
+
+        if (ref != idx)
+        {
+            std::cerr << "Lookup results mismatch!" << std::endl;
+            success = false;
+        }
+    }
+
+    // Index more copies of a control table than the index can hold, the last
+    // ones are only available through the linear scan fallback
+    {
+        const int (*ct)[8] = mx.getControlTable();
+        unsigned rows = getRegisterCount(ct) + 1; // with the end marker
+        int failures = 0;
+
+        for (auto &copy: tableCopies)
+        {
+            std::memcpy(copy, ct, rows * sizeof(copy[0]));
+
+            if (checkLookups(copy, ct) == false)
+            {
+                failures++;
+            }
+        }
+
+        std::cout << std::endl << "> Index fallback: " << CONTROL_TABLE_INDEX_MAX + 1 << " control tables, "
+                  << failures << " mismatch(es)" << std::endl;
+
+        if (failures > 0)
+        {
+            success = false;
+        }
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
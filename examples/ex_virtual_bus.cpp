@@ -0,0 +1,214 @@
+/*!
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 INRIA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * \file ex_virtual_bus.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ *
+ * Virtual servo bus daemon: open a pseudo-terminal pair and answer Dynamixel
+ * (protocol v1 or v2) or HerkuleX instruction packets on it, using simulated
+ * devices. Any program using the framework can then connect to the printed
+ * /dev/pts/X path (or to the '-link' symlink) as if it was a real serial port,
+ * which is handy to measure throughput, latency jitter or scan time without servos.
+ *
+ * Usage: ex_virtual_bus [-protocol dxl1|dxl2|hkx] [-link path] [-servo id:model_number]...
+ * Ex:    ex_virtual_bus -protocol dxl1 -link /tmp/ttyVIRTUAL0 -servo 1:0x000C -servo 2:0x001D
+ *
+ * This program only works on Linux.
+ */
+
+// Smart Servo Framework
+#include "../src/VirtualServoBus.h"
+
+// C++ standard library
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+
+// Linux specific
+#include <pty.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* ************************************************************************** */
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int)
+{
+    running = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << std::endl << "======== Smart Servo Framework Virtual Bus ========" << std::endl;
+
+    int serie = SERVO_DYNAMIXEL, protocol = 1;
+    std::string link;
+    std::vector <std::pair<int, int> > devices;
+
+    // Argument(s) parsing
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-protocol", sizeof("-protocol")) == 0 && argv[i+1] != NULL)
+        {
+            i++;
+            if (strcmp(argv[i], "dxl2") == 0)
+            {
+                protocol = 2;
+            }
+            else if (strcmp(argv[i], "hkx") == 0)
+            {
+                serie = SERVO_HERKULEX;
+            }
+            else if (strcmp(argv[i], "dxl1") != 0)
+            {
+                std::cerr << "-protocol: unknown protocol '" << argv[i] << "'" << std::endl;
+            }
+        }
+        else if (strncmp(argv[i], "-link", sizeof("-link")) == 0 && argv[i+1] != NULL)
+        {
+            link = argv[++i];
+        }
+        else if (strncmp(argv[i], "-servo", sizeof("-servo")) == 0 && argv[i+1] != NULL)
+        {
+            i++;
+            char *sep = strchr(argv[i], ':');
+            if (sep != NULL)
+            {
+                devices.push_back(std::make_pair(std::atoi(argv[i]), static_cast<int>(std::strtol(sep + 1, NULL, 0))));
+            }
+            else
+            {
+                std::cerr << "-servo: expected 'id:model_number', got '" << argv[i] << "'" << std::endl;
+            }
+        }
+        else
+        {
+            std::cerr << "ex_virtual_bus: unknown argument '" << argv[i] << "'" << std::endl;
+        }
+    }
+
+    // Default device: an AX-12A, an XL-320 or a DRS-0101 at ID 1
+    if (devices.empty() == true)
+    {
+        int model = (serie == SERVO_HERKULEX) ? 0x0101 : ((protocol == 2) ? 0x015E : 0x000C);
+        devices.push_back(std::make_pair(1, model));
+    }
+
+    VirtualServoBus bus(serie, protocol);
+    for (auto d: devices)
+    {
+        bus.addServo(d.first, d.second);
+    }
+
+    if (bus.getServoCount() == 0)
+    {
+        std::cerr << "> No valid virtual servo! Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Open the pseudo-terminal pair
+    int master = -1, slave = -1;
+    char slaveName[128] = {0};
+    if (openpty(&master, &slave, slaveName, NULL, NULL) != 0)
+    {
+        std::cerr << "> Failed to open a pseudo-terminal! Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Raw mode, no echo. We keep 'slave' open so the master does not hang up between clients.
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    if (link.empty() == false)
+    {
+        unlink(link.c_str());
+        if (symlink(slaveName, link.c_str()) != 0)
+        {
+            std::cerr << "> Failed to create the '" << link << "' symlink" << std::endl;
+            link.clear();
+        }
+    }
+
+    std::cout << "> Virtual bus (" << ((serie == SERVO_HERKULEX) ? "HerkuleX" : ((protocol == 2) ? "Dynamixel v2" : "Dynamixel v1"))
+              << ") with " << bus.getServoCount() << " device(s) available on: " << slaveName << std::endl;
+    if (link.empty() == false)
+    {
+        std::cout << "> Also available on: " << link << std::endl;
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    std::cout << std::endl << "======== MAIN LOOP ========" << std::endl;
+
+    unsigned char buffer[4096];
+    std::vector <unsigned char> answer;
+    answer.reserve(sizeof(buffer));
+
+    while (running)
+    {
+        struct pollfd pfd = {master, POLLIN, 0};
+
+        if (poll(&pfd, 1, 500) > 0)
+        {
+            ssize_t n = read(master, buffer, sizeof(buffer));
+            if (n > 0)
+            {
+                bus.receive(buffer, static_cast<int>(n), answer);
+
+                size_t sent = 0;
+                while (sent < answer.size())
+                {
+                    ssize_t w = write(master, answer.data() + sent, answer.size() - sent);
+                    if (w <= 0)
+                    {
+                        break;
+                    }
+                    sent += static_cast<size_t>(w);
+                }
+                answer.clear();
+            }
+        }
+    }
+
+    std::cout << std::endl << "======== EXITING ========" << std::endl;
+    std::cout << "> " << bus.getPacketCount() << " packet(s) processed, " << bus.getErrorCount() << " corrupted packet(s) dropped" << std::endl;
+
+    if (link.empty() == false)
+    {
+        unlink(link.c_str());
+    }
+    close(slave);
+    close(master);
+
+    return EXIT_SUCCESS;
+}
+
+/* ************************************************************************** */
@@ -27,6 +27,9 @@
 
 // C++ standard libraries
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 const int (*getRegisterTable(const int servo_model))[8]
 {
@@ -163,81 +166,226 @@ const int (*getRegisterTable(const int servo_serie, const int servo_model))[8]
     return ct;
 }
 
-unsigned getRegisterCount(const int ct[][8])
+/* ************************************************************************** */
+
+/*!
+ * \brief ControlTableIndex structure: lookups precomputed once per control table.
+ */
+typedef struct ControlTableIndex
 {
-    unsigned count = 0;
+    const int (*ct)[8];                         //!< The indexed control table
+    int count;                                  //!< Number of registers into the control table
+    signed char slots[REG_COUNT];               //!< Register name to control table index, -1 if not available
+    RegisterInfos infos[64];                    //!< Register informations, by control table index
 
-    if (ct != NULL)
+} ControlTableIndex;
+
+static ControlTableIndex *indexes[CONTROL_TABLE_INDEX_MAX];
+static std::atomic <int> indexesCount(0);
+static std::mutex indexesLock;
+
+/*!
+ * \brief Count the registers of a control table, by looking for its end marker.
+ * \param ct: A device's control table.
+ * \return The number of registers into the control table.
+ */
+static int scanRegisterCount(const int ct[][8])
+{
+    // Register count // Horrible hack
+    for (int i = 0; i < 64; i++)
     {
-        // Register count // Horrible hack
-        for (unsigned i = 0; i < 64; i++)
+        if (ct[i][0] == 999)
         {
-            if (ct[i][0] == 999)
-            {
-                TRACE_1(TABLES, "Control table size is: '%i'\n", i);
-                count = i;
-                break; // exit search loop
-            }
+            return i;
         }
     }
 
-    return count;
+    return 0;
 }
 
-int getRegisterInfos(const int ct[][8], const int reg_name, RegisterInfos &infos)
+/*!
+ * \brief Fill the informations of a register from its control table row.
+ * \param ct: A device's control table.
+ * \param i: Index of the register into the control table.
+ * \param[out] infos: The register informations.
+ */
+static void fillRegisterInfos(const int ct[][8], const int i, RegisterInfos &infos)
 {
-    int status = -1;
+    infos.reg_index = i;
+    infos.reg_addr_rom = ct[i][3];
+    infos.reg_addr_ram = ct[i][4];
+    infos.reg_addr = (ct[i][3] != -1) ? ct[i][3] : ct[i][4];
+    infos.reg_size = ct[i][1];
+    infos.reg_access_mode = ct[i][2];
+    infos.reg_value_def = ct[i][5];
+    infos.reg_value_min = ct[i][6];
+    infos.reg_value_max = ct[i][7];
+
+    // Ignore the '-1' and '-2' values for min and max, indicating "no boundaries"
+    if (infos.reg_value_min < 0)
+    {
+        infos.reg_value_min = 0;
+    }
+    if (infos.reg_value_max < 0)
+    {
+        if (ct[i][1] < 5)
+        {
+            infos.reg_value_max = static_cast<int>(pow(2, infos.reg_size*8));
+        }
+        else
+        {
+            infos.reg_value_max = 0xFFFFFFFF;
+        }
+    }
+}
+
+/*!
+ * \brief Build the lookups of a control table.
+ * \param ct: A device's control table.
+ * \param[out] index: The lookups to fill.
+ */
+static void buildRegisterIndex(const int ct[][8], ControlTableIndex &index)
+{
+    index.ct = ct;
+    index.count = scanRegisterCount(ct);
+    TRACE_1(TABLES, "Control table size is: '%i'\n", index.count);
+    std::fill(index.slots, index.slots + REG_COUNT, -1);
 
-    if (ct != NULL)
+    for (int i = index.count - 1; i >= 0; i--)
     {
-        TRACE_1(TABLES, "Control table size is: '%i'\n", getRegisterCount(ct));
+        fillRegisterInfos(ct, i, index.infos[i]);
 
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
+        // Going backward, so the first occurrence of a name wins
+        if (ct[i][0] >= 0 && ct[i][0] < REG_COUNT)
+        {
+            index.slots[ct[i][0]] = static_cast<signed char>(i);
+        }
+    }
+}
+
+/*!
+ * \brief Get the lookups of a control table, building them on first use.
+ * \param ct: A device's control table.
+ * \return The lookups for this control table, or NULL.
+ *
+ * Published indexes are never modified, so the lookup itself doesn't need to
+ * lock: the counter is only increased once the new index is complete.
+ */
+static const ControlTableIndex *getRegisterIndex(const int ct[][8])
+{
+    if (ct == NULL)
+    {
+        return NULL;
+    }
+
+    int count = indexesCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        if (indexes[i]->ct == ct)
+        {
+            return indexes[i];
+        }
+    }
+
+    std::lock_guard <std::mutex> lock(indexesLock);
+
+    // Another thread may have indexed this table in the meantime
+    int total = indexesCount.load(std::memory_order_relaxed);
+    for (int i = count; i < total; i++)
+    {
+        if (indexes[i]->ct == ct)
         {
-            TRACE_1(TABLES, "Control table [%i / %i] value: '%i'\n", i, getRegisterCount(ct), ct[i][0]);
+            return indexes[i];
+        }
+    }
+
+    if (total >= CONTROL_TABLE_INDEX_MAX)
+    {
+        TRACE_1(TABLES, "Unable to index a new 'Control Table': too many tables, using a linear scan\n");
+        return NULL;
+    }
+
+    ControlTableIndex *index = new ControlTableIndex;
+    buildRegisterIndex(ct, *index);
 
-            if (ct[i][0] == reg_name) // match register name
+    indexes[total] = index;
+    indexesCount.store(total + 1, std::memory_order_release);
+
+    return index;
+}
+
+/*!
+ * \brief Get the informations of a register from the lookups of its control table.
+ * \param ct: A device's control table.
+ * \param reg_name: The name of the register.
+ * \param[out] scan: Storage used when the control table is not indexed and has to be scanned.
+ * \return A pointer to the register informations, or NULL if not available.
+ */
+static inline const RegisterInfos *findRegister(const int ct[][8], const int reg_name, RegisterInfos &scan)
+{
+    if (ct == NULL || reg_name < 0 || reg_name >= REG_COUNT)
+    {
+        return NULL;
+    }
+
+    const ControlTableIndex *index = getRegisterIndex(ct);
+
+    if (index != NULL)
+    {
+        int i = index->slots[reg_name];
+        if (i >= 0)
+        {
+            return &index->infos[i];
+        }
+    }
+    else
+    {
+        // The index is full, fall back to a linear scan of the table
+        int count = scanRegisterCount(ct);
+        for (int i = 0; i < count; i++)
+        {
+            if (ct[i][0] == reg_name)
             {
-                infos.reg_index = i;
-
-                int rom = ct[i][3];
-                int ram = ct[i][4];
-
-                if (rom != -1)
-                    infos.reg_addr = rom;
-                else if (ram != -1)
-                    infos.reg_addr = ram;
-
-                infos.reg_addr_rom = rom;
-                infos.reg_addr_ram = ram;
-                infos.reg_size = ct[i][1];
-                infos.reg_access_mode = ct[i][2];
-                infos.reg_value_def = ct[i][5];
-                infos.reg_value_min = ct[i][6];
-                infos.reg_value_max = ct[i][7];
-
-                // Ignore the '-1' and '-2' values for min and max, indicating "no boundaries"
-                if (infos.reg_value_min < 0)
-                {
-                    infos.reg_value_min = 0;
-                }
-                if (infos.reg_value_max < 0)
-                {
-                    if (ct[i][1] < 5)
-                    {
-                        infos.reg_value_max = static_cast<int>(pow(2, infos.reg_size*8));
-                    }
-                    else
-                    {
-                        infos.reg_value_max = 0xFFFFFFFF;
-                    }
-                }
-                status = 1;
-                break; // exit search loop
+                fillRegisterInfos(ct, i, scan);
+                return &scan;
             }
         }
     }
 
+    return NULL;
+}
+
+/* ************************************************************************** */
+
+unsigned getRegisterCount(const int ct[][8])
+{
+    unsigned count = 0;
+
+    const ControlTableIndex *index = getRegisterIndex(ct);
+    if (index != NULL)
+    {
+        count = static_cast<unsigned>(index->count);
+    }
+    else if (ct != NULL)
+    {
+        count = static_cast<unsigned>(scanRegisterCount(ct));
+    }
+
+    return count;
+}
+
+int getRegisterInfos(const int ct[][8], const int reg_name, RegisterInfos &infos)
+{
+    int status = -1;
+
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
+    {
+        infos = *reg;
+        status = 1;
+    }
+
     return status;
 }
 
@@ -245,12 +393,9 @@ int getRegisterName(const int ct[][8], const int reg_index)
 {
     int name = -1;
 
-    if (ct != NULL)
+    if (reg_index >= 0 && reg_index < static_cast<int>(getRegisterCount(ct)))
     {
-        if (reg_index >= 0 && reg_index < static_cast<int>(getRegisterCount(ct)))
-        {
-            name = ct[reg_index][0];
-        }
+        name = ct[reg_index][0];
     }
 
     return name;
@@ -260,16 +405,11 @@ int getRegisterTableIndex(const int ct[][8], const int reg_name)
 {
     int index = -1;
 
-    if (ct != NULL)
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                index = i;
-                break;
-            }
-        }
+        index = reg->reg_index;
     }
 
     return index;
@@ -279,32 +419,21 @@ int getRegisterAddr(const int ct[][8], const int reg_name, const int reg_type)
 {
     int addr = -1;
 
-    if (ct != NULL)
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
+        if (reg_type == REGISTER_AUTO)
         {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                if (reg_type == REGISTER_AUTO)
-                {
-                    int rom = ct[i][3];
-                    int ram = ct[i][4];
-
-                    if (rom != -1)
-                        addr = rom;
-                    else if (ram != -1)
-                        addr = ram;
-                }
-                else if (reg_type == REGISTER_ROM)
-                {
-                    addr = ct[i][3];
-                }
-                else if (reg_type == REGISTER_RAM)
-                {
-                    addr = ct[i][4];
-                }
-                break;
-            }
+            addr = reg->reg_addr;
+        }
+        else if (reg_type == REGISTER_ROM)
+        {
+            addr = reg->reg_addr_rom;
+        }
+        else if (reg_type == REGISTER_RAM)
+        {
+            addr = reg->reg_addr_ram;
         }
     }
 
@@ -315,16 +444,11 @@ int getRegisterSize(const int ct[][8], const int reg_name)
 {
     int size = -1;
 
-    if (ct != NULL)
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                size = ct[i][1];
-                break;
-            }
-        }
+        size = reg->reg_size;
     }
 
     return size;
@@ -334,16 +458,11 @@ int getRegisterAccessMode(const int ct[][8], const int reg_name)
 {
     int mode = -1;
 
-    if (ct != NULL)
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                mode = ct[i][2];
-                break;
-            }
-        }
+        mode = reg->reg_access_mode;
     }
 
     return mode;
@@ -353,16 +472,11 @@ int getRegisterInitialValue(const int ct[][8], const int reg_name)
 {
     int value = -1;
 
-    if (ct != NULL)
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                value = ct[i][5];
-                break;
-            }
-        }
+        value = reg->reg_value_def;
     }
 
     return value;
@@ -372,37 +486,57 @@ int getRegisterBounds(const int ct[][8], const int reg_name, int &min, int &max)
 {
     int status = -1;
 
-    if (ct != NULL)
+    RegisterInfos scan;
+    const RegisterInfos *reg = findRegister(ct, reg_name, scan);
+    if (reg != NULL)
+    {
+        min = reg->reg_value_min;
+        max = reg->reg_value_max;
+        status = 1;
+    }
+
+    return status;
+}
+
+int getRegisterRuns(const int ct[][8], const int reg_type, const int max_size, const int max_gap, std::vector <RegisterRun> &runs)
+{
+    std::vector <RegisterRun> regs;
+    int column = (reg_type == REGISTER_ROM) ? 3 : 4;
+
+    runs.clear();
+
+    if (ct != NULL && (reg_type == REGISTER_ROM || reg_type == REGISTER_RAM))
     {
         for (unsigned i = 0; i < getRegisterCount(ct); i++)
         {
-            if (ct[i][0] == reg_name) // match register name
+            if (ct[i][column] >= 0 && ct[i][1] > 0)
             {
-                min = ct[i][6];
-                max = ct[i][7];
+                RegisterRun r = {ct[i][column], ct[i][1]};
+                regs.push_back(r);
+            }
+        }
 
-                // Ignore the '-1' and '-2' values for min and max, indicating "no boundaries"
-                if (min < 0)
-                {
-                    min = 0;
-                }
-                if (max < 0)
+        std::sort(regs.begin(), regs.end(),
+                  [](const RegisterRun &a, const RegisterRun &b) { return a.addr < b.addr; });
+
+        for (auto const &r: regs)
+        {
+            if (runs.empty() == false)
+            {
+                RegisterRun &last = runs.back();
+                int end = last.addr + last.size;
+
+                // Extend the current run if the register is close enough and the run does not get too long
+                if (r.addr <= end + max_gap && (r.addr + r.size - last.addr) <= max_size)
                 {
-                    if (ct[i][1] < 5)
-                    {
-                        max = static_cast<int>(pow(2, (ct[i][1])*8));
-                    }
-                    else
-                    {
-                        max = 0xFFFFFFFF;
-                    }
+                    last.size = std::max(end, r.addr + r.size) - last.addr;
+                    continue;
                 }
-
-                status = 1;
-                break;
             }
+
+            runs.push_back(r);
         }
     }
 
-    return status;
+    return static_cast<int>(runs.size());
 }
@@ -24,6 +24,9 @@
 #define CONTROL_TABLES_H
 /* ************************************************************************** */
 
+// C++ standard libraries
+#include <vector>
+
 /** \addtogroup ControlTables
  *  @{
  */
@@ -72,6 +75,16 @@ typedef struct RegisterInfos
 
 } RegisterInfos;
 
+/*!
+ * \brief RegisterRun structure: a range of registers that can be fetched with a single read instruction.
+ */
+typedef struct RegisterRun
+{
+    int addr;            //!< Start address of the run
+    int size;            //!< Size of the run, in byte(s)
+
+} RegisterRun;
+
 /* ************************************************************************** */
 
 /*!
@@ -98,6 +111,20 @@ unsigned getRegisterCount(const int ct[][8]);
 
 /* ************************************************************************** */
 
+/*!
+ * \brief Maximum number of control tables indexed by the register lookups.
+ *
+ * Each translation unit including a control table header holds its own copy of
+ * the tables it uses. Lookups on the tables that don't fit into the index fall
+ * back to a linear scan of the table.
+ */
+#define CONTROL_TABLE_INDEX_MAX     128
+
+// The following lookups go through an index built on first use for each control
+// table, so they don't have to scan the table. The index is keyed on the address
+// of the table and is never cleared: a control table given to these lookups must
+// never be modified or freed while the process runs (use static tables).
+
 int getRegisterInfos(const int ct[][8], const int reg_name, RegisterInfos &infos);
 
 int getRegisterTableIndex(const int ct[][8], const int reg_name);
@@ -114,6 +141,17 @@ int getRegisterInitialValue(const int ct[][8], const int reg_name);
 
 int getRegisterBounds(const int ct[][8], const int reg_name, int &min, int &max);
 
+/*!
+ * \brief Split the registers of a control table into contiguous address runs.
+ * \param ct: A device's control table.
+ * \param reg_type: The area to split, REGISTER_ROM or REGISTER_RAM.
+ * \param max_size: Maximum size of a run, in byte(s).
+ * \param max_gap: Maximum number of unused bytes a run can span between two registers.
+ * \param[out] runs: The runs found, by increasing address.
+ * \return The number of runs found.
+ */
+int getRegisterRuns(const int ct[][8], const int reg_type, const int max_size, const int max_gap, std::vector <RegisterRun> &runs);
+
 /** @}*/
 
 /* ************************************************************************** */
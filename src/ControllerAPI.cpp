@@ -21,22 +21,48 @@
  */
 
 #include "ControllerAPI.h"
+#include "Deadline.h"
 #include "minitraces.h"
 
 // C standard library
 #include <string.h>
 
+#if defined(__linux__)
+// Linux specific (real-time scheduling)
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#endif
+
 // C++ standard libraries
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
+// Enable latency timer
+//#define LATENCY_TIMER
+
 /* ************************************************************************** */
 
 ControllerAPI::ControllerAPI(int ctrlFrequency):
     controllerState(state_stopped),
     errorCount(0),
-    syncloopCounter(0)
+    syncloopDeadline(0),
+    syncloopStartTime(0),
+    overrunCount(0),
+    syncloopCounter(0),
+    registerScheduler((ctrlFrequency < 1 || ctrlFrequency > 120) ? 30 : ctrlFrequency)
 {
+    std::fill(servoTable, servoTable + BROADCAST_ID, static_cast<Servo *>(NULL));
+
+    rtSettings.enabled = false;
+    rtSettings.priority = 0;
+    rtSettings.cpu = -1;
+    rtSettings.lockMemory = false;
+    rtSettings.overrunPolicy = OVERRUN_SKIP;
+
     if (ctrlFrequency < 1 || ctrlFrequency > 120)
     {
         syncloopFrequency = 30;
@@ -112,6 +138,7 @@ void ControllerAPI::stopThread()
 
         // Cleanup controller
         unregisterServos_internal();
+        registerScheduler.clear();
         clearMessageQueue();
         clearErrorCount();
         setState(state_stopped);
@@ -214,34 +241,263 @@ void ControllerAPI::clearErrorCount()
 
 /* ************************************************************************** */
 
+void ControllerAPI::setRealTime(const RealTimeSettings &settings)
+{
+    std::lock_guard <std::mutex> lock(realTimeLock);
+    rtSettings = settings;
+
+    if (rtSettings.overrunPolicy != OVERRUN_SKIP && rtSettings.overrunPolicy != OVERRUN_CATCHUP)
+    {
+        TRACE_WARNING(CAPI, "Invalid overrun policy: '%i', using OVERRUN_SKIP\n", settings.overrunPolicy);
+        rtSettings.overrunPolicy = OVERRUN_SKIP;
+    }
+}
+
+RealTimeSettings ControllerAPI::getRealTime()
+{
+    std::lock_guard <std::mutex> lock(realTimeLock);
+    return rtSettings;
+}
+
+unsigned ControllerAPI::getOverrunCount()
+{
+    std::lock_guard <std::mutex> lock(realTimeLock);
+    return overrunCount;
+}
+
+void ControllerAPI::setRegisterRate(int id, int reg, double rate, int priority)
+{
+    registerScheduler.setRate(id, reg, rate, priority);
+}
+
+void ControllerAPI::resetRegisterRates(int id)
+{
+    registerScheduler.resetRates(id);
+}
+
+int ControllerAPI::syncloopReadBudget() const
+{
+    return static_cast<int>(syncloopDuration * 1000.0 * SYNCLOOP_READ_SHARE);
+}
+
+void ControllerAPI::syncloopStart()
+{
+    RealTimeSettings settings = getRealTime();
+
+    if (settings.enabled == true)
+    {
+#if defined(__linux__)
+        if (settings.lockMemory == true)
+        {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            {
+                TRACE_WARNING(CAPI, "Unable to lock memory: %s\n", strerror(errno));
+            }
+        }
+
+        if (settings.cpu >= 0)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(settings.cpu, &cpus);
+
+            int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+            if (err != 0)
+            {
+                TRACE_WARNING(CAPI, "Unable to pin the sync loop thread on CPU %i: %s\n", settings.cpu, strerror(err));
+            }
+        }
+
+        if (settings.priority > 0)
+        {
+            struct sched_param param;
+            memset(&param, 0, sizeof(param));
+            param.sched_priority = std::min(std::max(settings.priority, sched_get_priority_min(SCHED_FIFO)),
+                                            sched_get_priority_max(SCHED_FIFO));
+
+            int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (err != 0)
+            {
+                TRACE_WARNING(CAPI, "Unable to use SCHED_FIFO (priority %i) for the sync loop thread: %s\n", param.sched_priority, strerror(err));
+            }
+        }
+#else
+        if (settings.lockMemory == true || settings.cpu >= 0 || settings.priority > 0)
+        {
+            TRACE_WARNING(CAPI, "Real-time scheduling, CPU affinity and memory locking are only available on Linux\n");
+        }
+#endif
+    }
+
+    {
+        std::lock_guard <std::mutex> lock(realTimeLock);
+        overrunCount = 0;
+    }
+
+    syncloopStartTime = getTimeNs();
+    syncloopDeadline = syncloopStartTime;
+}
+
+void ControllerAPI::syncloopWait()
+{
+    RealTimeSettings settings = getRealTime();
+    int64_t period = 1000000000LL / syncloopFrequency;
+    int64_t now = getTimeNs();
+
+#ifdef LATENCY_TIMER
+    double loopd = static_cast<double>(now - syncloopStartTime) / 1000000.0;
+    if (loopd > syncloopDuration)
+    {
+        TRACE_WARNING(CAPI, "Sync loop duration: %fms of the %fms budget.\n", loopd, syncloopDuration);
+    }
+    else
+    {
+        TRACE_INFO(CAPI, "Sync loop duration: %fms of the %fms budget.\n", loopd, syncloopDuration);
+    }
+#endif
+
+    if (settings.enabled == false)
+    {
+        // Sleep for what is left of this cycle
+        int64_t waitd = period - (now - syncloopStartTime);
+        if (waitd > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(waitd));
+        }
+
+        syncloopStartTime = getTimeNs();
+        syncloopDeadline = syncloopStartTime;
+        return;
+    }
+
+    // The next period starts exactly one period after this one, whatever
+    // the duration of this cycle and the wake up latency
+    syncloopDeadline += period;
+
+    if (now > syncloopDeadline)
+    {
+        int64_t late = now - syncloopDeadline;
+        int64_t missed = late / period;
+
+        {
+            std::lock_guard <std::mutex> lock(realTimeLock);
+            overrunCount++;
+        }
+
+        TRACE_1(CAPI, "Sync loop overrun: next cycle %lli us late\n", static_cast<long long>(late / 1000));
+
+        if (settings.overrunPolicy == OVERRUN_SKIP || missed >= SYNCLOOP_CATCHUP_MAX)
+        {
+            // Drop the missed periods, but keep the phase of the loop
+            syncloopDeadline += (missed + 1) * period;
+        }
+        else
+        {
+            // Catch up: start the next cycle right away
+            syncloopStartTime = now;
+            return;
+        }
+    }
+
+#if defined(__linux__)
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(syncloopDeadline / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(syncloopDeadline % 1000000000LL);
+
+    // getTimeNs() uses CLOCK_MONOTONIC too, restart if interrupted by a signal
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+    int64_t waitd = syncloopDeadline - getTimeNs();
+    if (waitd > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(waitd));
+    }
+#endif
+
+    syncloopStartTime = getTimeNs();
+}
+
+/* ************************************************************************** */
+
+Servo *ControllerAPI::findServo_internal(const int id)
+{
+    if (id < 0 || id >= BROADCAST_ID)
+    {
+        return NULL;
+    }
+
+    Servo *servo = servoTable[id];
+
+    if (servo == NULL || servo->getId() != id)
+    {
+        // The device in this slot changed its ID (or the slot is empty):
+        // move it to its new slot, and look for the device now using this ID
+        if (servo != NULL)
+        {
+            servoTable[id] = NULL;
+
+            int newId = servo->getId();
+            if (newId >= 0 && newId < BROADCAST_ID && servoTable[newId] == NULL)
+            {
+                servoTable[newId] = servo;
+            }
+        }
+
+        servo = NULL;
+        for (auto s: servoList)
+        {
+            if (s->getId() == id)
+            {
+                servoTable[id] = s;
+                servo = s;
+                break;
+            }
+        }
+    }
+
+    return servo;
+}
+
+void ControllerAPI::unsyncServo_internal(const int id)
+{
+    updateList.erase(std::remove(updateList.begin(), updateList.end(), id), updateList.end());
+    syncList.erase(std::remove(syncList.begin(), syncList.end(), id), syncList.end());
+}
+
 void ControllerAPI::registerServo_internal(Servo *servo)
 {
     if (getState() >= state_started)
     {
         if (getState() != state_scanning)
         {
+            int id = servo->getId();
+
             // Lock servoList
             std::lock_guard <std::mutex> lock(servoListLock);
 
+            if (id < 0 || id >= BROADCAST_ID)
+            {
+                TRACE_ERROR(CAPI, "Unable to register servo #%i: invalid ID!\n", id);
+                return;
+            }
+
             // Check if the servo is already registered
-            for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end(); ++it)
+            if (findServo_internal(id) != NULL)
             {
-                if ((*it)->getId() == (*servo).getId())
-                {
-                    TRACE_ERROR(CAPI, "Unable to register servo #%i: already registered!\n", (*servo).getId());
-                    return;
-                }
+                TRACE_ERROR(CAPI, "Unable to register servo #%i: already registered!\n", id);
+                return;
             }
-            TRACE_INFO(CAPI, "Registering servo #%i\n", (*servo).getId());
+            TRACE_INFO(CAPI, "Registering servo #%i\n", id);
 
-            // Add servo to the controller vector
+            // Add servo to the controller vector and table
             servoList.push_back(servo);
+            servoTable[id] = servo;
 
             // Mark it for an "initial read"
-            updateList.push_back((*servo).getId());
+            updateList.push_back(id);
 
             // Mark it for "sync"
-            syncList.push_back((*servo).getId());
+            syncList.push_back(id);
         }
         else
         {
@@ -256,45 +512,29 @@ void ControllerAPI::registerServo_internal(Servo *servo)
 
 void ControllerAPI::unregisterServo_internal(Servo *servo)
 {
+    int id = servo->getId();
+
     // Lock servoList
     std::lock_guard <std::mutex> lock(servoListLock);
 
-    for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end();)
-    {
-        if ((*it)->getId() == (*servo).getId())
-        {
-            servoList.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    // The registered device may be another instance using the same ID
+    Servo *registered = findServo_internal(id);
 
-    for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-    {
-        if (*it == (*servo).getId())
-        {
-            updateList.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    servoList.erase(std::remove_if(servoList.begin(), servoList.end(),
+                                   [servo, registered](Servo *s) { return (s == servo || s == registered); }),
+                    servoList.end());
 
-    for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
+    // Also clear the slot of a device that changed its ID since its last lookup
+    for (int i = 0; i < BROADCAST_ID; i++)
     {
-        if (*it == (*servo).getId())
+        if (servoTable[i] == servo || (registered != NULL && servoTable[i] == registered))
         {
-            syncList.erase(it);
-        }
-        else
-        {
-            ++it;
+            servoTable[i] = NULL;
         }
     }
 
+    unsyncServo_internal(id);
+
     if (servoList.empty() == true)
     {
         // No more device(s), nothing left to do, we set the controller state back to idle
@@ -315,6 +555,7 @@ void ControllerAPI::unregisterServos_internal()
     clearErrorCount();
 
     servoList.clear();
+    std::fill(servoTable, servoTable + BROADCAST_ID, static_cast<Servo *>(NULL));
     updateList.clear();
     syncList.clear();
 
@@ -349,15 +590,7 @@ Servo *ControllerAPI::getServo(const int id)
     // Lock servoList
     std::lock_guard <std::mutex> lock(servoListLock);
 
-    for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end(); ++it)
-    {
-        if ((*it)->getId() == id)
-        {
-            return *it;
-        }
-    }
-
-    return NULL;
+    return findServo_internal(id);
 }
 
 const std::vector <Servo *> ControllerAPI::getServos()
@@ -25,7 +25,9 @@
 
 #include "Servo.h"
 #include "Utils.h"
+#include "RegisterScheduler.h"
 
+#include <cstdint>
 #include <vector>
 #include <deque>
 #include <thread>
@@ -50,6 +52,50 @@ enum controllerState_e
     state_ready,
 };
 
+/*!
+ * \brief What the synchronization loop does after a period overrun (real-time mode only).
+ */
+enum OverrunPolicy_e
+{
+    OVERRUN_SKIP = 0,       //!< Drop the missed periods, the next cycle starts on the next period boundary
+    OVERRUN_CATCHUP = 1,    //!< Run the late cycles back to back, until the loop is on schedule again (up to SYNCLOOP_CATCHUP_MAX periods late)
+};
+
+/*!
+ * \brief Maximum number of periods the loop may lag behind with OVERRUN_CATCHUP, before dropping the missed periods anyway.
+ */
+#define SYNCLOOP_CATCHUP_MAX    (4)
+
+/*!
+ * \brief Share of each synchronization loop period that can be spent reading registers, the rest is left to the writes.
+ */
+#define SYNCLOOP_READ_SHARE     (0.6)
+
+/*!
+ * \brief Estimated time (in microseconds) of a request/answer turnaround on the serial link, on top of the bytes transfer time.
+ *
+ * Covers the adapter latency and the device return delay. Only used to
+ * estimate the cost of the register reads planned at each cycle.
+ */
+#define SYNCLOOP_TURNAROUND_US  (500)
+
+/*!
+ * \brief Real-time settings of the synchronization loop thread.
+ *
+ * Scheduling policy, CPU affinity and memory locking are only available on
+ * Linux, and usually need the CAP_SYS_NICE and CAP_IPC_LOCK capabilities (or
+ * matching rtprio and memlock limits). A setting that cannot be applied is
+ * reported with a warning, and the loop runs without it.
+ */
+struct RealTimeSettings
+{
+    bool enabled;           //!< Pace the loop on absolute deadlines from the monotonic clock, instead of sleeping for the time left in each cycle.
+    int priority;           //!< SCHED_FIFO priority of the loop thread, in [1;99], or 0 to keep the default scheduling policy.
+    int cpu;                //!< CPU the loop thread is pinned to, or -1 to let the scheduler choose.
+    bool lockMemory;        //!< Lock the process memory (mlockall) so the loop never waits on a page fault. Stays in effect for the whole process.
+    int overrunPolicy;      //!< What to do after a period overrun, using ::OverrunPolicy_e values.
+};
+
 /*!
  * \brief The ControllerAPI abstract class, root of the ManagedAPI.
  *
@@ -66,6 +112,13 @@ class ControllerAPI
     int errorCount;                     //!< Store the number of transmission errors.
     std::mutex errorCountLock;          //!< Lock for the error count.
 
+    RealTimeSettings rtSettings;        //!< Real-time settings, applied when the loop thread starts.
+    int64_t syncloopDeadline;           //!< Start of the current period (in nanosecond, monotonic clock), used by the real-time mode.
+    int64_t syncloopStartTime;          //!< Start of the current cycle (in nanosecond, monotonic clock).
+
+    unsigned overrunCount;              //!< Store the number of period overruns.
+    std::mutex realTimeLock;            //!< Lock for the real-time settings and the overrun count.
+
 protected:
 
     enum controllerMessage_e
@@ -99,14 +152,43 @@ protected:
     std::mutex m_mutex;                 //!< Lock for the message queue.
 
     std::vector <Servo *> servoList;    //!< List containing device object managed by this controller.
-    std::mutex servoListLock;           //!< Lock for the device list.
+    Servo *servoTable[BROADCAST_ID];    //!< Device objects managed by this controller, indexed by ID.
+    std::mutex servoListLock;           //!< Lock for the device list, table, and the update and sync lists.
 
     std::vector <int> updateList;       //!< List of device object marked for a "full" register update.
     std::vector <int> syncList;         //!< List of device object to keep in sync.
 
+    RegisterScheduler registerScheduler; //!< Decide which registers are read at each cycle.
+
     //! Read/write synchronization loop, running inside its own background thread
     virtual void run() = 0;
 
+    /*!
+     * \brief Prepare the synchronization loop timing, from the loop thread.
+     *
+     * Must be called by run() before its first cycle. Applies the real-time
+     * settings (scheduling policy, CPU affinity, memory locking) to the calling
+     * thread, and starts the first period.
+     */
+    void syncloopStart();
+
+    /*!
+     * \brief Wait for the next cycle of the synchronization loop.
+     *
+     * Must be called by run() at the end of each cycle. Without the real-time
+     * mode, sleeps for what is left of the cycle. With the real-time mode,
+     * sleeps until the absolute start of the next period (clock_nanosleep()
+     * on Linux), so the loop does not drift, and handles period overruns
+     * following the overrun policy.
+     */
+    void syncloopWait();
+
+    /*!
+     * \brief Get the bus time available for the register reads of one cycle.
+     * \return The read budget, in microseconds.
+     */
+    int syncloopReadBudget() const;
+
     /*!
      * \brief Internal thread messaging system.
      * \param m: A pointer to a miniMessages structure. Will be copied.
@@ -116,6 +198,23 @@ protected:
      */
     void sendMessage(miniMessages *m);
 
+    /*!
+     * \brief Find a registered device from its ID. Must be called with servoListLock held.
+     * \param id: The device ID.
+     * \return The device, or NULL if no device is registered with this ID.
+     *
+     * Lookups go through the ID-indexed table, so the cost does not depend on
+     * the number of devices. If a device changed its ID, the table is fixed
+     * on the first lookup that misses.
+     */
+    Servo *findServo_internal(const int id);
+
+    /*!
+     * \brief Remove a device from the update and sync lists. Must be called with servoListLock held.
+     * \param id: The device ID.
+     */
+    void unsyncServo_internal(const int id);
+
     void registerServo_internal(Servo *servo);
     void unregisterServo_internal(Servo *servo);
     void unregisterServos_internal();
@@ -225,6 +324,49 @@ public:
      */
     void clearErrorCount();
 
+    /*!
+     * \brief Set the real-time settings of the synchronization loop.
+     * \param settings: The new settings.
+     *
+     * The settings are applied when the loop thread starts: set them before
+     * connect(), or pause and unpause the controller to apply them.
+     */
+    void setRealTime(const RealTimeSettings &settings);
+
+    /*!
+     * \brief Get the real-time settings of the synchronization loop.
+     */
+    RealTimeSettings getRealTime();
+
+    /*!
+     * \brief Return the number of period overruns of the synchronization loop, since the thread started.
+     *
+     * An overrun is a cycle that ended after the start of the next period.
+     * Only counted with the real-time mode enabled.
+     */
+    unsigned getOverrunCount();
+
+    /*!
+     * \brief Set the refresh rate of a register, read by the synchronization loop.
+     * \param id: Device ID, or -1 to change the default rate of every device.
+     * \param reg: Register name (see ::ControlTables_e).
+     * \param rate: Target rate (in Hz). Rates higher than the loop frequency mean every cycle, 0 means never.
+     * \param priority: When the serial link cannot keep up, reads with higher priorities go first.
+     *
+     * Each controller sets default rates for its feedback registers: full rate
+     * for the position, a quarter of the loop frequency for the other motion
+     * feedbacks, and 1 Hz for voltage and temperature. For instance, a gripper
+     * can get its load at full rate, and a passive joint can get its position
+     * at only a few Hz.
+     */
+    void setRegisterRate(int id, int reg, double rate, int priority = 1);
+
+    /*!
+     * \brief Remove the refresh rates set for a device, so it uses the default rates again.
+     * \param id: Device ID, or -1 to restore the default rates of the controller.
+     */
+    void resetRegisterRates(int id);
+
     /*!
      * \brief Register a servo given in argument.
      * \param servo: A servo instance.
@@ -0,0 +1,90 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file Deadline.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#include "Deadline.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+int64_t getTimeNs()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    static LARGE_INTEGER freq = {0};
+    LARGE_INTEGER now;
+
+    if (freq.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+
+    // Split the conversion to avoid overflowing 64 bits
+    int64_t sec = now.QuadPart / freq.QuadPart;
+    int64_t rem = now.QuadPart % freq.QuadPart;
+
+    return sec * 1000000000LL + (rem * 1000000000LL) / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + static_cast<int64_t>(ts.tv_nsec);
+#endif
+}
+
+Deadline::Deadline():
+    startTime(0),
+    endTime(0)
+{
+    //
+}
+
+void Deadline::set(const int64_t duration_ns)
+{
+    startTime = getTimeNs();
+    endTime = startTime + ((duration_ns > 0) ? duration_ns : 0);
+}
+
+bool Deadline::expired() const
+{
+    return (getTimeNs() >= endTime);
+}
+
+int64_t Deadline::remaining() const
+{
+    int64_t left = endTime - getTimeNs();
+
+    return (left > 0) ? left : 0;
+}
+
+int64_t Deadline::elapsed() const
+{
+    return getTimeNs() - startTime;
+}
+
+int64_t Deadline::duration() const
+{
+    return endTime - startTime;
+}
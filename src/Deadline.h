@@ -0,0 +1,91 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file Deadline.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+// C++ standard libraries
+#include <cstdint>
+
+/** \addtogroup Tools
+ *  @{
+ */
+
+/*!
+ * \brief Get the current time from a monotonic clock.
+ * \return The current time in nanoseconds, from an arbitrary (but fixed) starting point.
+ *
+ * Uses CLOCK_MONOTONIC on Linux and Mac OS, and the performance counter on
+ * Windows. This clock is not affected by system time changes (NTP slews...).
+ */
+int64_t getTimeNs();
+
+/*!
+ * \brief The Deadline class, used to handle packet timeouts with a nanosecond resolution.
+ *
+ * A deadline is armed with a duration, then can be queried to know if it
+ * expired, how much time is left, or how much time has elapsed since it was
+ * armed. All values are integer nanoseconds from the monotonic clock, so
+ * sub-millisecond timeouts stay exact.
+ */
+class Deadline
+{
+    int64_t startTime;  //!< Time (in nanosecond) when the deadline was armed.
+    int64_t endTime;    //!< Time (in nanosecond) when the deadline expires.
+
+public:
+    Deadline();
+
+    /*!
+     * \brief Arm the deadline.
+     * \param duration_ns: Duration (in nanosecond) before the deadline expires, starting now.
+     */
+    void set(const int64_t duration_ns);
+
+    /*!
+     * \brief Check if the deadline has expired.
+     * \return True if the deadline has been reached.
+     */
+    bool expired() const;
+
+    /*!
+     * \brief Get the time left before the deadline expires.
+     * \return Time left (in nanosecond), or 0 if the deadline has already been reached.
+     */
+    int64_t remaining() const;
+
+    /*!
+     * \brief Get the time elapsed since the deadline was armed.
+     * \return Time elapsed (in nanosecond).
+     */
+    int64_t elapsed() const;
+
+    /*!
+     * \brief Get the duration the deadline was armed with.
+     * \return Duration (in nanosecond).
+     */
+    int64_t duration() const;
+};
+
+/** @}*/
+
+#endif /* DEADLINE_H */
@@ -25,6 +25,7 @@
 
 // C++ standard libraries
 #include <cstring>
+#include <algorithm>
 #include <map>
 #include <mutex>
 
@@ -95,56 +96,18 @@ enum {
 
 /* ************************************************************************** */
 
-unsigned short crc_table[256] =
-{
-    0x0000, 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
-    0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027, 0x0022,
-    0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D, 0x8077, 0x0072,
-    0x0050, 0x8055, 0x805F, 0x005A, 0x804B, 0x004E, 0x0044, 0x8041,
-    0x80C3, 0x00C6, 0x00CC, 0x80C9, 0x00D8, 0x80DD, 0x80D7, 0x00D2,
-    0x00F0, 0x80F5, 0x80FF, 0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1,
-    0x00A0, 0x80A5, 0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1,
-    0x8093, 0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
-    0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197, 0x0192,
-    0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE, 0x01A4, 0x81A1,
-    0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB, 0x01FE, 0x01F4, 0x81F1,
-    0x81D3, 0x01D6, 0x01DC, 0x81D9, 0x01C8, 0x81CD, 0x81C7, 0x01C2,
-    0x0140, 0x8145, 0x814F, 0x014A, 0x815B, 0x015E, 0x0154, 0x8151,
-    0x8173, 0x0176, 0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162,
-    0x8123, 0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
-    0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104, 0x8101,
-    0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D, 0x8317, 0x0312,
-    0x0330, 0x8335, 0x833F, 0x033A, 0x832B, 0x032E, 0x0324, 0x8321,
-    0x0360, 0x8365, 0x836F, 0x036A, 0x837B, 0x037E, 0x0374, 0x8371,
-    0x8353, 0x0356, 0x035C, 0x8359, 0x0348, 0x834D, 0x8347, 0x0342,
-    0x03C0, 0x83C5, 0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1,
-    0x83F3, 0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
-    0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7, 0x03B2,
-    0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E, 0x0384, 0x8381,
-    0x0280, 0x8285, 0x828F, 0x028A, 0x829B, 0x029E, 0x0294, 0x8291,
-    0x82B3, 0x02B6, 0x02BC, 0x82B9, 0x02A8, 0x82AD, 0x82A7, 0x02A2,
-    0x82E3, 0x02E6, 0x02EC, 0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2,
-    0x02D0, 0x82D5, 0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1,
-    0x8243, 0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
-    0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264, 0x8261,
-    0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E, 0x0234, 0x8231,
-    0x8213, 0x0216, 0x021C, 0x8219, 0x0208, 0x820D, 0x8207, 0x0202
-};
-
-/* ************************************************************************** */
-
 Dynamixel::Dynamixel():
     serial(NULL),
-    rxPacketSize(0),
-    rxPacketSizeReceived(0),
+    txPacket(txPacketBuffer),
+    txPacketCapacity(MAX_PACKET_LENGTH_dxlv1),
+    rxPacketPending(false),
     commLock(0),
     commStatus(COMM_RXSUCCESS),
     serialDevice(SERIAL_UNKNOWN),
     servoSerie(SERVO_MX),
     protocolVersion(1)
 {
-    memset(txPacket, 0, sizeof(txPacket));
-    memset(rxPacket, 0, sizeof(rxPacket));
+    memset(txPacketBuffer, 0, sizeof(txPacketBuffer));
 }
 
 Dynamixel::~Dynamixel()
@@ -161,20 +124,18 @@ int Dynamixel::serialInitialize(std::string &devicePath, const int baud)
         serialTerminate();
     }
 
-    // Instanciate a different serial subclass, depending on the current OS
-#if defined(__linux__) || defined(__gnu_linux)
-    serial = new SerialPortLinux(devicePath, baud, serialDevice, servoSerie);
-#elif defined(_WIN32) || defined(_WIN64)
-    serial = new SerialPortWindows(devicePath, baud, serialDevice, servoSerie);
-#elif defined(__APPLE__) || defined(__MACH__)
-    serial = new SerialPortMacOS(devicePath, baud, serialDevice, servoSerie);
-#else
-    #error "No compatible operating system detected!"
-#endif
+    // Instanciate the serial backend matching the device path (the OS serial port by default)
+    serial = createSerialPort(devicePath, baud, serialDevice, servoSerie);
 
     // Initialize the serial link
     if (serial != NULL)
     {
+        // Use the adapter type autodetected by the serial backend, if not specified
+        if (serialDevice == SERIAL_UNKNOWN)
+        {
+            serialDevice = serial->getSerialDevice();
+        }
+
         status = serial->openLink();
 
         if (status > 0)
@@ -200,8 +161,11 @@ void Dynamixel::serialTerminate()
         serial = NULL;
 
         // Clear incoming packet?
-        rxPacketSize = 0;
-        memset(rxPacket, 0, sizeof(rxPacket));
+        rxPacketPending = false;
+        rxParser.clear();
+
+        // Drop the packet templates built for the devices of this link
+        txPacketTemplates.clear();
     }
 }
 
@@ -221,6 +185,18 @@ std::string Dynamixel::serialGetCurrentDevice()
     return serialName;
 }
 
+int Dynamixel::serialGetBaudRate()
+{
+    int baudRate = 0;
+
+    if (serial != NULL)
+    {
+        baudRate = serial->getDeviceBaudRate();
+    }
+
+    return baudRate;
+}
+
 std::vector <std::string> Dynamixel::serialGetAvailableDevices()
 {
     std::vector <std::string> devices;
@@ -242,6 +218,31 @@ void Dynamixel::serialSetLatency(int latency)
     serial->setLatency(latency);
 }
 
+bool Dynamixel::serialSwitchHighSpeed()
+{
+    bool status = false;
+
+    if (serial != NULL)
+    {
+        status = serial->switchHighSpeed();
+    }
+
+    return status;
+}
+
+void Dynamixel::serialSetAdaptiveTimeOut(bool enabled)
+{
+    serial->setAdaptiveTimeOut(enabled);
+}
+
+void Dynamixel::serialSetTxBatching(bool enabled)
+{
+    if (serial != NULL)
+    {
+        serial->setTxBatching(enabled);
+    }
+}
+
 void Dynamixel::setAckPolicy(int ack)
 {
     if (ackPolicy >= ACK_NO_REPLY && ack <= ACK_REPLY_ALL)
@@ -254,7 +255,7 @@ void Dynamixel::setAckPolicy(int ack)
     }
 }
 
-void Dynamixel::dxl_tx_packet()
+void Dynamixel::dxl_tx_packet(bool reply, bool prebuilt)
 {
     if (serial == NULL)
     {
@@ -272,24 +273,50 @@ void Dynamixel::dxl_tx_packet()
     if (commStatus == COMM_RXTIMEOUT || commStatus == COMM_RXCORRUPT)
     {
         serial->flush();
+        rxPacketPending = false;
     }
 
-    // Make sure the packet is properly formed
-    if (dxl_validate_packet() == 0)
+    // Packets set from a template are already validated, stuffed and checksummed
+    if (prebuilt == false)
     {
-        return;
-    }
+        // Make sure the packet is properly formed
+        if (dxl_validate_packet() == 0)
+        {
+            return;
+        }
+
+        // Escape the header sequences from the packet content (protocol v2 only)
+        if (protocolVersion == 2 && dxl2_stuff_txpacket() < 0)
+        {
+            commStatus = COMM_TXERROR;
+            commLock = 0;
+            return;
+        }
 
-    // Generate a checksum and write in into the packet
-    dxl_checksum_packet();
+        // Generate a checksum and write in into the packet
+        dxl_checksum_packet();
+    }
 
     // Send packet
-    unsigned char txPacketSize = dxl_get_txpacket_size();
-    unsigned char txPacketSizeSent = 0;
+    int txPacketSize = dxl_get_txpacket_size();
+    int txPacketSizeSent = 0;
 
     if (serial != NULL)
     {
-        txPacketSizeSent = serial->tx(txPacket, txPacketSize);
+        if (serial->getTxBatching() == true)
+        {
+            // Queue the packet, and send the whole batch if we need an answer to this one
+            txPacketSizeSent = serial->txBufferPush(txPacket, txPacketSize);
+
+            if (reply == true && serial->txBufferFlush() < 0)
+            {
+                txPacketSizeSent = 0;
+            }
+        }
+        else
+        {
+            txPacketSizeSent = serial->tx(txPacket, txPacketSize);
+        }
     }
     else
     {
@@ -309,13 +336,13 @@ void Dynamixel::dxl_tx_packet()
     if (protocolVersion == 2)
     {
         // 11 is the min size of a v2 status packet
-        if (txPacket[PKT1_INSTRUCTION] == INST_READ)
+        if (txPacket[PKT2_INSTRUCTION] == INST_READ)
         {
-            serial->setTimeOut(11 + make_short_word(txPacket[PKT2_PARAMETER+2], txPacket[PKT2_PARAMETER+3]));
+            serial->setTimeOut(11 + make_short_word(txPacket[PKT2_PARAMETER+2], txPacket[PKT2_PARAMETER+3]), txPacket[PKT2_ID]);
         }
         else
         {
-            serial->setTimeOut(11);
+            serial->setTimeOut(11, txPacket[PKT2_ID]);
         }
     }
     else
@@ -323,11 +350,11 @@ void Dynamixel::dxl_tx_packet()
         // 6 is the min size of a v1 status packet
         if (txPacket[PKT1_INSTRUCTION] == INST_READ)
         {
-            serial->setTimeOut(6 + txPacket[PKT1_PARAMETER+1]);
+            serial->setTimeOut(6 + txPacket[PKT1_PARAMETER+1], txPacket[PKT1_ID]);
         }
         else
         {
-            serial->setTimeOut(6);
+            serial->setTimeOut(6, txPacket[PKT1_ID]);
         }
     }
 
@@ -357,212 +384,365 @@ void Dynamixel::dxl_rx_packet()
         return;
     }
 
-    // Minimum status packet size estimation
+    // New status packet expected: drop any partial frame
     if (commStatus == COMM_TXSUCCESS)
     {
-        // Min size with protocol v2 is 11, for v1 is 6
-        (protocolVersion == 2) ? rxPacketSize = 11 : rxPacketSize = 6;
-        rxPacketSizeReceived = 0;
+        rxParser.setProtocolVersion(protocolVersion);
+        rxParser.reset();
     }
 
-    int nRead = 0;
-    if (serial != NULL)
-    {
-        // Receive packet
-        nRead = serial->rx((unsigned char*)&rxPacket[rxPacketSizeReceived], rxPacketSize - rxPacketSizeReceived);
-        rxPacketSizeReceived += nRead;
-
-        // Check if we received the whole packet
-        if (rxPacketSizeReceived < rxPacketSize)
-        {
-            if (serial->checkTimeOut() == 1)
-            {
-                if (rxPacketSizeReceived == 0)
-                {
-                    commStatus = COMM_RXTIMEOUT;
-                }
-                else
-                {
-                    commStatus = COMM_RXCORRUPT;
-                }
+    int parserStatus = PARSER_WAITING;
 
-                commLock = 0;
-                return;
-            }
-        }
+    if (rxPacketPending == true)
+    {
+        // A status packet already received, but not from the device we were
+        // waiting for at the time (a device did not answer a SYNC_READ or a BULK_READ)
+        parserStatus = PARSER_FRAME;
+        rxPacketPending = false;
     }
     else
     {
-        TRACE_ERROR(DXL, "Serial interface has been destroyed!\n");
-        return;
+        parserStatus = dxl_rx_parse();
     }
 
-    // Find packet header
-    unsigned char i, j;
-    if (protocolVersion == 2)
+    // Incomplete packet?
+    if (parserStatus == PARSER_WAITING)
     {
-        for (i = 0; i < (rxPacketSizeReceived - 1); i++)
+        if (serial->checkTimeOut() == 1)
         {
-            if (rxPacket[i] == 0xFF &&
-                rxPacket[i+1] == 0xFF &&
-                rxPacket[i+2] == 0xFD &&
-                rxPacket[i+3] == 0x00)
-            {
-                break;
-            }
-            else if (i == (rxPacketSizeReceived - 2) &&
-                     rxPacket[rxPacketSizeReceived-1] == 0xFF)
+            if (rxParser.getProgress() == 0)
             {
-                break;
+                commStatus = COMM_RXTIMEOUT;
             }
-        }
-
-        if (i > 0)
-        {
-            for (j = 0; j < (rxPacketSizeReceived-i); j++)
+            else
             {
-                rxPacket[j] = rxPacket[j + i];
+                commStatus = COMM_RXCORRUPT;
             }
 
-            rxPacketSizeReceived -= i;
+            commLock = 0;
         }
-    }
-    else
-    {
-        for (i = 0; i < (rxPacketSizeReceived - 1); i++)
+        else
         {
-            if (rxPacket[i] == 0xFF &&
-                rxPacket[i+1] == 0xFF)
-            {
-                break;
-            }
-            else if (i == (rxPacketSizeReceived - 2) &&
-                     rxPacket[rxPacketSizeReceived-1] == 0xFF)
-            {
-                break;
-            }
+            commStatus = COMM_RXWAITING;
         }
 
-        if (i > 0)
-        {
-            for (j = 0; j < (rxPacketSizeReceived-i); j++)
-            {
-                rxPacket[j] = rxPacket[j + i];
-            }
-
-            rxPacketSizeReceived -= i;
-        }
+        return;
     }
 
-    // Incomplete packet?
-    if (rxPacketSizeReceived < rxPacketSize)
+    // Invalid length or checksum?
+    if (parserStatus == PARSER_CORRUPT)
     {
-        commStatus = COMM_RXWAITING;
+        commStatus = COMM_RXCORRUPT;
+        commLock = 0;
         return;
     }
 
     // Check ID pairing
-    if (((protocolVersion == 1) && (txPacket[PKT1_ID] != rxPacket[PKT1_ID])) ||
-        ((protocolVersion == 2) && (txPacket[PKT2_ID] != rxPacket[PKT2_ID])))
+    if (((protocolVersion == 1) && (txPacket[PKT1_ID] != rxParser.getFrame()[PKT1_ID])) ||
+        ((protocolVersion == 2) && (txPacket[PKT2_ID] != rxParser.getFrame()[PKT2_ID])))
     {
+        rxPacketPending = true;
         commStatus = COMM_RXCORRUPT;
         commLock = 0;
         return;
     }
 
-    // Rx packet size
-    rxPacketSize = dxl_get_rxpacket_size();
+    commStatus = COMM_RXSUCCESS;
+    commLock = 0;
+}
+
+int Dynamixel::dxl_rx_parse()
+{
+    int parserStatus = PARSER_WAITING;
+    const unsigned char *data = NULL;
+    int available = 0;
+
+    // Receive everything available on the serial link
+    serial->rxBufferFill();
 
-    if (rxPacketSizeReceived < rxPacketSize)
+    // Feed the parser, up to the end of the first frame. Any following byte
+    // stays in the receive buffer.
+    while (parserStatus == PARSER_WAITING && (available = serial->rxBufferPeekBlock(data)) > 0)
     {
-        nRead = serial->rx(&rxPacket[rxPacketSizeReceived], rxPacketSize - rxPacketSizeReceived);
-        rxPacketSizeReceived += nRead;
+        int consumed = 0;
+        parserStatus = rxParser.parse(data, available, consumed);
+        serial->rxBufferDrop(consumed);
+    }
+
+    return parserStatus;
+}
+
+void Dynamixel::dxl_rx_broadcast_status(const int id, const int statusSize)
+{
+    // Match the status packet with its device by pretending we addressed it directly
+    dxl_set_txpacket_id(id);
+    serial->setTimeOut(statusSize, id);
+    commStatus = COMM_TXSUCCESS;
+    commLock = 1;
+
+    do {
+        dxl_rx_packet();
 
-        if (rxPacketSizeReceived < rxPacketSize)
+        if (commStatus == COMM_RXWAITING)
         {
-            commStatus = COMM_RXWAITING;
-            return;
+            serial->waitData();
+        }
+    }
+    while (commStatus == COMM_RXWAITING);
+
+    serial->updateLatency(commStatus);
+}
+
+void Dynamixel::dxl_reserve_txpacket(const int size)
+{
+    if (size <= txPacketCapacity)
+    {
+        return;
+    }
+
+    // Grow the pool geometrically, so a series of increasing sizes only allocates a few times
+    txPacketPool.resize(std::max(static_cast<size_t>(size), txPacketPool.size() * 2));
+
+    if (txPacket == txPacketBuffer)
+    {
+        memcpy(txPacketPool.data(), txPacketBuffer, txPacketCapacity);
+    }
+
+    txPacket = txPacketPool.data();
+    txPacketCapacity = static_cast<int>(txPacketPool.size());
+}
+
+int Dynamixel::dxl2_stuff_txpacket()
+{
+    int lengthField = dxl_get_txpacket_length_field();
+    int end = PKT2_INSTRUCTION + lengthField - 2; // the CRC is not stuffed
+    int count = 0;
+
+    // Count the sequences to escape (they cannot overlap)
+    for (int i = PKT2_INSTRUCTION + 2; i < end; i++)
+    {
+        if (txPacket[i] == 0xFD && txPacket[i-1] == 0xFF && txPacket[i-2] == 0xFF)
+        {
+            count++;
+        }
+    }
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    if (lengthField + count > 0xFFFF)
+    {
+        TRACE_ERROR(DXL, "Packet too large after byte stuffing (length: %i)\n", lengthField + count);
+        return -1;
+    }
+
+    dxl_reserve_txpacket(end + count + 2);
+
+    // Move the bytes from the end of the packet, adding a 0xFD after each sequence.
+    // The bytes read are never overwritten before being moved.
+    int in = end - 1;
+    int out = end - 1 + count;
+
+    while (out != in)
+    {
+        if (txPacket[in] == 0xFD && txPacket[in-1] == 0xFF && txPacket[in-2] == 0xFF)
+        {
+            txPacket[out--] = 0xFD;
+        }
+        txPacket[out--] = txPacket[in--];
+    }
+
+    dxl_set_txpacket_length_field(lengthField + count);
+
+    return count;
+}
+
+/*!
+ * \brief Check if a protocol v2 packet has a 0xFF 0xFF 0xFD sequence ending in a given range.
+ * \param packet: The packet.
+ * \param begin: Index of the first byte to check (at least PKT2_INSTRUCTION + 2).
+ * \param end: Index of the byte after the last one to check.
+ * \return True if byte stuffing is needed.
+ */
+static bool dxl2_stuffing_needed(const unsigned char *packet, const int begin, const int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        if (packet[i] == 0xFD && packet[i-1] == 0xFF && packet[i-2] == 0xFF)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Dynamixel::dxl_set_txpacket_template(const int id, const int instruction, const int address, const int length, const unsigned char *payload)
+{
+    const int payloadSize = (instruction == INST_WRITE) ? length : 0;
+    const int checksumSize = (protocolVersion == 2) ? 2 : 1;
+
+    uint64_t key = (static_cast<uint64_t>(protocolVersion) << 56) |
+                   (static_cast<uint64_t>(address & 0xFFFF) << 32) |
+                   (static_cast<uint64_t>(length & 0xFFFF) << 16) |
+                   (static_cast<uint64_t>(instruction & 0xFF) << 8) |
+                   static_cast<uint64_t>(id & 0xFF);
+
+    std::map <uint64_t, PacketTemplate>::iterator it = txPacketTemplates.find(key);
+
+    if (it == txPacketTemplates.end())
+    {
+        // Build the packet, with an empty payload
+        int param = 0;
+        dxl_set_txpacket_id(id);
+        dxl_set_txpacket_instruction(instruction);
+        dxl_set_txpacket_parameter(param++, get_lowbyte(address));
+        if (protocolVersion == 2)
+        {
+            dxl_set_txpacket_parameter(param++, get_highbyte(address));
+        }
+        if (instruction == INST_READ)
+        {
+            dxl_set_txpacket_parameter(param++, get_lowbyte(length));
+            if (protocolVersion == 2)
+            {
+                dxl_set_txpacket_parameter(param++, get_highbyte(length));
+            }
+        }
+        for (int i = 0; i < payloadSize; i++)
+        {
+            dxl_set_txpacket_parameter(param++, 0);
+        }
+        dxl_set_txpacket_length_field(param + ((protocolVersion == 2) ? 3 : 2));
+
+        int packetSize = dxl_get_txpacket_size();
+
+        // Uncommon packet? Let the regular path handle (or reject) it
+        if (packetSize > PACKET_TEMPLATE_SIZE || dxl_validate_packet() == 0 ||
+            (protocolVersion == 2 && dxl2_stuffing_needed(txPacket, PKT2_INSTRUCTION + 2, packetSize - 2)))
+        {
+            for (int i = 0; i < payloadSize; i++)
+            {
+                txPacket[packetSize - checksumSize - payloadSize + i] = payload[i];
+            }
+
+            return false;
         }
+
+        dxl_checksum_packet();
+
+        PacketTemplate t;
+        memcpy(t.packet, txPacket, packetSize);
+        t.packetSize = packetSize;
+        t.payloadOffset = packetSize - checksumSize - payloadSize;
+        t.payloadSize = payloadSize;
+
+        it = txPacketTemplates.insert(std::make_pair(key, t)).first;
     }
 
-    // Generate a checksum of the incoming packet
+    PacketTemplate &t = it->second;
+    unsigned char *data = &t.packet[t.payloadOffset];
+
+    // Patch the payload, and update the checksum with the bytes that changed
     if (protocolVersion == 2)
     {
-        unsigned short crc = dxl2_checksum_packet(rxPacket, rxPacketSize);
+        // The CRC is linear: the CRC of the changes (the payload ends the CRCed
+        // data, so nothing follows them) is the difference between both CRCs
+        unsigned char delta[PACKET_TEMPLATE_SIZE];
+        bool changed = false;
 
-        // Compare it with the internal packet checksum
-        if (rxPacket[rxPacketSize - 2] != get_lowbyte(crc) &&
-            rxPacket[rxPacketSize - 1] != get_highbyte(crc))
+        for (int i = 0; i < t.payloadSize; i++)
         {
-            commStatus = COMM_RXCORRUPT;
-            commLock = 0;
-            return;
+            delta[i] = data[i] ^ payload[i];
+            changed |= (delta[i] != 0);
+            data[i] = payload[i];
+        }
+
+        if (changed == true)
+        {
+            unsigned short crc = static_cast<unsigned short>(make_short_word(t.packet[t.packetSize - 2], t.packet[t.packetSize - 1]));
+            crc ^= dxl2_crc16(0, delta, t.payloadSize);
+            t.packet[t.packetSize - 2] = get_lowbyte(crc);
+            t.packet[t.packetSize - 1] = get_highbyte(crc);
         }
     }
     else
     {
-        unsigned char checksum = dxl1_checksum_packet(rxPacket, dxl_get_rxpacket_length_field());
+        // The checksum is the complement of the sum: remove the differences from it
+        unsigned char checksum = t.packet[t.packetSize - 1];
 
-        // Compare it with the internal packet checksum
-        if (rxPacket[rxPacketSize - 1] != checksum)
+        for (int i = 0; i < t.payloadSize; i++)
         {
-            commStatus = COMM_RXCORRUPT;
-            commLock = 0;
-            return;
+            checksum -= static_cast<unsigned char>(payload[i] - data[i]);
+            data[i] = payload[i];
         }
+
+        t.packet[t.packetSize - 1] = checksum;
     }
 
-    commStatus = COMM_RXSUCCESS;
-    commLock = 0;
+    memcpy(txPacket, t.packet, t.packetSize);
+
+    // The new payload may need stuffing, the template itself stays valid
+    if (protocolVersion == 2 && t.payloadSize > 0 &&
+        dxl2_stuffing_needed(txPacket, t.payloadOffset, t.payloadOffset + t.payloadSize))
+    {
+        return false;
+    }
+
+    return true;
 }
 
-void Dynamixel::dxl_txrx_packet(int ack)
+void Dynamixel::dxl_txrx_packet(int ack, bool prebuilt)
 {
 #ifdef LATENCY_TIMER
     // Latency timer for a complete transaction (instruction sent and status received)
-    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
-    start = std::chrono::high_resolution_clock::now();
+    int64_t start = getTimeNs();
 #endif
 
-    dxl_tx_packet();
+    // Depending on 'ackPolicy' value and current instruction, we wait for an answer to the packet we send
+    if (ack == ACK_DEFAULT)
+    {
+        ack = ackPolicy;
+    }
 
-    if (commStatus != COMM_TXSUCCESS)
+    int cmd = 0;
+    if (protocolVersion == 2)
     {
-        TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'\n", serialGetCurrentDevice().c_str());
-        return;
+        cmd = txPacket[PKT2_INSTRUCTION];
+    }
+    else
+    {
+        cmd = txPacket[PKT1_INSTRUCTION];
     }
 
-    // Depending on 'ackPolicy' value and current instruction, we wait for an answer to the packet we just sent
-    if (ack == ACK_DEFAULT)
+    bool reply = ((ack == ACK_REPLY_ALL) ||
+                  (ack == ACK_REPLY_READ && cmd == INST_READ));
+
+    dxl_tx_packet(reply, prebuilt);
+
+    if (commStatus != COMM_TXSUCCESS)
     {
-        ack = ackPolicy;
+        TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'\n", serialGetCurrentDevice().c_str());
+        return;
     }
 
-    if (ack != ACK_NO_REPLY)
+    if (reply == true)
     {
-        int cmd = 0;
-        if (protocolVersion == 2)
-        {
-            cmd = txPacket[PKT2_INSTRUCTION];
-        }
-        else
-        {
-            cmd = txPacket[PKT1_INSTRUCTION];
-        }
+        do {
+            dxl_rx_packet();
 
-        if ((ack == ACK_REPLY_ALL) ||
-            (ack == ACK_REPLY_READ && cmd == INST_READ))
-        {
-            do {
-                dxl_rx_packet();
+            // Sleep until more bytes arrive (or the timeout is reached) instead of spinning on rx()
+            if (commStatus == COMM_RXWAITING)
+            {
+                serial->waitData();
             }
-            while (commStatus == COMM_RXWAITING);
-        }
-        else
-        {
-            commStatus = COMM_RXSUCCESS;
-            commLock = 0;
         }
+        while (commStatus == COMM_RXWAITING);
+
+        // Feed the adaptive timeout of this device
+        serial->updateLatency(commStatus);
     }
     else
     {
@@ -576,8 +756,7 @@ void Dynamixel::dxl_txrx_packet(int ack)
 #endif
 
 #ifdef LATENCY_TIMER
-    end = std::chrono::high_resolution_clock::now();
-    int loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+    int loopd = static_cast<int>((getTimeNs() - start) / 1000);
     TRACE_1(DXL, "TX > RX loop: %iµs\n", loopd);
 #endif
 }
@@ -683,16 +862,13 @@ unsigned char Dynamixel::dxl1_checksum_packet(unsigned char *packetData, const i
 
 unsigned short Dynamixel::dxl2_checksum_packet(unsigned char *packetData, const int packetSize)
 {
-    unsigned short crc = 0;
-    unsigned short i = 0, j = 0;
-
-    for(j = 0; j < (packetSize - 2); j++) // 'size - 2': do not CRC16 the CRC fields!
-    {
-        i = ((crc >> 8) ^ *packetData++) & 0xFF;
-        crc = (crc << 8) ^ crc_table[i];
-    }
+    // 'size - 2': do not CRC16 the CRC fields!
+    return dxl2_crc16(0, packetData, packetSize - 2);
+}
 
-    return crc;
+int Dynamixel::dxl_get_max_packet_size()
+{
+    return (protocolVersion == 2) ? MAX_PACKET_LENGTH_dxlv2 : MAX_PACKET_LENGTH_dxlv1;
 }
 
 int Dynamixel::dxl_get_txpacket_length_field()
@@ -763,7 +939,9 @@ int Dynamixel::dxl1_validate_packet()
         txPacket[PKT1_INSTRUCTION] != INST_WRITE &&
         txPacket[PKT1_INSTRUCTION] != INST_REG_WRITE &&
         txPacket[PKT1_INSTRUCTION] != INST_ACTION &&
-        txPacket[PKT1_INSTRUCTION] != INST_SYNC_READ)
+        txPacket[PKT1_INSTRUCTION] != INST_SYNC_READ &&
+        txPacket[PKT1_INSTRUCTION] != INST_SYNC_WRITE &&
+        txPacket[PKT1_INSTRUCTION] != INST_BULK_READ)
     {
         commStatus = COMM_TXERROR;
         commLock = 0;
@@ -819,11 +997,11 @@ int Dynamixel::dxl_get_rxpacket_error()
 
     if (protocolVersion == 2)
     {
-        status = (rxPacket[PKT2_ERROR] & 0xFD);
+        status = (rxParser.getFrame()[PKT2_ERROR] & 0xFD);
     }
     else
     {
-        status = (rxPacket[PKT1_ERRBIT] & 0xFD);
+        status = (rxParser.getFrame()[PKT1_ERRBIT] & 0xFD);
     }
 
     return status;
@@ -853,11 +1031,11 @@ int Dynamixel::dxl_get_rxpacket_length_field()
 
     if (protocolVersion == 2)
     {
-        size = make_short_word(rxPacket[PKT2_LENGTH_L], rxPacket[PKT2_LENGTH_H]);
+        size = make_short_word(rxParser.getFrame()[PKT2_LENGTH_L], rxParser.getFrame()[PKT2_LENGTH_H]);
     }
     else
     {
-        size = static_cast<int>(rxPacket[PKT1_LENGTH]);
+        size = static_cast<int>(rxParser.getFrame()[PKT1_LENGTH]);
     }
 
     return size;
@@ -870,11 +1048,11 @@ int Dynamixel::dxl_get_rxpacket_parameter(int index)
     if (protocolVersion == 2)
     {
         // +1 represent the error field integrated
-        value = static_cast<int>(rxPacket[PKT2_PARAMETER + 1 + index]);
+        value = static_cast<int>(rxParser.getFrame()[PKT2_PARAMETER + 1 + index]);
     }
     else
     {
-        value = static_cast<int>(rxPacket[PKT1_PARAMETER + index]);
+        value = static_cast<int>(rxParser.getFrame()[PKT1_PARAMETER + index]);
     }
 
     return value;
@@ -887,11 +1065,11 @@ int Dynamixel::dxl_get_last_packet_id()
     // We want to use the ID of the last status packet received through the serial link
     if (protocolVersion == 2)
     {
-        id = (rxPacket[PKT2_ID]);
+        id = (rxParser.getFrame()[PKT2_ID]);
     }
     else
     {
-        id = (rxPacket[PKT1_ID]);
+        id = (rxParser.getFrame()[PKT1_ID]);
     }
 
     // In case no status packet has been received (ex: RX timeout) we try to use the ID from the last packet sent
@@ -1034,6 +1212,9 @@ int Dynamixel::dxl_print_error()
 
 void Dynamixel::printRxPacket()
 {
+    const unsigned char *rxPacket = rxParser.getFrame();
+    int rxPacketSize = rxParser.getFrameSize();
+
     printf("Packet recv [ ");
     if (protocolVersion == 2)
     {
@@ -1128,8 +1309,8 @@ bool Dynamixel::dxl_ping(const int id, PingResponse *status, const int ack)
         {
             if (protocolVersion == 2)
             {
-                status->model_number = make_short_word(rxPacket[PKT2_PARAMETER+1], rxPacket[PKT2_PARAMETER+2]);
-                status->firmware_version = rxPacket[PKT2_PARAMETER+3];
+                status->model_number = make_short_word(rxParser.getFrame()[PKT2_PARAMETER+1], rxParser.getFrame()[PKT2_PARAMETER+2]);
+                status->firmware_version = rxParser.getFrame()[PKT2_PARAMETER+3];
             }
             else
             {
@@ -1143,21 +1324,177 @@ bool Dynamixel::dxl_ping(const int id, PingResponse *status, const int ack)
     return retcode;
 }
 
-void Dynamixel::dxl_reset(const int id, int setting, const int ack)
+int Dynamixel::dxl_ping_broadcast(std::vector <int> &ids, std::vector <PingResponse> &status, const int maxId)
 {
-    while(commLock);
+    ids.clear();
+    status.clear();
 
-    if (protocolVersion == 2)
+    if (protocolVersion != 2)
     {
-        if (setting != RESET_ALL &&
-            setting != RESET_ALL_EXCEPT_ID &&
-            setting != RESET_ALL_EXCEPT_ID_BAUDRATE)
-        {
-            setting = 0xFF;
-        }
+        TRACE_ERROR(DXL, "Broadcast PING is only available with protocol v2\n");
+        return 0;
+    }
 
-        txPacket[PKT2_ID] = get_lowbyte(id);
-        txPacket[PKT2_INSTRUCTION] = INST_FACTORY_RESET;
+    if (serial == NULL)
+    {
+        TRACE_ERROR(DXL, "Serial port not available!\n");
+        return 0;
+    }
+
+    const int lastId = (maxId >= 0 && maxId < BROADCAST_ID) ? maxId : BROADCAST_ID - 1;
+
+    // Every device waits for the ones with a lower ID before answering, so each
+    // possible ID gets a slot of one 14 bytes status packet plus its return delay
+    const double byteTime = 10000.0 / static_cast<double>(std::max(serialGetBaudRate(), 1)); // ms
+    const double slotTime = 14.0 * byteTime + 3.0; // ms
+    const double latencyTime = 2.0 * static_cast<double>(serial->getLatency()); // ms
+
+    while(commLock);
+
+    txPacket[PKT2_ID] = BROADCAST_ID;
+    txPacket[PKT2_INSTRUCTION] = INST_PING;
+    txPacket[PKT2_LENGTH_L] = 3;
+    txPacket[PKT2_LENGTH_H] = 0;
+
+    dxl_tx_packet(true);
+
+    if (commStatus != COMM_TXSUCCESS)
+    {
+        TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'\n", serialGetCurrentDevice().c_str());
+        return 0;
+    }
+
+    // Worst-case window: every slot up to the last ID we are interested in
+    serial->setTimeOut(static_cast<double>(lastId + 1) * slotTime + latencyTime);
+    rxParser.setProtocolVersion(protocolVersion);
+    rxParser.reset();
+    rxPacketPending = false;
+    bool lastPacket = false;
+
+    while (true)
+    {
+        int parserStatus = dxl_rx_parse();
+
+        if (parserStatus == PARSER_FRAME)
+        {
+            const unsigned char *rxPacket = rxParser.getFrame();
+
+            // Keep the valid PING status packets only
+            if (rxParser.getFrameSize() == 14 && rxPacket[PKT2_INSTRUCTION] == INST_STATUS &&
+                std::find(ids.begin(), ids.end(), rxPacket[PKT2_ID]) == ids.end())
+            {
+                const int id = rxPacket[PKT2_ID];
+
+                PingResponse ping;
+                ping.model_number = make_short_word(rxPacket[PKT2_PARAMETER+1], rxPacket[PKT2_PARAMETER+2]);
+                ping.firmware_version = rxPacket[PKT2_PARAMETER+3];
+
+                ids.push_back(id);
+                status.push_back(ping);
+
+                // Nothing can answer after the last slot
+                if (id >= lastId)
+                {
+                    break;
+                }
+
+                // Only the slots after this device are left to wait for
+                serial->setTimeOut(static_cast<double>(lastId - id) * slotTime + latencyTime);
+            }
+        }
+
+        // After a frame (valid or not), the following status packets may
+        // already be in the receive buffer: parse them before waiting
+        if (parserStatus != PARSER_WAITING && serial->rxBufferAvailable() > 0)
+        {
+            continue;
+        }
+
+        if (serial->checkTimeOut() == 1)
+        {
+            // Let a status packet already on the wire complete (once), stop
+            // right away if the bus is idle
+            if (rxParser.getProgress() > 0 && lastPacket == false)
+            {
+                serial->setTimeOut(14.0 * byteTime + latencyTime);
+                lastPacket = true;
+            }
+            else
+            {
+                break;
+            }
+        }
+        else
+        {
+            serial->waitData();
+        }
+    }
+
+    commStatus = ids.empty() ? COMM_RXTIMEOUT : COMM_RXSUCCESS;
+    commLock = 0;
+
+    return static_cast<int>(ids.size());
+}
+
+int Dynamixel::dxl_scan(const int start, const int stop, std::vector <int> &ids, std::vector <PingResponse> &status)
+{
+    ids.clear();
+    status.clear();
+
+    if (protocolVersion == 2)
+    {
+        // A single broadcast ping gets an answer from every device on the bus
+        std::vector <int> allIds;
+        std::vector <PingResponse> allPings;
+
+        dxl_ping_broadcast(allIds, allPings, stop);
+
+        for (size_t i = 0; i < allIds.size(); i++)
+        {
+            if (allIds.at(i) >= start && allIds.at(i) <= stop)
+            {
+                ids.push_back(allIds.at(i));
+                status.push_back(allPings.at(i));
+            }
+        }
+    }
+    else
+    {
+        for (int id = start; id <= stop; id++)
+        {
+            PingResponse pingstats;
+
+            // If the ping gets a response, then we have found a servo
+            if (dxl_ping(id, &pingstats) == true)
+            {
+                ids.push_back(id);
+                status.push_back(pingstats);
+            }
+            else
+            {
+                printf(".");
+            }
+        }
+    }
+
+    return static_cast<int>(ids.size());
+}
+
+void Dynamixel::dxl_reset(const int id, int setting, const int ack)
+{
+    while(commLock);
+
+    if (protocolVersion == 2)
+    {
+        if (setting != RESET_ALL &&
+            setting != RESET_ALL_EXCEPT_ID &&
+            setting != RESET_ALL_EXCEPT_ID_BAUDRATE)
+        {
+            setting = 0xFF;
+        }
+
+        txPacket[PKT2_ID] = get_lowbyte(id);
+        txPacket[PKT2_INSTRUCTION] = INST_FACTORY_RESET;
         txPacket[PKT2_PARAMETER] = setting;
         txPacket[PKT2_LENGTH_L] = 3;
         txPacket[PKT2_LENGTH_H] = 0;
@@ -1213,6 +1550,43 @@ void Dynamixel::dxl_action(const int id, const int ack)
     dxl_txrx_packet(ack);
 }
 
+void Dynamixel::dxl_reg_write(const int id, const int address, const int length, const unsigned char *data, const int ack)
+{
+    if (data == NULL || length < 1 || length > 8)
+    {
+        TRACE_ERROR(DXL, "Error! Invalid 'Reg write' length: %i\n", length);
+        return;
+    }
+
+    while(commLock);
+
+    if (protocolVersion == 2)
+    {
+        txPacket[PKT2_ID] = get_lowbyte(id);
+        txPacket[PKT2_INSTRUCTION] = INST_REG_WRITE;
+        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
+        for (int i = 0; i < length; i++)
+        {
+            txPacket[PKT2_PARAMETER+2+i] = data[i];
+        }
+        dxl_set_txpacket_length_field(length + 5);
+    }
+    else
+    {
+        txPacket[PKT1_ID] = get_lowbyte(id);
+        txPacket[PKT1_INSTRUCTION] = INST_REG_WRITE;
+        txPacket[PKT1_PARAMETER] = get_lowbyte(address);
+        for (int i = 0; i < length; i++)
+        {
+            txPacket[PKT1_PARAMETER+1+i] = data[i];
+        }
+        dxl_set_txpacket_length_field(length + 3);
+    }
+
+    dxl_txrx_packet(ack);
+}
+
 int Dynamixel::dxl_read_byte(const int id, const int address, const int ack)
 {
     int value = -1;
@@ -1229,27 +1603,9 @@ int Dynamixel::dxl_read_byte(const int id, const int address, const int ack)
     {
         while(commLock);
 
-        if (protocolVersion == 2)
-        {
-            txPacket[PKT2_ID] = get_lowbyte(id);
-            txPacket[PKT2_INSTRUCTION] = INST_READ;
-            txPacket[PKT2_PARAMETER] = get_lowbyte(address);
-            txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
-            txPacket[PKT2_PARAMETER+2] = 1;
-            txPacket[PKT2_PARAMETER+3] = 0;
-            txPacket[PKT2_LENGTH_L] = 7;
-            txPacket[PKT2_LENGTH_H] = 0;
-        }
-        else
-        {
-            txPacket[PKT1_ID] = get_lowbyte(id);
-            txPacket[PKT1_INSTRUCTION] = INST_READ;
-            txPacket[PKT1_PARAMETER] = get_lowbyte(address);
-            txPacket[PKT1_PARAMETER+1] = 1;
-            txPacket[PKT1_LENGTH] = 4;
-        }
+        bool prebuilt = dxl_set_txpacket_template(id, INST_READ, address, 1, NULL);
 
-        dxl_txrx_packet(ack);
+        dxl_txrx_packet(ack, prebuilt);
 
         if ((ack == ACK_DEFAULT && ackPolicy > ACK_NO_REPLY) ||
             (ack > ACK_NO_REPLY))
@@ -1258,11 +1614,11 @@ int Dynamixel::dxl_read_byte(const int id, const int address, const int ack)
             {
                 if (protocolVersion == 2)
                 {
-                    value = static_cast<int>(rxPacket[PKT2_PARAMETER+1]);
+                    value = static_cast<int>(rxParser.getFrame()[PKT2_PARAMETER+1]);
                 }
                 else
                 {
-                    value = static_cast<int>(rxPacket[PKT1_PARAMETER]);
+                    value = static_cast<int>(rxParser.getFrame()[PKT1_PARAMETER]);
                 }
             }
             else
@@ -1279,26 +1635,10 @@ void Dynamixel::dxl_write_byte(const int id, const int address, const int value,
 {
     while(commLock);
 
-    if (protocolVersion == 2)
-    {
-        txPacket[PKT2_ID] = get_lowbyte(id);
-        txPacket[PKT2_INSTRUCTION] = INST_WRITE;
-        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
-        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
-        txPacket[PKT2_PARAMETER+2] = get_lowbyte(value);
-        txPacket[PKT2_LENGTH_L] = 6;
-        txPacket[PKT2_LENGTH_H] = 0;
-    }
-    else
-    {
-        txPacket[PKT1_ID] = get_lowbyte(id);
-        txPacket[PKT1_INSTRUCTION] = INST_WRITE;
-        txPacket[PKT1_PARAMETER] = get_lowbyte(address);
-        txPacket[PKT1_PARAMETER+1] = get_lowbyte(value);
-        txPacket[PKT1_LENGTH] = 4;
-    }
+    unsigned char payload[1] = {get_lowbyte(value)};
+    bool prebuilt = dxl_set_txpacket_template(id, INST_WRITE, address, 1, payload);
 
-    dxl_txrx_packet(ack);
+    dxl_txrx_packet(ack, prebuilt);
 }
 
 int Dynamixel::dxl_read_word(const int id, const int address, const int ack)
@@ -1317,27 +1657,9 @@ int Dynamixel::dxl_read_word(const int id, const int address, const int ack)
     {
         while(commLock);
 
-        if (protocolVersion == 2)
-        {
-            txPacket[PKT2_ID] = get_lowbyte(id);
-            txPacket[PKT2_INSTRUCTION] = INST_READ;
-            txPacket[PKT2_PARAMETER] = get_lowbyte(address);
-            txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
-            txPacket[PKT2_PARAMETER+2] = 2;
-            txPacket[PKT2_PARAMETER+3] = 0;
-            txPacket[PKT2_LENGTH_L] = 7;
-            txPacket[PKT2_LENGTH_H] = 0;
-        }
-        else
-        {
-            txPacket[PKT1_ID] = get_lowbyte(id);
-            txPacket[PKT1_INSTRUCTION] = INST_READ;
-            txPacket[PKT1_PARAMETER] = get_lowbyte(address);
-            txPacket[PKT1_PARAMETER+1] = 2;
-            txPacket[PKT1_LENGTH] = 4;
-        }
+        bool prebuilt = dxl_set_txpacket_template(id, INST_READ, address, 2, NULL);
 
-        dxl_txrx_packet(ack);
+        dxl_txrx_packet(ack, prebuilt);
 
         if ((ack == ACK_DEFAULT && ackPolicy > ACK_NO_REPLY) ||
             (ack > ACK_NO_REPLY))
@@ -1346,11 +1668,11 @@ int Dynamixel::dxl_read_word(const int id, const int address, const int ack)
             {
                 if (protocolVersion == 2)
                 {
-                    value = make_short_word(rxPacket[PKT2_PARAMETER+1], rxPacket[PKT2_PARAMETER+2]);
+                    value = make_short_word(rxParser.getFrame()[PKT2_PARAMETER+1], rxParser.getFrame()[PKT2_PARAMETER+2]);
                 }
                 else
                 {
-                    value = make_short_word(rxPacket[PKT1_PARAMETER], rxPacket[PKT1_PARAMETER+1]);
+                    value = make_short_word(rxParser.getFrame()[PKT1_PARAMETER], rxParser.getFrame()[PKT1_PARAMETER+1]);
                 }
             }
             else
@@ -1363,30 +1685,399 @@ int Dynamixel::dxl_read_word(const int id, const int address, const int ack)
     return value;
 }
 
+int Dynamixel::dxl_read(const int id, const int address, const int length, unsigned char *data, const int ack)
+{
+    int status = -1;
+    int overhead = (protocolVersion == 2) ? 11 : 6;
+
+    if (id == 254)
+    {
+        TRACE_ERROR(DXL, "Error! Cannot send 'Read' instruction to broadcast address!\n");
+    }
+    else if (ack == ACK_NO_REPLY)
+    {
+        TRACE_ERROR(DXL, "Error! Cannot send 'Read' instruction if ACK_NO_REPLY is set!\n");
+    }
+    else if (data == NULL || length < 1 || (overhead + length) > dxl_get_max_packet_size())
+    {
+        TRACE_ERROR(DXL, "Error! Invalid 'Read' length: %i\n", length);
+    }
+    else
+    {
+        while(commLock);
+
+        bool prebuilt = dxl_set_txpacket_template(id, INST_READ, address, length, NULL);
+
+        dxl_txrx_packet(ack, prebuilt);
+
+        if (commStatus == COMM_RXSUCCESS)
+        {
+            if (dxl_get_rxpacket_size() == overhead + length)
+            {
+                for (int i = 0; i < length; i++)
+                {
+                    data[i] = static_cast<unsigned char>(dxl_get_rxpacket_parameter(i));
+                }
+                status = length;
+            }
+            else
+            {
+                status = COMM_RXCORRUPT;
+            }
+        }
+        else
+        {
+            status = commStatus;
+        }
+    }
+
+    return status;
+}
+
 void Dynamixel::dxl_write_word(const int id, const int address, const int value, const int ack)
 {
     while(commLock);
 
-    if (protocolVersion == 2)
+    unsigned char payload[2] = {get_lowbyte(value), get_highbyte(value)};
+    bool prebuilt = dxl_set_txpacket_template(id, INST_WRITE, address, 2, payload);
+
+    dxl_txrx_packet(ack, prebuilt);
+}
+
+void Dynamixel::dxl_sync_write(const std::vector <int> &ids, const int address, const int size, const std::vector <int> &values)
+{
+    if (ids.empty() == true || ids.size() != values.size() || size < 1 || size > 4)
     {
-        txPacket[PKT2_ID] = get_lowbyte(id);
-        txPacket[PKT2_INSTRUCTION] = INST_WRITE;
-        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
-        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
-        txPacket[PKT2_PARAMETER+2] = get_lowbyte(value);
-        txPacket[PKT2_PARAMETER+3] = get_highbyte(value);
-        txPacket[PKT2_LENGTH_L] = 7;
-        txPacket[PKT2_LENGTH_H] = 0;
+        TRACE_ERROR(DXL, "Invalid SYNC_WRITE parameters (%zu ids / %zu values / size %i)\n", ids.size(), values.size(), size);
+        return;
     }
-    else
+
+    // Each device gets a block made of its ID followed by 'size' bytes of data.
+    // The instruction is split if all the blocks do not fit in a single packet.
+    int overhead = (protocolVersion == 2) ? (PKT2_PARAMETER + 4 + 2) : (PKT1_PARAMETER + 2 + 1);
+    size_t blocksPerPacket = static_cast<size_t>((dxl_get_max_packet_size() - overhead) / (size + 1));
+
+    for (size_t first = 0; first < ids.size(); first += blocksPerPacket)
     {
-        txPacket[PKT1_ID] = get_lowbyte(id);
-        txPacket[PKT1_INSTRUCTION] = INST_WRITE;
-        txPacket[PKT1_PARAMETER] = get_lowbyte(address);
-        txPacket[PKT1_PARAMETER+1] = get_lowbyte(value);
-        txPacket[PKT1_PARAMETER+2] = get_highbyte(value);
-        txPacket[PKT1_LENGTH] = 5;
+        size_t last = std::min(ids.size(), first + blocksPerPacket);
+
+        while(commLock);
+
+        dxl_reserve_txpacket(overhead + static_cast<int>(last - first) * (size + 1));
+
+        int param = 0;
+        if (protocolVersion == 2)
+        {
+            param = PKT2_PARAMETER;
+            txPacket[PKT2_ID] = BROADCAST_ID;
+            txPacket[PKT2_INSTRUCTION] = INST_SYNC_WRITE;
+            txPacket[param++] = get_lowbyte(address);
+            txPacket[param++] = get_highbyte(address);
+            txPacket[param++] = get_lowbyte(size);
+            txPacket[param++] = get_highbyte(size);
+        }
+        else
+        {
+            param = PKT1_PARAMETER;
+            txPacket[PKT1_ID] = BROADCAST_ID;
+            txPacket[PKT1_INSTRUCTION] = INST_SYNC_WRITE;
+            txPacket[param++] = get_lowbyte(address);
+            txPacket[param++] = get_lowbyte(size);
+        }
+
+        for (size_t i = first; i < last; i++)
+        {
+            txPacket[param++] = get_lowbyte(ids.at(i));
+
+            for (int b = 0; b < size; b++)
+            {
+                txPacket[param++] = static_cast<unsigned char>((values.at(i) >> (8 * b)) & 0xFF);
+            }
+        }
+
+        if (protocolVersion == 2)
+        {
+            // Instruction + parameters + CRC
+            dxl_set_txpacket_length_field(param - PKT2_PARAMETER + 3);
+        }
+        else
+        {
+            // Instruction + parameters + checksum
+            dxl_set_txpacket_length_field(param - PKT1_PARAMETER + 2);
+        }
+
+        // Broadcast instructions never get a status packet
+        dxl_txrx_packet(ACK_NO_REPLY);
     }
+}
 
-    dxl_txrx_packet(ack);
+int Dynamixel::dxl_sync_read(const std::vector <int> &ids, const int address, const int length,
+                             std::vector <unsigned char> &data, std::vector <int> &errors)
+{
+    int answers = 0;
+
+    data.assign(ids.size() * length, 0);
+    errors.assign(ids.size(), -1);
+
+    if (protocolVersion != 2)
+    {
+        TRACE_ERROR(DXL, "SYNC_READ is only available with protocol v2\n");
+        return 0;
+    }
+    if (ids.empty() == true || length < 1 || (11 + length) > dxl_get_max_packet_size())
+    {
+        TRACE_ERROR(DXL, "Invalid SYNC_READ parameters (%zu ids / length %i)\n", ids.size(), length);
+        return 0;
+    }
+
+    // The instruction is split if all the IDs do not fit in a single packet
+    size_t idsPerPacket = static_cast<size_t>(dxl_get_max_packet_size() - (PKT2_PARAMETER + 4 + 2));
+
+    for (size_t first = 0; first < ids.size(); first += idsPerPacket)
+    {
+        size_t last = std::min(ids.size(), first + idsPerPacket);
+
+        while(commLock);
+
+        dxl_reserve_txpacket(PKT2_PARAMETER + 4 + static_cast<int>(last - first) + 2);
+
+        int param = PKT2_PARAMETER;
+        txPacket[PKT2_ID] = BROADCAST_ID;
+        txPacket[PKT2_INSTRUCTION] = INST_SYNC_READ;
+        txPacket[param++] = get_lowbyte(address);
+        txPacket[param++] = get_highbyte(address);
+        txPacket[param++] = get_lowbyte(length);
+        txPacket[param++] = get_highbyte(length);
+
+        for (size_t i = first; i < last; i++)
+        {
+            txPacket[param++] = get_lowbyte(ids.at(i));
+        }
+
+        dxl_set_txpacket_length_field(param - PKT2_PARAMETER + 3);
+
+        dxl_tx_packet(true);
+
+        if (commStatus != COMM_TXSUCCESS)
+        {
+            TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'\n", serialGetCurrentDevice().c_str());
+            return answers;
+        }
+
+        // The devices answer one after the other, in the order of the instruction
+        for (size_t i = first; i < last; i++)
+        {
+            dxl_rx_broadcast_status(ids.at(i), 11 + length);
+
+            if (commStatus == COMM_RXSUCCESS && dxl_get_rxpacket_size() == 11 + length)
+            {
+                for (int j = 0; j < length; j++)
+                {
+                    data[i * length + j] = static_cast<unsigned char>(dxl_get_rxpacket_parameter(j));
+                }
+
+                errors[i] = dxl_get_rxpacket_error();
+                answers++;
+            }
+            else if (commStatus == COMM_RXTIMEOUT)
+            {
+                // The devices that follow a silent one may never answer
+                TRACE_WARNING(DXL, "SYNC_READ: no answer from device #%i\n", ids.at(i));
+                break;
+            }
+        }
+
+        commLock = 0;
+    }
+
+    return answers;
+}
+
+int Dynamixel::dxl_bulk_read(const std::vector <int> &ids, const std::vector <int> &addresses, const std::vector <int> &lengths,
+                             std::vector <unsigned char> &data, std::vector <int> &errors)
+{
+    int answers = 0;
+    int overhead = (protocolVersion == 2) ? 11 : 6;
+    std::vector <size_t> offsets;
+    size_t total = 0;
+
+    // Size the results before checking the parameters, so they always match 'ids'
+    for (size_t i = 0; i < lengths.size() && i < ids.size(); i++)
+    {
+        offsets.push_back(total);
+        total += static_cast<size_t>(std::max(lengths.at(i), 0));
+    }
+
+    data.assign(total, 0);
+    errors.assign(ids.size(), -1);
+
+    if (ids.empty() == true || ids.size() != addresses.size() || ids.size() != lengths.size())
+    {
+        TRACE_ERROR(DXL, "Invalid BULK_READ parameters (%zu ids / %zu addresses / %zu lengths)\n", ids.size(), addresses.size(), lengths.size());
+        return 0;
+    }
+    for (size_t i = 0; i < lengths.size(); i++)
+    {
+        if (lengths.at(i) < 1 || (overhead + lengths.at(i)) > dxl_get_max_packet_size())
+        {
+            TRACE_ERROR(DXL, "Invalid BULK_READ length (%i) for device #%i\n", lengths.at(i), ids.at(i));
+            return 0;
+        }
+    }
+
+    // Each device gets a block made of its ID, register address and length
+    // (5 bytes with v2, 3 with v1 after a leading 0x00). The instruction is
+    // split if all the blocks do not fit in a single packet.
+    size_t blocksPerPacket = (protocolVersion == 2) ?
+                             static_cast<size_t>((dxl_get_max_packet_size() - (PKT2_PARAMETER + 2)) / 5) :
+                             static_cast<size_t>((dxl_get_max_packet_size() - (PKT1_PARAMETER + 2)) / 3);
+
+    for (size_t first = 0; first < ids.size(); first += blocksPerPacket)
+    {
+        size_t last = std::min(ids.size(), first + blocksPerPacket);
+
+        while(commLock);
+
+        int packetSize = (protocolVersion == 2) ?
+                         (PKT2_PARAMETER + static_cast<int>(last - first) * 5 + 2) :
+                         (PKT1_PARAMETER + 1 + static_cast<int>(last - first) * 3 + 1);
+        dxl_reserve_txpacket(packetSize);
+
+        int param = 0;
+        if (protocolVersion == 2)
+        {
+            param = PKT2_PARAMETER;
+            txPacket[PKT2_ID] = BROADCAST_ID;
+            txPacket[PKT2_INSTRUCTION] = INST_BULK_READ;
+
+            for (size_t i = first; i < last; i++)
+            {
+                txPacket[param++] = get_lowbyte(ids.at(i));
+                txPacket[param++] = get_lowbyte(addresses.at(i));
+                txPacket[param++] = get_highbyte(addresses.at(i));
+                txPacket[param++] = get_lowbyte(lengths.at(i));
+                txPacket[param++] = get_highbyte(lengths.at(i));
+            }
+
+            dxl_set_txpacket_length_field(param - PKT2_PARAMETER + 3);
+        }
+        else
+        {
+            param = PKT1_PARAMETER;
+            txPacket[PKT1_ID] = BROADCAST_ID;
+            txPacket[PKT1_INSTRUCTION] = INST_BULK_READ;
+            txPacket[param++] = 0x00;
+
+            for (size_t i = first; i < last; i++)
+            {
+                txPacket[param++] = get_lowbyte(lengths.at(i));
+                txPacket[param++] = get_lowbyte(ids.at(i));
+                txPacket[param++] = get_lowbyte(addresses.at(i));
+            }
+
+            dxl_set_txpacket_length_field(param - PKT1_PARAMETER + 2);
+        }
+
+        dxl_tx_packet(true);
+
+        if (commStatus != COMM_TXSUCCESS)
+        {
+            TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'\n", serialGetCurrentDevice().c_str());
+            return answers;
+        }
+
+        // The devices answer one after the other, in the order of the instruction
+        for (size_t i = first; i < last; i++)
+        {
+            dxl_rx_broadcast_status(ids.at(i), overhead + lengths.at(i));
+
+            if (commStatus == COMM_RXSUCCESS && dxl_get_rxpacket_size() == overhead + lengths.at(i))
+            {
+                for (int j = 0; j < lengths.at(i); j++)
+                {
+                    data[offsets.at(i) + j] = static_cast<unsigned char>(dxl_get_rxpacket_parameter(j));
+                }
+
+                errors[i] = dxl_get_rxpacket_error();
+                answers++;
+            }
+            else if (commStatus == COMM_RXTIMEOUT)
+            {
+                // The devices that follow a silent one may never answer
+                TRACE_WARNING(DXL, "BULK_READ: no answer from device #%i\n", ids.at(i));
+                break;
+            }
+        }
+
+        commLock = 0;
+    }
+
+    return answers;
+}
+
+void Dynamixel::dxl_bulk_write(const std::vector <int> &ids, const std::vector <int> &addresses, const std::vector <int> &sizes, const std::vector <int> &values)
+{
+    if (protocolVersion != 2)
+    {
+        TRACE_ERROR(DXL, "BULK_WRITE is only available with protocol v2\n");
+        return;
+    }
+    if (ids.empty() == true || ids.size() != addresses.size() || ids.size() != sizes.size() || ids.size() != values.size())
+    {
+        TRACE_ERROR(DXL, "Invalid BULK_WRITE parameters (%zu ids / %zu addresses / %zu sizes / %zu values)\n",
+                    ids.size(), addresses.size(), sizes.size(), values.size());
+        return;
+    }
+
+    size_t i = 0;
+    while (i < ids.size())
+    {
+        // A device can only appear once per instruction, so a new packet is
+        // started when an ID comes back, or when the current packet is full
+        bool used[256] = {false};
+
+        while(commLock);
+
+        int param = PKT2_PARAMETER;
+        txPacket[PKT2_ID] = BROADCAST_ID;
+        txPacket[PKT2_INSTRUCTION] = INST_BULK_WRITE;
+
+        for (; i < ids.size(); i++)
+        {
+            int id = get_lowbyte(ids.at(i));
+            int size = sizes.at(i);
+
+            if (size < 1 || size > 4)
+            {
+                TRACE_ERROR(DXL, "Invalid BULK_WRITE size (%i) for device #%i\n", size, id);
+                continue;
+            }
+            if (used[id] == true || (param + 5 + size + 2) > dxl_get_max_packet_size())
+            {
+                break;
+            }
+            used[id] = true;
+
+            dxl_reserve_txpacket(param + 5 + size + 2);
+
+            txPacket[param++] = static_cast<unsigned char>(id);
+            txPacket[param++] = get_lowbyte(addresses.at(i));
+            txPacket[param++] = get_highbyte(addresses.at(i));
+            txPacket[param++] = get_lowbyte(size);
+            txPacket[param++] = get_highbyte(size);
+
+            for (int b = 0; b < size; b++)
+            {
+                txPacket[param++] = static_cast<unsigned char>((values.at(i) >> (8 * b)) & 0xFF);
+            }
+        }
+
+        if (param > PKT2_PARAMETER)
+        {
+            dxl_set_txpacket_length_field(param - PKT2_PARAMETER + 3);
+
+            // Broadcast instructions never get a status packet
+            dxl_txrx_packet(ACK_NO_REPLY);
+        }
+    }
 }
@@ -26,18 +26,41 @@
 #include "SerialPortLinux.h"
 #include "SerialPortWindows.h"
 #include "SerialPortMacOS.h"
+#include "SerialPortFactory.h"
 
 #include "Utils.h"
 #include "ControlTables.h"
 #include "DynamixelTools.h"
+#include "DynamixelParser.h"
 
 #include <string>
 #include <vector>
+#include <map>
+#include <cstdint>
+
+/*!
+ * \brief Maximum size of a templated packet: a protocol v2 WRITE of 4 bytes.
+ */
+#define PACKET_TEMPLATE_SIZE    (16)
+
+/*!
+ * \brief A prebuilt instruction packet, for a given (ID, instruction, address, length).
+ *
+ * Everything but the payload (the value written) is set and validated once,
+ * when the template is built. Then only the payload bytes are patched, and the
+ * checksum (or CRC) is updated from the bytes that changed.
+ */
+struct PacketTemplate
+{
+    unsigned char packet[PACKET_TEMPLATE_SIZE]; //!< The complete packet, with a valid checksum
+    int packetSize;             //!< Size of the packet
+    int payloadOffset;          //!< Index of the first payload byte, the payload ends right before the checksum
+    int payloadSize;            //!< Number of payload byte(s), 0 for READ instructions
+};
 
 /*!
  * \brief The Dynamixel communication protocols implementation
  * \todo Rename to DynamixelProtocol
- * \todo Handle "sync" and "bulk" read/write operations.
  *
  * This class provide the low level API to handle communication with servos.
  * It can generate instruction packets and send them over a serial link. This class
@@ -52,10 +75,15 @@ class Dynamixel
 private:
     SerialPort *serial;         //!< The serial port instance we are going to use.
 
-    unsigned char txPacket[MAX_PACKET_LENGTH_dxlv1]; //!< TX "instruction" packet buffer
-    unsigned char rxPacket[MAX_PACKET_LENGTH_dxlv1]; //!< RX "status" packet buffer
-    int rxPacketSize;           //!< Size of the incoming packet
-    int rxPacketSizeReceived;   //!< Byte(s) of the incoming packet received from the serial link
+    unsigned char txPacketBuffer[MAX_PACKET_LENGTH_dxlv1]; //!< TX storage for the common (small) packets
+    std::vector <unsigned char> txPacketPool; //!< TX storage for large protocol v2 packets, grown on demand and reused by the next transactions
+    unsigned char *txPacket;    //!< TX "instruction" packet buffer (txPacketBuffer or txPacketPool)
+    int txPacketCapacity;       //!< Size of the TX packet buffer currently in use
+
+    DynamixelParser rxParser;   //!< Streaming parser for the incoming status packets (its last frame is the RX "status" packet)
+    bool rxPacketPending;       //!< The last packet received was not sent by the device expected, keep it for the next one
+
+    std::map <uint64_t, PacketTemplate> txPacketTemplates; //!< Packet templates, by protocol version, ID, instruction, address and length
 
     /*!
      * The software lock used to lock the serial interface, to avoid concurent
@@ -68,9 +96,59 @@ private:
     int commStatus;              //!< Last communication status
 
     // Serial communication methods, using one of the SerialPort[Linux/Mac/Windows] implementations.
-    void dxl_tx_packet();
+    void dxl_tx_packet(bool reply = true, bool prebuilt = false);
     void dxl_rx_packet();
-    void dxl_txrx_packet(int ack);
+    void dxl_txrx_packet(int ack, bool prebuilt = false);
+
+    /*!
+     * \brief Wait for the status packet of one device, answering a broadcast SYNC_READ or BULK_READ instruction.
+     * \param id: The device expected to answer.
+     * \param statusSize: The expected size of its status packet.
+     */
+    void dxl_rx_broadcast_status(const int id, const int statusSize);
+
+    /*!
+     * \brief Feed the RX parser with the bytes available on the serial link.
+     * \return The parser status, using ::DynamixelParserStatus_e values.
+     *
+     * Stops at the end of the first frame, any following byte stays in the receive buffer.
+     */
+    int dxl_rx_parse();
+
+    /*!
+     * \brief Make sure the TX packet buffer can hold a packet of the given size.
+     * \param size: The size (in byte) of the packet.
+     *
+     * Packets that fit into the small storage never allocate. The pool only
+     * grows, so a given packet size only allocates once. The content already
+     * in the packet buffer is kept.
+     */
+    void dxl_reserve_txpacket(const int size);
+
+    /*!
+     * \brief Set the TX packet from its template, building the template first if needed.
+     * \param id: The device to address.
+     * \param instruction: INST_READ or INST_WRITE.
+     * \param address: The register address.
+     * \param length: Number of byte(s) to read or to write.
+     * \param payload: The value to write (length bytes), unused by READ instructions.
+     * \return True if the TX packet is complete and can be sent with 'prebuilt' set,
+     *         false if it still needs to go through validation, stuffing and checksum.
+     *
+     * Uncommon packets (too large, invalid, or needing byte stuffing) are not
+     * templated: the TX packet is set the usual way and false is returned.
+     */
+    bool dxl_set_txpacket_template(const int id, const int instruction, const int address, const int length, const unsigned char *payload);
+
+    /*!
+     * \brief Apply protocol v2 byte stuffing to the TX packet, before its CRC is computed.
+     * \return The number of byte(s) inserted, or -1 if the stuffed packet would be too large.
+     *
+     * Every 0xFF 0xFF 0xFD sequence found after the length field gets an extra 0xFD,
+     * so it cannot be mistaken for a packet header. The packet is stuffed in place,
+     * in one pass (from its end) once the number of sequences is known.
+     */
+    int dxl2_stuff_txpacket();
 
 protected:
     Dynamixel();
@@ -114,6 +192,7 @@ protected:
     unsigned short dxl2_checksum_packet(unsigned char *packetData, const int packetSize);
 
     // TX packet analysis
+    int dxl_get_max_packet_size();  //!< Maximum size of a packet with the protocol in use (MAX_PACKET_LENGTH_dxlv1 or MAX_PACKET_LENGTH_dxlv2)
     int dxl_get_txpacket_size();
     int dxl_get_txpacket_length_field();
     int dxl_validate_packet();
@@ -138,6 +217,33 @@ protected:
     // Instructions
     bool dxl_ping(const int id, PingResponse *status = NULL, const int ack = ACK_DEFAULT);
 
+    /*!
+     * \brief Ping every device on the bus with a single broadcast PING (protocol v2 only).
+     * \param ids: The IDs of the devices that answered, in the order they answered.
+     * \param status: The ping responses of these devices.
+     * \param maxId: Highest ID we are interested in, devices with a higher ID may be missed.
+     * \return The number of devices found.
+     *
+     * The devices answer one after the other, in ID order, each one in its own
+     * time slot (one status packet plus a 3 ms delay). The answers are collected
+     * until the slot of 'maxId' is over, or as soon as 'maxId' itself answered.
+     * When the deadline expires, a status packet already being received is
+     * allowed to complete, otherwise the bus is idle and the scan stops.
+     */
+    int dxl_ping_broadcast(std::vector <int> &ids, std::vector <PingResponse> &status, const int maxId = BROADCAST_ID - 1);
+
+    /*!
+     * \brief Scan a range of IDs for devices.
+     * \param start: First ID to scan.
+     * \param stop: Last ID to scan (included).
+     * \param ids: The IDs of the devices found in [start, stop], in ascending order.
+     * \param status: The ping responses of these devices.
+     * \return The number of devices found.
+     *
+     * A single broadcast PING is used with protocol v2, one PING per ID otherwise.
+     */
+    int dxl_scan(const int start, const int stop, std::vector <int> &ids, std::vector <PingResponse> &status);
+
     /*!
      * \brief Reset servo control table.
      * \param id: The servo to reset to factory default settings.
@@ -151,27 +257,91 @@ protected:
     void dxl_reboot(const int id, const int ack = ACK_DEFAULT);
     void dxl_action(const int id, const int ack = ACK_DEFAULT);
 
+    /*!
+     * \brief Stage a register write with REG_WRITE, to be executed by the next ACTION instruction.
+     * \param id: The device to write to.
+     * \param address: The start address of the register range.
+     * \param length: The size of the register range, in byte(s). Range is [1;8].
+     * \param data: The bytes to write.
+     * \param ack: Ack policy in effect.
+     *
+     * A device only keeps one staged write, so a new REG_WRITE replaces the
+     * previous one if no ACTION has been received in between.
+     */
+    void dxl_reg_write(const int id, const int address, const int length, const unsigned char *data, const int ack = ACK_DEFAULT);
+
     // DOCME // Read/write register instructions
     int dxl_read_byte(const int id, const int address, const int ack = ACK_DEFAULT);
     void dxl_write_byte(const int id, const int address, const int value, const int ack = ACK_DEFAULT);
     int dxl_read_word(const int id, const int address, const int ack = ACK_DEFAULT);
     void dxl_write_word(const int id, const int address, const int value, const int ack = ACK_DEFAULT);
-/*
-    // TODO // Reg write
-    void dxl_reg_write(const int id, ???)
-
-    // TODO // Sync read/write register instructions
-    std::vector <int> dxl_sync_read_byte(std::vector <int> ids, int address);
-    void dxl_sync_write_byte(std::vector <int> ids, int address, int value);
-    std::vector <int> dxl_sync_read_word(std::vector <int> ids, int address);
-    void dxl_sync_write_word(std::vector <int> ids, int address, int value);
-
-    // TODO // Bulk read/write register instructions
-    std::vector <int> dxl_bulk_read_byte(std::vector <int> ids, int address);
-    void dxl_bulk_write_byte(std::vector <int> ids, int address, int value);
-    std::vector <int> dxl_bulk_read_word(std::vector <int> ids, int address);
-    void dxl_bulk_write_word(std::vector <int> ids, int address, int value);
-*/
+
+    /*!
+     * \brief Read a range of consecutive registers with a single READ instruction.
+     * \param id: The device to read from.
+     * \param address: The start address of the register range.
+     * \param length: The size of the register range, in byte(s).
+     * \param[out] data: Buffer receiving the 'length' bytes read.
+     * \param ack: Ack policy in effect.
+     * \return The number of bytes read, or a negative ::SerialErrorCodes_e value.
+     */
+    int dxl_read(const int id, const int address, const int length, unsigned char *data, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Write the same register of several devices with a single broadcast SYNC_WRITE instruction.
+     * \param ids: The devices to write to.
+     * \param address: The address of the register (must be the same for every device).
+     * \param size: The size of the register, in byte(s). Range is [1;4].
+     * \param values: The value to write for each device, in the same order as 'ids'.
+     *
+     * Devices never answer to SYNC_WRITE, so no status is available for the
+     * individual writes. The instruction is split into several packets if needed.
+     */
+    void dxl_sync_write(const std::vector <int> &ids, const int address, const int size, const std::vector <int> &values);
+
+    /*!
+     * \brief Read the same register range of several devices with a single SYNC_READ instruction.
+     * \param ids: The devices to read from.
+     * \param address: The start address of the register range (must be the same for every device).
+     * \param length: The size of the register range, in byte(s).
+     * \param[out] data: 'length' bytes for each device, in the same order as 'ids'. Left to 0 for devices that did not answer.
+     * \param[out] errors: For each device, the error field of its status packet, or -1 if it did not answer.
+     * \return The number of devices that answered.
+     *
+     * Only available with protocol v2. The devices answer with back-to-back
+     * status packets, so the whole read costs roughly one round-trip.
+     */
+    int dxl_sync_read(const std::vector <int> &ids, const int address, const int length,
+                      std::vector <unsigned char> &data, std::vector <int> &errors);
+
+    /*!
+     * \brief Read a register range of several devices with a single BULK_READ instruction.
+     * \param ids: The devices to read from.
+     * \param addresses: The start address of the register range, for each device.
+     * \param lengths: The size of the register range (in byte(s)), for each device.
+     * \param[out] data: The bytes read from each device, one after the other and in the same order as 'ids'. Left to 0 for devices that did not answer.
+     * \param[out] errors: For each device, the error field of its status packet, or -1 if it did not answer.
+     * \return The number of devices that answered.
+     *
+     * Unlike SYNC_READ, each device can use its own address and length, so
+     * devices with different control tables can be read at once. Only available
+     * with protocol v2, and with MX series devices when using protocol v1.
+     */
+    int dxl_bulk_read(const std::vector <int> &ids, const std::vector <int> &addresses, const std::vector <int> &lengths,
+                      std::vector <unsigned char> &data, std::vector <int> &errors);
+
+    /*!
+     * \brief Write a register of several devices with a single BULK_WRITE instruction.
+     * \param ids: The devices to write to.
+     * \param addresses: The address of the register, for each device.
+     * \param sizes: The size of the register (in byte(s)), for each device. Range is [1;4].
+     * \param values: The value to write, for each device.
+     *
+     * Unlike SYNC_WRITE, each device can get a different register. Only available
+     * with protocol v2. A device can only appear once per instruction, so the
+     * writes are split into several packets when an ID is repeated.
+     */
+    void dxl_bulk_write(const std::vector <int> &ids, const std::vector <int> &addresses, const std::vector <int> &sizes, const std::vector <int> &values);
 public:
     /*!
      * \brief Get the name of the serial device associated with this Dynamixel instance.
@@ -179,6 +349,12 @@ public:
      */
     std::string serialGetCurrentDevice();
 
+    /*!
+     * \brief Get the speed of the serial link associated with this Dynamixel instance.
+     * \return The baud rate of the serial link, or 0 if it is not opened.
+     */
+    int serialGetBaudRate();
+
     /*!
      * \brief Get the available serial devices.
      * \return A list of path to all the serial device nodes available (ex: "/dev/ttyUSB0").
@@ -191,6 +367,33 @@ public:
      */
     void serialSetLatency(int latency);
 
+    /*!
+     * \brief serialSwitchHighSpeed
+     * \return True if low latency settings are effective on the serial device.
+     *
+     * Reduce the latency of the serial device (adapter latency timer and driver
+     * low latency flag), when the serial port backend supports it (Linux only).
+     */
+    bool serialSwitchHighSpeed();
+
+    /*!
+     * \brief serialSetAdaptiveTimeOut
+     * \param enabled: Use timeouts learned from each device response latency (default), or only the serialSetLatency() value.
+     *
+     * Even with adaptive timeouts enabled, the serialSetLatency() value is used
+     * with devices that never answered, and as an upper bound.
+     */
+    void serialSetAdaptiveTimeOut(bool enabled);
+
+    /*!
+     * \brief serialSetTxBatching
+     * \param enabled: Queue instruction packets that do not expect an answer, and send them together.
+     *
+     * Queued packets are sent with the next packet expecting an answer, or when
+     * TX batching is disabled again.
+     */
+    void serialSetTxBatching(bool enabled);
+
     /*!
      * \brief setAckPolicy
      * \param ack: Ack policy value, using '::AckPolicy_e' enum.
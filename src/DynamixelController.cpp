@@ -24,18 +24,149 @@
 #include "minitraces.h"
 
 // C++ standard libraries
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <thread>
 #include <mutex>
 
-// Enable latency timer
-//#define LATENCY_TIMER
+/*!
+ * \brief Writes of the same register on several devices, sent as a single SYNC_WRITE instruction.
+ */
+struct SyncWriteGroup
+{
+    int addr;                       //!< Address of the register.
+    int size;                       //!< Size of the register, in byte(s).
+    std::vector <int> ids;          //!< Devices to write to.
+    std::vector <int> values;       //!< Value to write for each device.
+};
+
+/*!
+ * \brief Queue a register write into the group matching its address and size.
+ *
+ * If the device already has a pending write for this register, its value is
+ * replaced, so only the last value set during a cycle is sent.
+ */
+static void syncWriteQueue(std::vector <SyncWriteGroup> &groups, const int id, const int addr, const int size, const int value)
+{
+    for (auto &g: groups)
+    {
+        if (g.addr == addr && g.size == size)
+        {
+            for (size_t i = 0; i < g.ids.size(); i++)
+            {
+                if (g.ids.at(i) == id)
+                {
+                    g.values.at(i) = value;
+                    return;
+                }
+            }
+
+            g.ids.push_back(id);
+            g.values.push_back(value);
+            return;
+        }
+    }
+
+    SyncWriteGroup g;
+    g.addr = addr;
+    g.size = size;
+    g.ids.push_back(id);
+    g.values.push_back(value);
+    groups.push_back(g);
+}
+
+/*!
+ * \brief Take the pending write of a device out of the group matching a register address.
+ * \return 1 if a write was found, 0 otherwise.
+ */
+static int syncWriteTake(std::vector <SyncWriteGroup> &groups, const int id, const int addr, int &size, int &value)
+{
+    for (auto &g: groups)
+    {
+        if (g.addr == addr)
+        {
+            for (size_t i = 0; i < g.ids.size(); i++)
+            {
+                if (g.ids.at(i) == id)
+                {
+                    size = g.size;
+                    value = g.values.at(i);
+                    g.ids.erase(g.ids.begin() + i);
+                    g.values.erase(g.values.begin() + i);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Merge the pending writes of contiguous registers of a same device.
+ *
+ * Writes to adjacent addresses of a device (ex: goal position and goal speed)
+ * are merged into a single write, as long as the merged range fits in 4 bytes
+ * (the largest value a SYNC_WRITE or BULK_WRITE block can carry). The groups
+ * are then rebuilt, so devices writing the same merged range share the same
+ * SYNC_WRITE instruction.
+ */
+static void syncWriteMerge(std::vector <SyncWriteGroup> &groups)
+{
+    struct PendingWrite { int id, addr, size; unsigned value; };
+    std::vector <PendingWrite> writes;
+
+    for (auto const &g: groups)
+    {
+        for (size_t i = 0; i < g.ids.size(); i++)
+        {
+            unsigned mask = (g.size >= 4) ? 0xFFFFFFFF : ((1u << (8 * g.size)) - 1);
+            PendingWrite w = {g.ids.at(i), g.addr, g.size, static_cast<unsigned>(g.values.at(i)) & mask};
+            writes.push_back(w);
+        }
+    }
+
+    // Sort by device then address, keeping the device order stable
+    std::stable_sort(writes.begin(), writes.end(), [](const PendingWrite &a, const PendingWrite &b)
+    {
+        return (a.id != b.id) ? (a.id < b.id) : (a.addr < b.addr);
+    });
+
+    groups.clear();
+
+    for (size_t i = 0; i < writes.size();)
+    {
+        PendingWrite w = writes.at(i++);
+
+        while (i < writes.size() &&
+               writes.at(i).id == w.id &&
+               writes.at(i).addr == w.addr + w.size &&
+               w.size + writes.at(i).size <= 4)
+        {
+            w.value |= writes.at(i).value << (8 * w.size);
+            w.size += writes.at(i).size;
+            i++;
+        }
+
+        syncWriteQueue(groups, w.id, w.addr, w.size, static_cast<int>(w.value));
+    }
+}
 
 DynamixelController::DynamixelController(int ctrlFrequency, int servoSerie):
-    ControllerAPI(ctrlFrequency)
+    ControllerAPI(ctrlFrequency),
+    stagedCommit(false)
 {
     this->servoSerie = servoSerie;
+
+    // Default refresh rates: position at full rate, the other motion feedbacks
+    // at a quarter of the loop frequency, and voltage and temperature at 1 Hz
+    registerScheduler.setBuiltinRate(REG_CURRENT_POSITION, 1.0, 2, true);
+    registerScheduler.setBuiltinRate(REG_CURRENT_SPEED, 0.25, 1, true);
+    registerScheduler.setBuiltinRate(REG_CURRENT_LOAD, 0.25, 1, true);
+    registerScheduler.setBuiltinRate(REG_MOVING, 0.25, 1, true);
+    registerScheduler.setBuiltinRate(REG_CURRENT_VOLTAGE, 1.0, 0, false);
+    registerScheduler.setBuiltinRate(REG_CURRENT_TEMPERATURE, 1.0, 0, false);
 }
 
 DynamixelController::~DynamixelController()
@@ -43,6 +174,16 @@ DynamixelController::~DynamixelController()
     disconnect();
 }
 
+void DynamixelController::setStagedCommit(bool enabled)
+{
+    stagedCommit = enabled;
+}
+
+bool DynamixelController::getStagedCommit()
+{
+    return stagedCommit;
+}
+
 void DynamixelController::updateInternalSettings()
 {
     if (servoSerie != SERVO_UNKNOWN)
@@ -138,6 +279,12 @@ int DynamixelController::connect(std::string &devicePath, const int baud, const
     // Connection
     int retcode = serialInitialize(devicePath, baud);
 
+    // The adapter type may have been autodetected by the serial port
+    if (this->serialDevice != serialDevice)
+    {
+        updateInternalSettings();
+    }
+
     if (retcode == 1)
     {
         startThread();
@@ -195,76 +342,279 @@ void DynamixelController::autodetect_internal(int start, int stop)
     TRACE_INFO(CAPI, "> THREADED Scanning for DXL devices on '%s', protocol v%i, range is [%i,%i[\n",
                serialGetCurrentDevice().c_str(), protocolVersion, start, stop);
 
-    for (int id = start; id <= stop; id++)
+    // The devices found, and their ping responses
+    std::vector <int> ids;
+    std::vector <PingResponse> pings;
+
+    dxl_scan(start, stop, ids, pings);
+
+    for (size_t i = 0; i < ids.size(); i++)
     {
-        PingResponse pingstats;
+        const int id = ids.at(i);
+        const PingResponse &pingstats = pings.at(i);
+
+        //setLed(id, 1, LED_GREEN);
+
+        int serie, model;
+        dxl_get_model_infos(pingstats.model_number, serie, model);
+        ServoDynamixel *servo = NULL;
 
-        // If the ping gets a response, then we have found a servo
-        if (dxl_ping(id, &pingstats) == true)
+        TRACE_INFO(DXL, "[#%i] %s servo found!\n", id, dxl_get_model_name(pingstats.model_number).c_str());
+
+        // Instanciate the device found
+        switch (serie)
         {
-            //setLed(id, 1, LED_GREEN);
+        case SERVO_AX:
+        case SERVO_DX:
+        case SERVO_RX:
+            servo = new ServoAX(id, pingstats.model_number);
+            break;
 
-            int serie, model;
-            dxl_get_model_infos(pingstats.model_number, serie, model);
-            ServoDynamixel *servo = NULL;
+        case SERVO_EX:
+            servo = new ServoEX(id, pingstats.model_number);
+            break;
 
-            TRACE_INFO(DXL, "[#%i] %s servo found!\n", id, dxl_get_model_name(pingstats.model_number).c_str());
+        case SERVO_MX:
+            servo = new ServoMX(id, pingstats.model_number);
+            break;
 
-            // Instanciate the device found
-            switch (serie)
-            {
-            case SERVO_AX:
-            case SERVO_DX:
-            case SERVO_RX:
-                servo = new ServoAX(id, pingstats.model_number);
-                break;
+        case SERVO_XL:
+            servo = new ServoXL(id, pingstats.model_number);
 
-            case SERVO_EX:
-                servo = new ServoEX(id, pingstats.model_number);
-                break;
+        default:
+            break;
+        }
 
-            case SERVO_MX:
-                servo = new ServoMX(id, pingstats.model_number);
-                break;
+        if (servo != NULL)
+        {
+            servoListLock.lock();
 
-            case SERVO_XL:
-                servo = new ServoXL(id, pingstats.model_number);
+            // Add the servo to the controller
+            servoList.push_back(servo);
+            servoTable[servo->getId()] = servo;
 
-            default:
-                break;
-            }
+            // Mark it for an "initial read" and synchronization
+            updateList.push_back(servo->getId());
+            syncList.push_back(servo->getId());
 
-            if (servo != NULL)
+            servoListLock.unlock();
+        }
+
+        //setLed(id, 0);
+    }
+
+    printf("\n");
+
+    // Restore RX packet timeout
+    serialSetLatency(LATENCY_TIME_DEFAULT);
+
+    if (getState() >= state_started)
+    {
+        setState(state_scanned);
+    }
+}
+
+void DynamixelController::planReads(const bool staged, std::vector <ScheduledRead> &reads)
+{
+    // Transfer time of one byte (10 bits with start and stop bits), in microseconds
+    int baudRate = serialGetBaudRate();
+    double byteTime = (baudRate > 0) ? (10000000.0 / static_cast<double>(baudRate)) : 10.0;
+
+    // Size of a status packet without parameters, and of a READ instruction packet
+    int statusSize = (protocolVersion == 2) ? 11 : 6;
+    int readSize = (protocolVersion == 2) ? 14 : 8;
+
+    int budget = syncloopReadBudget();
+
+    servoListLock.lock();
+
+    std::vector <int> ids;
+    int stagedDevices = 0, stagedBytes = 0;
+    for (auto id: syncList)
+    {
+        Servo *s = findServo_internal(id);
+
+        if (s != NULL)
+        {
+            if (s->getStatusReturnLevel() != ACK_NO_REPLY)
             {
-                servoListLock.lock();
+                ids.push_back(id);
+            }
+            if (staged == true && s->getStatusReturnLevel() != ACK_REPLY_ALL &&
+                (s->getValueCommit(REG_GOAL_POSITION) == 1 || s->getValueCommit(REG_GOAL_SPEED) == 1))
+            {
+                stagedDevices++;
+                stagedBytes += getRegisterSize(s->getControlTable(), REG_GOAL_POSITION) +
+                               getRegisterSize(s->getControlTable(), REG_GOAL_SPEED);
+            }
+        }
+    }
+
+    if (stagedDevices > 0)
+    {
+        // One REG_WRITE of the goal registers per device, then a broadcast
+        // ACTION. None of them get an answer.
+        int regWriteSize = (protocolVersion == 2) ? 12 : 7;
+        int actionSize = (protocolVersion == 2) ? 10 : 6;
+
+        budget -= static_cast<int>((stagedDevices * regWriteSize + stagedBytes + actionSize) * byteTime);
+    }
+
+    registerScheduler.plan(ids, budget, [&](int id, int reg, bool first) -> int
+    {
+        Servo *s = findServo_internal(id);
 
-                // Add the servo to the controller
-                servoList.push_back(servo);
+        if (s == NULL || s->gaddr(reg) < 0)
+        {
+            return -1;
+        }
 
-                // Mark it for an "initial read" and synchronization
-                updateList.push_back(servo->getId());
-                syncList.push_back(servo->getId());
+        int size = getRegisterSize(s->getControlTable(), reg);
+        int serie = 0, model = 0;
+        s->getModelInfos(serie, model);
 
-                servoListLock.unlock();
+        if (protocolVersion == 2 || serie == SERVO_MX)
+        {
+            // Part of the SYNC_READ or BULK_READ of this cycle
+            if (first == true)
+            {
+                return SYNCLOOP_TURNAROUND_US + static_cast<int>((statusSize + 5 + size) * byteTime);
             }
 
-            //setLed(id, 0);
+            return static_cast<int>(size * byteTime);
         }
-        else
+
+        // Read with its own READ instruction
+        return SYNCLOOP_TURNAROUND_US + static_cast<int>((readSize + statusSize + size) * byteTime);
+    }, reads);
+
+    servoListLock.unlock();
+}
+
+void DynamixelController::readFeedback(const std::vector <ScheduledRead> &reads, std::vector <int> &ids)
+{
+    std::vector <Servo *> servos;
+    std::vector <std::vector <int> > registers;
+    std::vector <int> servoIds, addresses, lengths;
+    bool sameRange = true;
+
+    // Gather the devices, and the register range covering their planned registers
+    servoListLock.lock();
+    for (size_t first = 0, last = 0; first < reads.size(); first = last)
+    {
+        int id = reads.at(first).id;
+
+        // The planned reads are grouped by device
+        for (last = first; last < reads.size() && reads.at(last).id == id; last++);
+
+        Servo *s = findServo_internal(id);
+
+        if (s != NULL &&
+            s->getStatusReturnLevel() != ACK_NO_REPLY &&
+            s->getErrorCount() <= 16)
         {
-            printf(".");
+            int serie = 0, model = 0;
+            s->getModelInfos(serie, model);
+
+            if (protocolVersion == 1 && serie != SERVO_MX)
+            {
+                continue;
+            }
+
+            std::vector <int> regs;
+            int addrStart = -1, addrEnd = -1;
+            for (size_t i = first; i < last; i++)
+            {
+                int addr = s->gaddr(reads.at(i).reg);
+                if (addr >= 0)
+                {
+                    int end = addr + getRegisterSize(s->getControlTable(), reads.at(i).reg);
+                    if (addrStart < 0 || addr < addrStart) addrStart = addr;
+                    if (end > addrEnd) addrEnd = end;
+                    regs.push_back(reads.at(i).reg);
+                }
+            }
+
+            if (addrStart >= 0)
+            {
+                if (servos.empty() == false &&
+                    (s->getControlTable() != servos.front()->getControlTable() ||
+                     addrStart != addresses.front() || (addrEnd - addrStart) != lengths.front()))
+                {
+                    sameRange = false;
+                }
+
+                servos.push_back(s);
+                registers.push_back(regs);
+                servoIds.push_back(id);
+                addresses.push_back(addrStart);
+                lengths.push_back(addrEnd - addrStart);
+            }
         }
     }
+    servoListLock.unlock();
 
-    printf("\n");
+    if (servos.empty() == true)
+    {
+        return;
+    }
 
-    // Restore RX packet timeout
-    serialSetLatency(LATENCY_TIME_DEFAULT);
+    std::vector <unsigned char> data;
+    std::vector <int> errors;
 
-    if (getState() >= state_started)
+    if (protocolVersion == 2 && sameRange == true)
     {
-        setState(state_scanned);
+        dxl_sync_read(servoIds, addresses.front(), lengths.front(), data, errors);
+    }
+    else
+    {
+        dxl_bulk_read(servoIds, addresses, lengths, data, errors);
+    }
+
+    size_t total = 0;
+    for (auto length: lengths)
+    {
+        total += static_cast<size_t>(length);
+    }
+
+    if (errors.size() != servos.size() || data.size() < total)
+    {
+        TRACE_ERROR(CAPI, "Feedback read results don't match the request (%zu/%zu devices, %zu/%zu bytes)\n",
+                    errors.size(), servos.size(), data.size(), total);
+        updateErrorCount(static_cast<int>(servos.size()));
+        return;
     }
+
+    servoListLock.lock();
+    size_t offset = 0;
+    for (size_t i = 0; i < servos.size(); i++)
+    {
+        if (errors.at(i) >= 0)
+        {
+            for (auto reg: registers.at(i))
+            {
+                size_t pos = offset + (servos.at(i)->gaddr(reg) - addresses.at(i));
+                int value = data.at(pos);
+
+                if (getRegisterSize(servos.at(i)->getControlTable(), reg) == 2)
+                {
+                    value = make_short_word(data.at(pos), data.at(pos + 1));
+                }
+
+                servos.at(i)->updateValue(reg, value);
+            }
+
+            servos.at(i)->setError(errors.at(i));
+            ids.push_back(servoIds.at(i));
+        }
+        else
+        {
+            updateErrorCount(1);
+        }
+
+        offset += lengths.at(i);
+    }
+    servoListLock.unlock();
 }
 
 void DynamixelController::run()
@@ -272,13 +622,11 @@ void DynamixelController::run()
     TRACE_INFO(CAPI, "DynamixelController::run(port: '%s' / tid: '%i')\n",
                serialGetCurrentDevice().c_str(), std::this_thread::get_id());
 
-    std::chrono::time_point<std::chrono::system_clock> start, end;
+    // Loop timer
+    syncloopStart();
 
     while (getState() >= state_started)
     {
-        // Loop timer
-        start = std::chrono::system_clock::now();
-
         // MESSAGE PARSING
         ////////////////////////////////////////////////////////////////////////
 
@@ -343,6 +691,9 @@ void DynamixelController::run()
         // ACTION LOOP
         ////////////////////////////////////////////////////////////////////////
 
+        // Instructions without answer (actions, writes with no ack) are queued and sent together
+        serialSetTxBatching(true);
+
         servoListLock.lock();
         for (auto s: servoList)
         {
@@ -368,20 +719,7 @@ void DynamixelController::run()
             if (rebootProgrammed == 1)
             {
                 // Remove servo from sync/update lists; Need to be added again after reboot!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
-                {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
-                }
+                unsyncServo_internal(id);
 
                 // Reboot
                 dxl_reboot(id, ack);
@@ -394,20 +732,7 @@ void DynamixelController::run()
             if (resetProgrammed > 0)
             {
                 // Remove servo from sync/update lists; Need to be added again after reset!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
-                {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
-                }
+                unsyncServo_internal(id);
 
                 // Reset
                 dxl_reset(id, resetProgrammed, ack);
@@ -419,51 +744,74 @@ void DynamixelController::run()
         }
         servoListLock.unlock();
 
+        // Send whatever is left in the batch
+        serialSetTxBatching(false);
+
         // INITIAL READ LOOP
         ////////////////////////////////////////////////////////////////////////
 
         servoListLock.lock();
         if (updateList.empty() == false)
         {
-            std::vector <int>::iterator itr;
-            for (itr = updateList.begin(); itr != updateList.end();)
+            setState(state_reading);
+
+            for (auto id: updateList)
             {
-                setState(state_reading);
+                Servo *s = findServo_internal(id);
 
-                for (auto s: servoList)
+                if (s != NULL)
                 {
-                    if (s->getId() == (*itr))
+                    int ack = s->getStatusReturnLevel();
+                    const int (*ct)[8] = s->getControlTable();
+
+                    // Fetch the control table by contiguous address runs (EEPROM then RAM), one READ per run
+                    for (int area = REGISTER_ROM; area <= REGISTER_RAM; area++)
                     {
-                        int id = s->getId();
-                        int ack = s->getStatusReturnLevel();
+                        std::vector <RegisterRun> runs;
+                        getRegisterRuns(ct, area, dxl_get_max_packet_size() - 11, 8, runs);
 
-                        for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
+                        for (auto const &run: runs)
                         {
-                            int reg_name = getRegisterName(s->getControlTable(), ctid);
-                            int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
-                            int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+                            std::vector <unsigned char> data(run.size);
+
+                            TRACE_1(DXL, "Reading registers run addr: '%i' size: '%i'", run.addr, run.size);
 
-                            TRACE_1(DXL, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
+                            int status = dxl_read(id, run.addr, run.size, data.data(), ack);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
 
-                            if (reg_size == 1)
+                            if (status != run.size)
                             {
-                                s->updateValue(reg_name, dxl_read_byte(id, reg_addr, ack));
+                                continue;
                             }
-                            else //if (regsize == 2)
+
+                            // Unpack the registers contained in this run
+                            for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
                             {
-                                s->updateValue(reg_name, dxl_read_word(id, reg_addr, ack));
+                                int reg_name = getRegisterName(ct, ctid);
+                                int reg_addr = getRegisterAddr(ct, reg_name, area);
+                                int reg_size = getRegisterSize(ct, reg_name);
+
+                                if (reg_addr >= run.addr && (reg_addr + reg_size) <= (run.addr + run.size))
+                                {
+                                    int value = 0;
+                                    for (int b = reg_size - 1; b >= 0; b--)
+                                    {
+                                        value = (value << 8) | data[reg_addr - run.addr + b];
+                                    }
+
+                                    s->updateValue(reg_name, value);
+                                }
                             }
-                            s->setError(dxl_get_rxpacket_error());
-                            updateErrorCount(dxl_get_com_error_count());
-                            dxl_print_error();
                         }
-
-                        // Once all registers are read, remove the servo from the "updateList"
-                        itr = updateList.erase(itr);
                     }
                 }
             }
 
+            // Once all registers are read, the devices leave the "updateList"
+            updateList.clear();
+
             setState(state_ready);
         }
         servoListLock.unlock();
@@ -471,288 +819,344 @@ void DynamixelController::run()
         // SYNCHRONIZATION LOOP
         ////////////////////////////////////////////////////////////////////////
 
-        int cumulid = 0;
+        // Instructions without answer (writes with no ack) are queued and sent together
+        serialSetTxBatching(true);
+
+        // Pending register writes, grouped by register across devices
+        std::vector <SyncWriteGroup> syncWrites;
+
+        // Registers to read this cycle, and devices whose registers have already been read
+        std::vector <ScheduledRead> reads;
+        std::vector <int> feedbackIds;
+        const bool staged = stagedCommit;
+        planReads(staged, reads);
+        readFeedback(reads, feedbackIds);
+
+        // Devices read by readFeedback(), and planned reads of the others, as [first;last[ ranges in 'reads'
+        std::fill(feedbackRead, feedbackRead + BROADCAST_ID, false);
+        std::fill(readsFirst, readsFirst + BROADCAST_ID, 0);
+        std::fill(readsLast, readsLast + BROADCAST_ID, 0);
+
+        for (auto id: feedbackIds)
+        {
+            feedbackRead[id] = true;
+        }
+        for (size_t i = 0; i < reads.size(); i++)
+        {
+            if (readsLast[reads[i].id] == 0)
+            {
+                readsFirst[reads[i].id] = i;
+            }
+            readsLast[reads[i].id] = i + 1;
+        }
 
         servoListLock.lock();
         for (auto id: syncList)
         {
-            cumulid++;
-            cumulid %= syncloopFrequency;
+            ServoDynamixel *s = static_cast<ServoDynamixel*>(findServo_internal(id));
 
-            for (auto s_raw: servoList)
+            if (s != NULL)
             {
-                servoListLock.unlock();
-
-                ServoDynamixel *s = static_cast<ServoDynamixel*>(s_raw);
+                int ack = s->getStatusReturnLevel();
 
-                if (s->getId() == id)
+                // Unregister device if it reach an error count too high
+                // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
+                if (s->getErrorCount() > 16)
                 {
-                    int ack = s->getStatusReturnLevel();
+                    TRACE_ERROR(DXL, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...\n", id, serialGetCurrentDevice().c_str());
+                    unregisterServo(s);
+                    continue;
+                }
 
-                    // Unregister device if it reach an error count too high
-                    // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
-                    if (s->getErrorCount() > 16)
-                    {
-                        TRACE_ERROR(DXL, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...\n", id, serialGetCurrentDevice().c_str());
-                        unregisterServo(s);
-                        continue;
-                    }
+                // Commit register modifications (only the registers flagged with a pending commit)
+                for (int ctid = s->getNextDirtyRegister(); ctid >= 0; ctid = s->getNextDirtyRegister(ctid + 1))
+                {
+                    int reg_name = getRegisterName(s->getControlTable(), ctid);
 
-                    // Commit register modifications
-                    for (int ctid = 0; ctid < s->getRegisterCount(); ctid++)
+                    if (s->getValueCommit(reg_name) == 1)
                     {
-                        int reg_name = getRegisterName(s->getControlTable(), ctid);
+                        int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
+                        int reg_size = getRegisterSize(s->getControlTable(), reg_name);
 
-                        if (s->getValueCommit(reg_name) == 1)
+                        if ((s->getSpeedMode() == SPEED_AUTO && (reg_name != REG_GOAL_POSITION && reg_name != REG_GOAL_SPEED)) == false)
                         {
-                            int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
-                            int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+                            TRACE_1(DXL, "Writing value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
+                                    s->getValue(reg_name), ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
 
-                            if ((s->getSpeedMode() == SPEED_AUTO && (reg_name != REG_GOAL_POSITION && reg_name != REG_GOAL_SPEED)) == false)
+                            if (reg_name == REG_ID)
                             {
-                                TRACE_1(DXL, "Writing value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
-                                        s->getValue(reg_name), ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
-
-                                if (reg_size == 1)
-                                {
-                                    dxl_write_byte(id, reg_addr, s->getValue(reg_name), ack);
-                                }
-                                else //if (regsize == 2)
-                                {
-                                    dxl_write_word(id, reg_addr, s->getValue(reg_name), ack);
-                                }
+                                // ID changes need the device answer, so they cannot be grouped
+                                dxl_write_byte(id, reg_addr, s->getValue(reg_name), ack);
 
                                 s->commitValue(reg_name, 0);
                                 s->setError(dxl_get_rxpacket_error());
                                 updateErrorCount(dxl_get_com_error_count());
                                 dxl_print_error();
 
-                                if (reg_name == REG_ID)
+                                if (s->changeInternalId(s->getValue(reg_name)) == 1)
                                 {
-                                    if (s->changeInternalId(s->getValue(reg_name)) == 1)
-                                    {
-                                        s->reboot();
-                                    }
+                                    s->reboot();
                                 }
                             }
+                            else
+                            {
+                                syncWriteQueue(syncWrites, id, reg_addr, reg_size, s->getValue(reg_name));
+                                s->commitValue(reg_name, 0);
+                            }
                         }
                     }
+                }
 
-                    // 1 Hz "low priority" update loop
-                    if (((syncloopCounter - cumulid) == 0) &&
-                        (ack != ACK_NO_REPLY))
+                // Planned register reads, for the devices not read by readFeedback()
+                if (feedbackRead[id] == false)
+                {
+                    for (size_t i = readsFirst[id]; i < readsLast[id]; i++)
                     {
-                        // Read voltage
-                        s->updateValue(REG_CURRENT_VOLTAGE, dxl_read_byte(id, s->gaddr(REG_CURRENT_VOLTAGE), ack));
-                        s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
-
-                        // Read temp
-                        s->updateValue(REG_CURRENT_TEMPERATURE, dxl_read_byte(id, s->gaddr(REG_CURRENT_TEMPERATURE), ack));
-                        s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
-                    }
+                        const ScheduledRead &r = reads[i];
+                        int reg_addr = s->gaddr(r.reg);
 
-                    // x/4 Hz "feedback" update loop
-                    if (((syncloopCounter - cumulid) % 4 == 0) &&
-                        (ack != ACK_NO_REPLY))
-                    {
-                        s->updateValue(REG_CURRENT_SPEED, dxl_read_word(id, s->gaddr(REG_CURRENT_SPEED), ack));
-                        s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
+                        if (reg_addr < 0)
+                        {
+                            continue;
+                        }
 
-                        s->updateValue(REG_CURRENT_LOAD, dxl_read_word(id, s->gaddr(REG_CURRENT_LOAD), ack));
-                        s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
+                        if (getRegisterSize(s->getControlTable(), r.reg) == 1)
+                        {
+                            s->updateValue(r.reg, dxl_read_byte(id, reg_addr, ack));
+                        }
+                        else
+                        {
+                            s->updateValue(r.reg, dxl_read_word(id, reg_addr, ack));
+                        }
 
-                        // Read moving
-                        s->updateValue(REG_MOVING, dxl_read_byte(id, s->gaddr(REG_MOVING), ack));
                         s->setError(dxl_get_rxpacket_error());
                         updateErrorCount(dxl_get_com_error_count());
                         dxl_print_error();
                     }
+                }
 
-                    // x Hz "full speed" update loop
+                // Position control
+                {
+                    int cpos = s->getCurrentPosition();
+
+                    // Goal pos
+                    if (s->getValueCommit(REG_GOAL_POSITION) == 1)
                     {
-                        // Get "current" values from devices, and write them into corresponding objects
-                        int cpos = dxl_read_word(id, s->gaddr(REG_CURRENT_POSITION), ack);
-                        s->updateValue(REG_CURRENT_POSITION, cpos);
-                        s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
+                        int gpos = s->getGoalPosition();
+                        int movingSpeed = 50; //s->getMovingSpeed();
 
-                        // Goal pos
-                        if (s->getValueCommit(REG_GOAL_POSITION) == 1)
+                        // Control modes:
+                        if (s->getSpeedMode() == SPEED_AUTO)
                         {
-                            int gpos = s->getGoalPosition();
-                            int movingSpeed = 50; //s->getMovingSpeed();
+                            double k = 1.0; // acceleration factor
+                            double mot = 3.0; // margin of tolerance
 
-                            // Control modes:
-                            if (s->getSpeedMode() == SPEED_AUTO)
+                            if (s->getCwAngleLimit() != 0 || s->getCcwAngleLimit() != 0) // JOINT MODE
                             {
-                                double k = 1.0; // acceleration factor
-                                double mot = 3.0; // margin of tolerance
+                                double step = static_cast<double>(s->getRunningDegrees()) / s->getSteps();
+                                double angle = static_cast<double>(gpos - cpos) * step;
+                                double angle_abs = std::fabs(angle);
+                                int speed = (movingSpeed + static_cast<int>(k * angle_abs));
 
-                                if (s->getCwAngleLimit() != 0 || s->getCcwAngleLimit() != 0) // JOINT MODE
+                                if (angle_abs > mot)
                                 {
-                                    double step = static_cast<double>(s->getRunningDegrees()) / s->getSteps();
-                                    double angle = static_cast<double>(gpos - cpos) * step;
-                                    double angle_abs = std::fabs(angle);
-                                    int speed = (movingSpeed + static_cast<int>(k * angle_abs));
+                                    // SPEED
+                                    syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_SPEED), 2, speed);
 
-                                    if (angle_abs > mot)
+                                    // POS
+                                    if (angle >= 0)
                                     {
-                                        // SPEED
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-                                        s->setError(dxl_get_rxpacket_error());
-
-                                        // POS
-                                        if (angle >= 0)
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getSteps() - 1, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-                                        else
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), 0, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-
-                                        TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, s->getCurrentSpeed(), gpos, angle);
+                                        syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_POSITION), 2, s->getSteps() - 1);
                                     }
-                                    else // STOP
+                                    else
                                     {
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), movingSpeed, ack);
-                                        s->setError(dxl_get_rxpacket_error());
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getGoalPosition(), ack);
-                                        s->setError(dxl_get_rxpacket_error());
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-
-                                        TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, gpos, angle);
-                                        s->commitValue(REG_GOAL_POSITION, 0);
+                                        syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_POSITION), 2, 0);
                                     }
+
+                                    TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
+                                            cpos, speed, s->getCurrentSpeed(), gpos, angle);
                                 }
-                                else // if (s->getCwAngleLimit() == 0 && s->getCcwAngleLimit() == 0) // WHEEL MODE
+                                else // STOP
                                 {
-                                    double step = 360.0 / s->getSteps();
-                                    double angle = static_cast<double>(gpos - cpos) * step;
+                                    syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_SPEED), 2, movingSpeed);
+
+                                    syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_POSITION), 2, s->getGoalPosition());
+
+                                    TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
+                                            cpos, speed, gpos, angle);
+                                    s->commitValue(REG_GOAL_POSITION, 0);
+                                }
+                            }
+                            else // if (s->getCwAngleLimit() == 0 && s->getCcwAngleLimit() == 0) // WHEEL MODE
+                            {
+                                double step = 360.0 / s->getSteps();
+                                double angle = static_cast<double>(gpos - cpos) * step;
 
-                                    if (angle > 180) angle -= 360;
-                                    else if (angle < -180) angle += 360;
-                                    double angle_abs = std::fabs(angle);
+                                if (angle > 180) angle -= 360;
+                                else if (angle < -180) angle += 360;
+                                double angle_abs = std::fabs(angle);
 
-                                    int speed = (movingSpeed + static_cast<int>(k * angle_abs));
+                                int speed = (movingSpeed + static_cast<int>(k * angle_abs));
 
-                                    if (angle_abs > mot)
+                                if (angle_abs > mot)
+                                {
+                                    if (angle >= 0)
                                     {
-                                        if (angle >= 0)
-                                        {
-                                            // SPEED (counter clockwise)
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-                                        else
-                                        {
-                                            // SPEED (clockwise)
-                                            speed +=  1024;
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-
-                                        TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, s->getCurrentSpeed(), gpos, angle);
+                                        // SPEED (counter clockwise)
+                                        syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_SPEED), 2, speed);
                                     }
-                                    else // STOP
+                                    else
                                     {
-                                        if (dxl_read_word(id, s->gaddr(REG_GOAL_SPEED), ack) >= 1024)
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), ack, 1024);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-                                        else
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), 0, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getGoalPosition(), ack);
-                                        s->setError(dxl_get_rxpacket_error());
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-
-                                        TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, gpos, angle);
-                                        s->commitValue(REG_GOAL_POSITION, 0);
+                                        // SPEED (clockwise)
+                                        speed +=  1024;
+                                        syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_SPEED), 2, speed);
                                     }
+
+                                    TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
+                                            cpos, speed, s->getCurrentSpeed(), gpos, angle);
                                 }
-                            }
-                            else if (s->getSpeedMode() == SPEED_MANUAL)
-                            {
-                                if (s->getCwAngleLimit() == 0 || s->getCcwAngleLimit() == 0) // WHEEL MODE
+                                else // STOP
                                 {
-                                    // WIP // Do we want to handle this on the framework side ?
+                                    if (dxl_read_word(id, s->gaddr(REG_GOAL_SPEED), ack) >= 1024)
+                                    {
+                                        syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_SPEED), 2, 1024);
+                                    }
+                                    else
+                                    {
+                                        syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_SPEED), 2, 0);
+                                    }
+
+                                    syncWriteQueue(syncWrites, id, s->gaddr(REG_GOAL_POSITION), 2, s->getGoalPosition());
+
+                                    TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
+                                            cpos, speed, gpos, angle);
+                                    s->commitValue(REG_GOAL_POSITION, 0);
                                 }
                             }
                         }
+                        else if (s->getSpeedMode() == SPEED_MANUAL)
+                        {
+                            if (s->getCwAngleLimit() == 0 || s->getCcwAngleLimit() == 0) // WHEEL MODE
+                            {
+                                // WIP // Do we want to handle this on the framework side ?
+                            }
+                        }
                     }
                 }
-
-                servoListLock.lock();
             }
         }
-
-        // Make sure we unlock servoList
         servoListLock.unlock();
 
-        // Loop control
-        syncloopCounter++;
-        syncloopCounter %= syncloopFrequency;
+        // Staged commit: the goal registers of each device are sent with a
+        // REG_WRITE, and all released at once by a single broadcast ACTION.
+        // A device only keeps one staged write, so only a contiguous range can
+        // be staged, anything else is committed immediately.
+        int stagedCount = 0;
 
-        // Loop timer
-        end = std::chrono::system_clock::now();
-        double loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
-        double waitd = (syncloopDuration * 1000.0) - loopd;
+        if (staged == true)
+        {
+            servoListLock.lock();
+            for (auto id: syncList)
+            {
+                // Devices answering every instruction would answer each REG_WRITE,
+                // so their goal registers go through the regular grouped writes
+                Servo *s = findServo_internal(id);
+                if (s == NULL || s->getStatusReturnLevel() == ACK_REPLY_ALL)
+                {
+                    continue;
+                }
 
-#ifdef LATENCY_TIMER
-        if ((loopd / 1000.0) > syncloopDuration)
+                const int goalRegs[2] = {REG_GOAL_POSITION, REG_GOAL_SPEED};
+                unsigned char data[8];
+                int start = -1, length = 0;
+
+                for (int r = 0; r < 2; r++)
+                {
+                    int addr = s->gaddr(goalRegs[r]);
+                    int size = 0, value = 0;
+
+                    if (addr < 0 || (start >= 0 && addr != start + length))
+                    {
+                        break;
+                    }
+
+                    if (syncWriteTake(syncWrites, s->getId(), addr, size, value) == 1)
+                    {
+                        if (start < 0)
+                        {
+                            start = addr;
+                        }
+                        for (int b = 0; b < size && length < 8; b++)
+                        {
+                            data[length++] = static_cast<unsigned char>((value >> (8 * b)) & 0xFF);
+                        }
+                    }
+                    else if (start >= 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (length > 0)
+                {
+                    // Like the broadcast ACTION releasing it, the staged write is not acknowledged
+                    dxl_reg_write(s->getId(), start, length, data, ACK_NO_REPLY);
+                    updateErrorCount(dxl_get_com_error_count());
+                    stagedCount++;
+                }
+            }
+            servoListLock.unlock();
+        }
+
+        // Commit the grouped register writes: contiguous registers of a device
+        // are merged first, then one SYNC_WRITE is sent per register range
+        // written on several devices. With protocol v2, the remaining
+        // single-device writes all go out in one BULK_WRITE.
+        syncWriteMerge(syncWrites);
+
+        std::vector <int> bulkIds, bulkAddrs, bulkSizes, bulkValues;
+
+        for (auto const &g: syncWrites)
         {
-            TRACE_WARNING(DXL, "Sync loop duration: %fms of the %fms budget.\n", (loopd / 1000.0), syncloopDuration);
+            if (g.ids.empty() == true)
+            {
+                continue;
+            }
+
+            if (protocolVersion == 2 && g.ids.size() == 1)
+            {
+                bulkIds.push_back(g.ids.front());
+                bulkAddrs.push_back(g.addr);
+                bulkSizes.push_back(g.size);
+                bulkValues.push_back(g.values.front());
+            }
+            else
+            {
+                dxl_sync_write(g.ids, g.addr, g.size, g.values);
+                updateErrorCount(dxl_get_com_error_count());
+            }
         }
-        else
+
+        if (bulkIds.empty() == false)
         {
-            TRACE_INFO(DXL, "Sync loop duration: %fms of the %fms budget.\n", (loopd / 1000.0), syncloopDuration);
+            dxl_bulk_write(bulkIds, bulkAddrs, bulkSizes, bulkValues);
+            updateErrorCount(dxl_get_com_error_count());
         }
-#endif
 
-        if (waitd > 0.0)
+        if (stagedCount > 0)
         {
-            std::chrono::microseconds waittime(static_cast<int>(waitd));
-            std::this_thread::sleep_for(waittime);
+            dxl_action(BROADCAST_ID, ACK_NO_REPLY);
         }
+
+        // Send whatever is left in the batch
+        serialSetTxBatching(false);
+
+        // Loop control
+        syncloopCounter++;
+        syncloopCounter %= syncloopFrequency;
+
+        // Loop timer
+        syncloopWait();
     }
 
     TRACE_INFO(DXL, ">> THREAD (tid: '%i') termination by 'loop exit'\n", std::this_thread::get_id());
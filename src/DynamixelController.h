@@ -32,6 +32,7 @@
 #include "ServoMX.h"
 #include "ServoXL.h"
 
+#include <atomic>
 #include <vector>
 
 /** \addtogroup ManagedAPIs
@@ -51,12 +52,43 @@
  */
 class DynamixelController: public Dynamixel, public ControllerAPI
 {
+    std::atomic <bool> stagedCommit; //!< Send the goal registers with REG_WRITE, and release them all at once with a broadcast ACTION.
+
+    bool feedbackRead[BROADCAST_ID]; //!< Devices already read by readFeedback() during the current cycle.
+    size_t readsFirst[BROADCAST_ID]; //!< First planned read of each device during the current cycle (index in the reads list).
+    size_t readsLast[BROADCAST_ID];  //!< Last planned read of each device during the current cycle (index in the reads list, excluded).
+
     //! Compute some internal settings (ackPolicy, maxId, protocolVersion) depending on current servo serie and serial device.
     void updateInternalSettings();
 
     //! Read/write synchronization loop, running inside its own background thread
     void run();
 
+    /*!
+     * \brief Plan the register reads of the current cycle, using the register scheduler.
+     * \param staged: True if the goal registers are committed with REG_WRITE and ACTION this cycle.
+     * \param[out] reads: The registers to read, grouped by device.
+     *
+     * The cost of each read is estimated from the serial link speed: a register
+     * read through SYNC_READ or BULK_READ only costs its own bytes once its
+     * device is part of the instruction, while a register read individually
+     * costs a whole READ exchange. With staged commits, the REG_WRITE and ACTION
+     * packets of the cycle are taken out of the read budget first.
+     */
+    void planReads(const bool staged, std::vector <ScheduledRead> &reads);
+
+    /*!
+     * \brief Read the planned registers of the synced devices with a single SYNC_READ or BULK_READ instruction.
+     * \param reads: The registers to read, grouped by device.
+     * \param[out] ids: The devices that answered. The others still need to be read individually.
+     *
+     * The planned registers of each device are read as one contiguous range.
+     * With protocol v2, devices reading the same range of the same control
+     * table use SYNC_READ, and the others use BULK_READ. With protocol v1, only
+     * the MX series implements BULK_READ, so other devices are left out.
+     */
+    void readFeedback(const std::vector <ScheduledRead> &reads, std::vector <int> &ids);
+
 public:
     /*!
      * \brief DynamixelController constructor.
@@ -76,6 +108,28 @@ public:
      */
     void changeProtocolVersion(int protocol);
 
+    /*!
+     * \brief Enable or disable the staged commit mode.
+     * \param enabled: Stage the goal position and goal speed writes, then start every device at once.
+     *
+     * In staged commit mode, the goal position and goal speed of each device
+     * are sent with a REG_WRITE instruction, and a single broadcast ACTION then
+     * executes them simultaneously at the end of each synchronization cycle.
+     * This aligns the start of the movements across devices, even with firmwares
+     * not supporting SYNC_WRITE.
+     *
+     * Staged writes are not acknowledged, so only the devices whose status return
+     * level is below ACK_REPLY_ALL are staged. The goal registers of the other
+     * devices are committed immediately, like without staged commit.
+     */
+    void setStagedCommit(bool enabled);
+
+    /*!
+     * \brief Get the staged commit mode.
+     * \return True if the goal writes are staged and released by a broadcast ACTION.
+     */
+    bool getStagedCommit();
+
     /*!
      * \brief Connect the controller to a serial port, if the connection is successfull start a synchronization thread.
      * \param devicePath: The serial port device node.
@@ -0,0 +1,388 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file DynamixelParser.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+
+#include "DynamixelParser.h"
+#include "DynamixelTools.h"
+
+// C++ standard libraries
+#include <cstring>
+#include <algorithm>
+
+/* ************************************************************************** */
+
+/*!
+ * \brief The different states of the parser, following the fields of a packet.
+ */
+enum DynamixelParserState_e
+{
+    STATE_HEADER0       = 0,    //!< Waiting for the first 0xFF
+    STATE_HEADER1       = 1,    //!< Waiting for the second 0xFF
+    STATE_HEADER2       = 2,    //!< Waiting for 0xFD (protocol v2 only)
+    STATE_RESERVED      = 3,    //!< Waiting for 0x00 (protocol v2 only)
+    STATE_ID            = 4,
+    STATE_LENGTH_L      = 5,    //!< Length (protocol v1) or length low byte (protocol v2)
+    STATE_LENGTH_H      = 6,    //!< Length high byte (protocol v2 only)
+    STATE_PAYLOAD       = 7,    //!< Instruction (or error) and parameters
+    STATE_CHECKSUM_L    = 8,    //!< Checksum (protocol v1) or CRC low byte (protocol v2)
+    STATE_CHECKSUM_H    = 9     //!< CRC high byte (protocol v2 only)
+};
+
+/* ************************************************************************** */
+
+DynamixelParser::DynamixelParser(const int protocolVersion):
+    protocolVersion(protocolVersion),
+    state(STATE_HEADER0),
+    frame(MAX_PACKET_LENGTH_dxlv1, 0),
+    frameSize(0),
+    payloadLeft(0),
+    stuffPending(false),
+    checksum(0),
+    frameCount(0),
+    errorCount(0)
+{
+    //
+}
+
+void DynamixelParser::setProtocolVersion(const int protocolVersion)
+{
+    if (this->protocolVersion != protocolVersion)
+    {
+        this->protocolVersion = protocolVersion;
+        reset();
+    }
+}
+
+void DynamixelParser::reset()
+{
+    state = STATE_HEADER0;
+}
+
+void DynamixelParser::clear()
+{
+    reset();
+    frameSize = 0;
+    std::fill(frame.begin(), frame.end(), 0);
+}
+
+void DynamixelParser::startFrame()
+{
+    frameSize = 0;
+    payloadLeft = 0;
+    stuffPending = false;
+    checksum = 0;
+}
+
+void DynamixelParser::storeByte(const unsigned char byte)
+{
+    frame[frameSize++] = byte;
+}
+
+int DynamixelParser::startPayload()
+{
+    if (protocolVersion == 2)
+    {
+        int length = frame[5] | (frame[6] << 8);
+
+        if (length < 3 || (length + 7) > MAX_PACKET_LENGTH_dxlv2)
+        {
+            return endFrame(false);
+        }
+
+        // Large packets only: the storage is never shrinked, so this allocates once per size
+        if (static_cast<int>(frame.size()) < (length + 7))
+        {
+            frame.resize(length + 7);
+        }
+
+        // Instruction (or error) and parameters, then the CRC
+        payloadLeft = length - 2;
+        checksum = dxl2_crc16(0, frame.data(), 7);
+    }
+    else
+    {
+        int length = frame[3];
+
+        if (length < 2 || (length + 4) > MAX_PACKET_LENGTH_dxlv1)
+        {
+            return endFrame(false);
+        }
+
+        // Error (or instruction) and parameters, then the checksum
+        payloadLeft = length - 1;
+        checksum = static_cast<unsigned short>(frame[2] + frame[3]);
+    }
+
+    state = STATE_PAYLOAD;
+    return PARSER_WAITING;
+}
+
+int DynamixelParser::endFrame(const bool valid)
+{
+    state = STATE_HEADER0;
+
+    if (valid == false)
+    {
+        errorCount++;
+        return PARSER_CORRUPT;
+    }
+
+    if (protocolVersion == 2)
+    {
+        // The length field now matches the unstuffed content
+        int length = frameSize - 7;
+        frame[5] = static_cast<unsigned char>(length & 0xFF);
+        frame[6] = static_cast<unsigned char>((length >> 8) & 0xFF);
+    }
+
+    frameCount++;
+    return PARSER_FRAME;
+}
+
+int DynamixelParser::parse(const unsigned char *data, const int size, int &consumed)
+{
+    int status = PARSER_WAITING;
+    int i = 0;
+
+    while (i < size && status == PARSER_WAITING)
+    {
+        if (state == STATE_PAYLOAD)
+        {
+            // Consume as much of the payload as available in one go
+            int count = std::min(payloadLeft, size - i);
+
+            if (protocolVersion == 2)
+            {
+                checksum = dxl2_crc16(checksum, &data[i], count);
+
+                // Copy the payload by runs ending on a 0xFD, the only places
+                // where a stuffing byte may follow
+                int j = i;
+                while (j < i + count)
+                {
+                    if (stuffPending == true)
+                    {
+                        stuffPending = false;
+
+                        // Drop the 0xFD added after a 0xFF 0xFF 0xFD sequence
+                        if (data[j] == 0xFD)
+                        {
+                            j++;
+                            continue;
+                        }
+                    }
+
+                    const unsigned char *fd = static_cast<const unsigned char *>(memchr(&data[j], 0xFD, i + count - j));
+                    int run = (fd != NULL) ? static_cast<int>(fd - &data[j]) + 1 : (i + count - j);
+
+                    memcpy(&frame[frameSize], &data[j], run);
+                    frameSize += run;
+                    j += run;
+
+                    if (fd != NULL && frameSize >= 10 &&
+                        frame[frameSize - 2] == 0xFF && frame[frameSize - 3] == 0xFF)
+                    {
+                        stuffPending = true;
+                    }
+                }
+            }
+            else
+            {
+                for (int j = i; j < i + count; j++)
+                {
+                    checksum += data[j];
+                }
+
+                memcpy(&frame[frameSize], &data[i], count);
+                frameSize += count;
+            }
+
+            i += count;
+            payloadLeft -= count;
+
+            if (payloadLeft == 0)
+            {
+                state = STATE_CHECKSUM_L;
+            }
+
+            continue;
+        }
+
+        if (state == STATE_HEADER0)
+        {
+            // Skip the line noise up to the next possible header in one go
+            const unsigned char *ff = static_cast<const unsigned char *>(memchr(&data[i], 0xFF, size - i));
+            if (ff == NULL)
+            {
+                i = size;
+                break;
+            }
+            i = static_cast<int>(ff - data);
+
+            // Whole header available: no need to go through the states one byte at a time
+            const int headerSize = (protocolVersion == 2) ? 7 : 4;
+            if ((size - i) >= headerSize && data[i + 1] == 0xFF &&
+                ((protocolVersion == 2) ? (data[i + 2] == 0xFD && data[i + 3] == 0x00)
+                                        : (data[i + 2] != 0xFF)))
+            {
+                startFrame();
+                memcpy(&frame[0], &data[i], headerSize);
+                frameSize = headerSize;
+                i += headerSize;
+                status = startPayload();
+                continue;
+            }
+        }
+
+        const unsigned char byte = data[i++];
+
+        switch (state)
+        {
+        case STATE_HEADER0:
+            if (byte == 0xFF)
+            {
+                startFrame();
+                storeByte(byte);
+                state = STATE_HEADER1;
+            }
+            break;
+
+        case STATE_HEADER1:
+            if (byte == 0xFF)
+            {
+                storeByte(byte);
+                state = (protocolVersion == 2) ? STATE_HEADER2 : STATE_ID;
+            }
+            else
+            {
+                state = STATE_HEADER0;
+            }
+            break;
+
+        case STATE_HEADER2:
+            if (byte == 0xFD)
+            {
+                storeByte(byte);
+                state = STATE_RESERVED;
+            }
+            else if (byte != 0xFF)
+            {
+                state = STATE_HEADER0;
+            }
+            break;
+
+        case STATE_RESERVED:
+            if (byte == 0x00)
+            {
+                storeByte(byte);
+                state = STATE_ID;
+            }
+            else if (byte == 0xFF)
+            {
+                // This may be the beginning of the real header
+                startFrame();
+                storeByte(byte);
+                state = STATE_HEADER1;
+            }
+            else
+            {
+                state = STATE_HEADER0;
+            }
+            break;
+
+        case STATE_ID:
+            if (protocolVersion == 1 && byte == 0xFF)
+            {
+                // More than two 0xFF, the header ends later
+                break;
+            }
+            storeByte(byte);
+            state = STATE_LENGTH_L;
+            break;
+
+        case STATE_LENGTH_L:
+            storeByte(byte);
+
+            if (protocolVersion == 2)
+            {
+                state = STATE_LENGTH_H;
+            }
+            else
+            {
+                status = startPayload();
+            }
+            break;
+
+        case STATE_LENGTH_H:
+            storeByte(byte);
+            status = startPayload();
+            break;
+
+        case STATE_CHECKSUM_L:
+            storeByte(byte);
+
+            if (protocolVersion == 2)
+            {
+                state = STATE_CHECKSUM_H;
+            }
+            else
+            {
+                status = endFrame(byte == static_cast<unsigned char>(~checksum & 0xFF));
+            }
+            break;
+
+        case STATE_CHECKSUM_H:
+            storeByte(byte);
+            status = endFrame(frame[frameSize - 2] == (checksum & 0xFF) &&
+                              frame[frameSize - 1] == ((checksum >> 8) & 0xFF));
+            break;
+        }
+    }
+
+    consumed = i;
+    return status;
+}
+
+int DynamixelParser::getProgress() const
+{
+    return (state == STATE_HEADER0) ? 0 : frameSize;
+}
+
+unsigned char *DynamixelParser::getFrame()
+{
+    return frame.data();
+}
+
+int DynamixelParser::getFrameSize() const
+{
+    return frameSize;
+}
+
+unsigned DynamixelParser::getFrameCount() const
+{
+    return frameCount;
+}
+
+unsigned DynamixelParser::getErrorCount() const
+{
+    return errorCount;
+}
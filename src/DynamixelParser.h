@@ -0,0 +1,148 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file DynamixelParser.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+
+#ifndef DYNAMIXEL_PARSER_H
+#define DYNAMIXEL_PARSER_H
+
+// C++ standard libraries
+#include <vector>
+
+/** \addtogroup Tools
+ *  @{
+ */
+
+/*!
+ * \brief Result of DynamixelParser::parse().
+ */
+enum DynamixelParserStatus_e
+{
+    PARSER_WAITING      = 0,    //!< The current frame is not complete yet, more bytes are needed.
+    PARSER_FRAME        = 1,    //!< A complete and valid frame is available.
+    PARSER_CORRUPT      = 2     //!< A frame has been dropped (invalid length or checksum).
+};
+
+/*!
+ * \brief The DynamixelParser class, a resumable streaming parser for Dynamixel packets.
+ *
+ * Bytes are fed to the parser as they arrive from the serial link, in chunks of
+ * any size. Each byte is only consumed once: header synchronization, length,
+ * protocol v2 byte unstuffing and checksum (or CRC) verification are all done
+ * on the fly by a state machine, which resumes where it left off on the next call.
+ *
+ * The parser stops right after the end of each frame, so the bytes that follow
+ * (the next status packets of a SYNC_READ or BULK_READ answer, for instance)
+ * stay available to the caller. As instruction and status packets share the
+ * same format, it can also be used to decode traffic for a passive bus monitor.
+ *
+ * Frames are stored unstuffed, with their original header, and a length field
+ * matching their unstuffed content. The frame storage is sized for protocol v1
+ * packets at construction, and only grows for larger protocol v2 packets.
+ */
+class DynamixelParser
+{
+    int protocolVersion;        //!< Version of the communication protocol to parse.
+    int state;                  //!< Current state of the parser.
+
+    std::vector <unsigned char> frame; //!< Frame storage.
+    int frameSize;              //!< Number of byte(s) currently stored into the frame.
+    int payloadLeft;            //!< Number of byte(s) of instruction and parameters left to receive (stuffed).
+    bool stuffPending;          //!< The stored payload ends with a 0xFF 0xFF 0xFD sequence, so the next byte is a stuffing byte.
+    unsigned short checksum;    //!< Running checksum (protocol v1) or CRC (protocol v2) of the frame.
+
+    unsigned frameCount;        //!< Number of valid frames parsed.
+    unsigned errorCount;        //!< Number of frames dropped.
+
+    void startFrame();
+    void storeByte(const unsigned char byte);
+    int startPayload();
+    int endFrame(const bool valid);
+
+public:
+    /*!
+     * \brief DynamixelParser constructor.
+     * \param protocolVersion: The version of the communication protocol to parse.
+     */
+    DynamixelParser(const int protocolVersion = 1);
+
+    /*!
+     * \brief Change the version of the communication protocol to parse.
+     * \param protocolVersion: 1 or 2.
+     *
+     * The current frame (if any) is dropped when the version changes.
+     */
+    void setProtocolVersion(const int protocolVersion);
+
+    /*!
+     * \brief Drop the current frame (if any) and wait for a new header.
+     */
+    void reset();
+
+    /*!
+     * \brief Reset the parser and erase the last frame.
+     */
+    void clear();
+
+    /*!
+     * \brief Feed bytes to the parser.
+     * \param[in] data: The bytes to parse.
+     * \param size: The number of byte(s) available.
+     * \param[out] consumed: The number of byte(s) consumed by the parser.
+     * \return The parser status, from the DynamixelParserStatus_e enum.
+     *
+     * Parsing stops right after the end of a frame (valid or not), so 'consumed'
+     * can be lower than 'size'. The frame stays available until the next call.
+     */
+    int parse(const unsigned char *data, const int size, int &consumed);
+
+    /*!
+     * \brief Get the number of byte(s) of the current frame received so far.
+     * \return 0 if the parser is still looking for a frame header.
+     */
+    int getProgress() const;
+
+    /*!
+     * \brief Get the last frame parsed.
+     * \return A pointer to the frame storage. Only valid until the next call to parse().
+     */
+    unsigned char *getFrame();
+
+    /*!
+     * \brief Get the size of the last frame parsed.
+     * \return The size (in byte) of the frame, unstuffed.
+     */
+    int getFrameSize() const;
+
+    /*!
+     * \brief Get the number of valid frames parsed since the parser creation.
+     */
+    unsigned getFrameCount() const;
+
+    /*!
+     * \brief Get the number of frames dropped since the parser creation.
+     */
+    unsigned getErrorCount() const;
+};
+
+/** @}*/
+
+#endif /* DYNAMIXEL_PARSER_H */
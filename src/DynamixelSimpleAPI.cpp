@@ -116,7 +116,15 @@ DynamixelSimpleAPI::~DynamixelSimpleAPI()
 int DynamixelSimpleAPI::connect(std::string &devicePath, const int baud, const int serialDevice)
 {
     this->serialDevice = serialDevice;
-    return serialInitialize(devicePath, baud);
+    int retcode = serialInitialize(devicePath, baud);
+
+    // The USB2AX adapter (specified or autodetected) uses the ID 253 for itself
+    if (this->serialDevice == SERIAL_USB2AX && protocolVersion == 1 && maxId > 252)
+    {
+        maxId = 252;
+    }
+
+    return retcode;
 }
 
 void DynamixelSimpleAPI::disconnect()
@@ -160,38 +168,32 @@ std::vector <int> DynamixelSimpleAPI::servoScan(int start, int stop)
     TRACE_INFO(DAPI, "> Scanning for Dynamixel devices on '%s'... Range is [%i,%i]\n",
                serialGetCurrentDevice().c_str(), start, stop);
 
-    // A vector of Dynamixel IDs found during the scan
+    // A vector of Dynamixel IDs found during the scan, and their ping responses
     std::vector <int> ids;
+    std::vector <PingResponse> pings;
 
-    for (int id = start; id <= stop; id++)
-    {
-        PingResponse pingstats;
+    dxl_scan(start, stop, ids, pings);
 
-        // If the ping gets a response, then we have found a servo
-        if (dxl_ping(id, &pingstats) == true)
-        {
-            setLed(id, 1, LED_GREEN);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        const int id = ids.at(i);
+        const PingResponse &pingstats = pings.at(i);
 
-            ids.push_back(id);
+        setLed(id, 1, LED_GREEN);
 
-            TRACE_INFO(DAPI, "[#%i] Dynamixel servo found!\n", id);
-            TRACE_INFO(DAPI, "[#%i] model: '%i' (%s)\n", id, pingstats.model_number,
-                       dxl_get_model_name(pingstats.model_number).c_str());
+        TRACE_INFO(DAPI, "[#%i] Dynamixel servo found!\n", id);
+        TRACE_INFO(DAPI, "[#%i] model: '%i' (%s)\n", id, pingstats.model_number,
+                   dxl_get_model_name(pingstats.model_number).c_str());
 
-            // Other informations, not printed by default:
-            TRACE_1(DAPI, "[#%i] firmware: '%i' \n", id, pingstats.firmware_version);
-            TRACE_1(DAPI, "[#%i] position: '%i' \n", id, readCurrentPosition(id));
-            TRACE_1(DAPI, "[#%i] speed: '%i' \n", id, readCurrentSpeed(id));
-            TRACE_1(DAPI, "[#%i] torque: '%i' \n", id, getTorqueEnabled(id));
-            TRACE_1(DAPI, "[#%i] load: '%i' \n", id, readCurrentLoad(id));
-            TRACE_1(DAPI, "[#%i] baudrate: '%i' \n", id, getSetting(id, REG_BAUD_RATE));
+        // Other informations, not printed by default:
+        TRACE_1(DAPI, "[#%i] firmware: '%i' \n", id, pingstats.firmware_version);
+        TRACE_1(DAPI, "[#%i] position: '%i' \n", id, readCurrentPosition(id));
+        TRACE_1(DAPI, "[#%i] speed: '%i' \n", id, readCurrentSpeed(id));
+        TRACE_1(DAPI, "[#%i] torque: '%i' \n", id, getTorqueEnabled(id));
+        TRACE_1(DAPI, "[#%i] load: '%i' \n", id, readCurrentLoad(id));
+        TRACE_1(DAPI, "[#%i] baudrate: '%i' \n", id, getSetting(id, REG_BAUD_RATE));
 
-            setLed(id, 0);
-        }
-        else
-        {
-            printf(".");
-        }
+        setLed(id, 0);
     }
 
     printf("\n");
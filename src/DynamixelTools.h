@@ -112,4 +112,16 @@ int dxl_get_servo_model(const int model_number);
  */
 int dxl_get_baudrate(const int baudnum, const int servo_serie = SERVO_AX);
 
+/*!
+ * \brief Update a Dynamixel protocol v2 CRC16 with a block of data.
+ * \param crc: The CRC of the data already processed (0 to start a new packet).
+ * \param data: The data to add to the CRC.
+ * \param size: The size (in byte) of the data.
+ * \return The updated CRC.
+ *
+ * A packet CRC covers every byte from the header to the last parameter. It can
+ * be computed in one call, or updated as the bytes of the packet arrive.
+ */
+unsigned short dxl2_crc16(unsigned short crc, const unsigned char *data, const int size);
+
 #endif /* DYNAMIXEL_TOOLS_H */
@@ -108,20 +108,18 @@ int HerkuleX::serialInitialize(std::string &devicePath, const int baud)
         serialTerminate();
     }
 
-    // Instanciate a different serial subclass, depending on the current OS
-#if defined(__linux__) || defined(__gnu_linux)
-    serial = new SerialPortLinux(devicePath, baud, serialDevice, SERVO_DRS);
-#elif defined(_WIN32) || defined(_WIN64)
-    serial = new SerialPortWindows(devicePath, baud, serialDevice, SERVO_DRS);
-#elif defined(__APPLE__) || defined(__MACH__)
-    serial = new SerialPortMacOS(devicePath, baud, serialDevice, SERVO_DRS);
-#else
-    #error "No compatible operating system detected!"
-#endif
+    // Instanciate the serial backend matching the device path (the OS serial port by default)
+    serial = createSerialPort(devicePath, baud, serialDevice, SERVO_DRS);
 
     // Initialize the serial link
     if (serial != NULL)
     {
+        // Use the adapter type autodetected by the serial backend, if not specified
+        if (serialDevice == SERIAL_UNKNOWN)
+        {
+            serialDevice = serial->getSerialDevice();
+        }
+
         status = serial->openLink();
 
         if (status > 0)
@@ -168,6 +166,18 @@ std::string HerkuleX::serialGetCurrentDevice()
     return serialName;
 }
 
+int HerkuleX::serialGetBaudRate()
+{
+    int baudRate = 0;
+
+    if (serial != NULL)
+    {
+        baudRate = serial->getDeviceBaudRate();
+    }
+
+    return baudRate;
+}
+
 std::vector <std::string> HerkuleX::serialGetAvailableDevices()
 {
     std::vector <std::string> devices;
@@ -189,6 +199,31 @@ void HerkuleX::serialSetLatency(int latency)
     serial->setLatency(latency);
 }
 
+bool HerkuleX::serialSwitchHighSpeed()
+{
+    bool status = false;
+
+    if (serial != NULL)
+    {
+        status = serial->switchHighSpeed();
+    }
+
+    return status;
+}
+
+void HerkuleX::serialSetAdaptiveTimeOut(bool enabled)
+{
+    serial->setAdaptiveTimeOut(enabled);
+}
+
+void HerkuleX::serialSetTxBatching(bool enabled)
+{
+    if (serial != NULL)
+    {
+        serial->setTxBatching(enabled);
+    }
+}
+
 void HerkuleX::setAckPolicy(int ack)
 {
     if (ackPolicy >= ACK_NO_REPLY && ack <= ACK_REPLY_ALL)
@@ -201,7 +236,7 @@ void HerkuleX::setAckPolicy(int ack)
     }
 }
 
-void HerkuleX::hkx_tx_packet()
+void HerkuleX::hkx_tx_packet(bool reply)
 {
     if (serial == NULL)
     {
@@ -238,7 +273,20 @@ void HerkuleX::hkx_tx_packet()
     // Send packet
     if (serial != NULL)
     {
-        txPacketSizeSent = serial->tx(txPacket, txPacketSize);
+        if (serial->getTxBatching() == true)
+        {
+            // Queue the packet, and send the whole batch if we need an answer to this one
+            txPacketSizeSent = serial->txBufferPush(txPacket, txPacketSize);
+
+            if (reply == true && serial->txBufferFlush() < 0)
+            {
+                txPacketSizeSent = 0;
+            }
+        }
+        else
+        {
+            txPacketSizeSent = serial->tx(txPacket, txPacketSize);
+        }
     }
     else
     {
@@ -258,11 +306,11 @@ void HerkuleX::hkx_tx_packet()
     // Min size of an RX packet is 9
     if (txPacket[PKT_CMD] == CMD_EEP_READ || txPacket[PKT_CMD] == CMD_RAM_READ)
     {
-        serial->setTimeOut(9 + txPacket[PKT_DATA+1]);
+        serial->setTimeOut(9 + txPacket[PKT_DATA+1], txPacket[PKT_ID]);
     }
     else
     {
-        serial->setTimeOut(9);
+        serial->setTimeOut(9, txPacket[PKT_ID]);
     }
 
     commStatus = COMM_TXSUCCESS;
@@ -298,94 +346,68 @@ void HerkuleX::hkx_rx_packet()
         rxPacketSizeReceived = 0;
     }
 
-    // Receive packet
-    int nRead = 0;
-    if (serial != NULL)
-    {
-        nRead = serial->rx((unsigned char*)&rxPacket[rxPacketSizeReceived], rxPacketSize - rxPacketSizeReceived);
-        rxPacketSizeReceived += nRead;
+    // Receive everything available on the serial link
+    serial->rxBufferFill();
 
-        // Check if we received the whole packet
-        if (rxPacketSizeReceived < rxPacketSize)
-        {
-            if (serial->checkTimeOut() == 1)
-            {
-                if (rxPacketSizeReceived == 0)
-                {
-                    commStatus = COMM_RXTIMEOUT;
-                }
-                else
-                {
-                    commStatus = COMM_RXCORRUPT;
-                }
-
-                commLock = 0;
-                return;
-            }
-        }
-    }
-    else
+    // Find packet header, dropping the bytes in front of it
+    while (serial->rxBufferAvailable() >= 2 &&
+           !(serial->rxBufferPeek(0) == 0xFF &&
+             serial->rxBufferPeek(1) == 0xFF))
     {
-        TRACE_ERROR(HKX, "Serial interface has been destroyed!\n");
-        return;
+        serial->rxBufferDrop(1);
     }
 
-    // Find packet header
-    unsigned char i, j;
-    for (i = 0; i < (rxPacketSizeReceived - 1); i++)
+    rxPacketSizeReceived = serial->rxBufferAvailable();
+
+    // Read ID and length fields once we have at least a minimal packet
+    if (rxPacketSizeReceived >= rxPacketSize)
     {
-        if (rxPacket[i] == 0xFF &&
-            rxPacket[i+1] == 0xFF)
+        // Check ID pairing
+        if (txPacket[PKT_ID] != serial->rxBufferPeek(PKT_ID))
         {
-            break;
-        }
-        else if (i == (rxPacketSizeReceived - 2) &&
-                 rxPacket[rxPacketSizeReceived-1] == 0xFF)
-        {
-            break;
+            commStatus = COMM_RXCORRUPT;
+            commLock = 0;
+            return;
         }
-    }
 
-    if (i > 0)
-    {
-        for (j = 0; j < (rxPacketSizeReceived-i); j++)
+        // Rx packet size (the length field represent the full size of the packet)
+        rxPacketSize = serial->rxBufferPeek(PKT_LENGTH);
+
+        if (rxPacketSize < 9 || rxPacketSize > static_cast<int>(sizeof(rxPacket)))
         {
-            rxPacket[j] = rxPacket[j + i];
+            commStatus = COMM_RXCORRUPT;
+            commLock = 0;
+            return;
         }
-
-        rxPacketSizeReceived -= i;
     }
 
     // Incomplete packet?
     if (rxPacketSizeReceived < rxPacketSize)
     {
-        commStatus = COMM_RXWAITING;
-        return;
-    }
-
-    // Check ID pairing
-    if (txPacket[PKT_ID] != rxPacket[PKT_ID])
-    {
-        commStatus = COMM_RXCORRUPT;
-        commLock = 0;
-        return;
-    }
-
-    // Rx packet size
-    rxPacketSize = hkx_get_rxpacket_size();
-
-    if (rxPacketSizeReceived < rxPacketSize)
-    {
-        nRead = serial->rx(&rxPacket[rxPacketSizeReceived], rxPacketSize - rxPacketSizeReceived);
-        rxPacketSizeReceived += nRead;
+        if (serial->checkTimeOut() == 1)
+        {
+            if (rxPacketSizeReceived == 0)
+            {
+                commStatus = COMM_RXTIMEOUT;
+            }
+            else
+            {
+                commStatus = COMM_RXCORRUPT;
+            }
 
-        if (rxPacketSizeReceived < rxPacketSize)
+            commLock = 0;
+        }
+        else
         {
             commStatus = COMM_RXWAITING;
-            return;
         }
+
+        return;
     }
 
+    // Extract the packet, any following byte stays in the receive buffer
+    serial->rxBufferPop(rxPacket, rxPacketSize);
+
     // Generate a checksum of the incoming packet
     {
         unsigned short checksum = hkx_checksum_packet(rxPacket, rxPacketSize);
@@ -408,11 +430,21 @@ void HerkuleX::hkx_txrx_packet(int ack)
 {
 #ifdef LATENCY_TIMER
     // Latency timer for a complete transaction (instruction sent and status received)
-    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
-    start = std::chrono::high_resolution_clock::now();
+    int64_t start = getTimeNs();
 #endif
 
-    hkx_tx_packet();
+    // Depending on 'ackPolicy' value and current instruction, we wait for an answer to the packet we send
+    if (ack == ACK_DEFAULT)
+    {
+        ack = ackPolicy;
+    }
+
+    int cmd = txPacket[PKT_CMD];
+
+    bool reply = ((ack == ACK_REPLY_ALL) ||
+                  (ack == ACK_REPLY_READ && (cmd == CMD_STAT || cmd == CMD_EEP_READ || cmd == CMD_RAM_READ)));
+
+    hkx_tx_packet(reply);
 
     if (commStatus != COMM_TXSUCCESS)
     {
@@ -420,29 +452,21 @@ void HerkuleX::hkx_txrx_packet(int ack)
         return;
     }
 
-    // Depending on 'ackPolicy' value and current instruction, we wait for an answer to the packet we just sent
-    if (ack == ACK_DEFAULT)
+    if (reply == true)
     {
-        ack = ackPolicy;
-    }
+        do {
+            hkx_rx_packet();
 
-    if (ack != ACK_NO_REPLY)
-    {
-        int cmd = txPacket[PKT_CMD];
-
-        if ((ack == ACK_REPLY_ALL) ||
-            (ack == ACK_REPLY_READ && (cmd == CMD_STAT || cmd == CMD_EEP_READ || cmd == CMD_RAM_READ)))
-        {
-            do {
-                hkx_rx_packet();
+            // Sleep until more bytes arrive (or the timeout is reached) instead of spinning on rx()
+            if (commStatus == COMM_RXWAITING)
+            {
+                serial->waitData();
             }
-            while (commStatus == COMM_RXWAITING);
-        }
-        else
-        {
-            commStatus = COMM_RXSUCCESS;
-            commLock = 0;
         }
+        while (commStatus == COMM_RXWAITING);
+
+        // Feed the adaptive timeout of this device
+        serial->updateLatency(commStatus);
     }
     else
     {
@@ -456,8 +480,7 @@ void HerkuleX::hkx_txrx_packet(int ack)
 #endif
 
 #ifdef LATENCY_TIMER
-    end = std::chrono::high_resolution_clock::now();
-    int loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+    int loopd = static_cast<int>((getTimeNs() - start) / 1000);
     TRACE_1(HKX, "TX > RX loop: %iµs\n", loopd);
 #endif
 }
@@ -493,27 +516,7 @@ void HerkuleX::hkx_set_txpacket_parameter(int index, int value)
 
 unsigned short HerkuleX::hkx_checksum_packet(unsigned char *packetData, const int packetSize)
 {
-    // Generate checksum
-    unsigned short checksum = 0;
-
-    // (PacketSize ^ pID ^ CMD ^ Data[0] ^ Data[1] ^ ... ^ Data[n])&0xFE
-    int Sum1 = packetData[PKT_LENGTH];
-    Sum1 ^= packetData[PKT_ID];
-    Sum1 ^= packetData[PKT_CMD];
-    for (int i = PKT_DATA; i < packetSize; i++)
-    {
-        Sum1 ^= packetData[i];
-    }
-    Sum1 &= 0xFE;
-
-    //
-    int Sum2 = (~Sum1) & 0xFE;
-
-    // Make a word from these two bytes
-    checksum  = get_lowbyte(Sum1);
-    checksum += get_lowbyte(Sum2) << 8;
-
-    return checksum;
+    return hkx_checksum(packetData, packetSize);
 }
 
 int HerkuleX::hkx_get_txpacket_length_field()
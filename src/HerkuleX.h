@@ -26,6 +26,7 @@
 #include "SerialPortLinux.h"
 #include "SerialPortWindows.h"
 #include "SerialPortMacOS.h"
+#include "SerialPortFactory.h"
 
 #include "Utils.h"
 #include "ControlTables.h"
@@ -69,7 +70,7 @@ private:
     int commStatus;              //!< Last communication status
 
     // Serial communication methods, using one of the SerialPort[Linux/Mac/Windows] implementations.
-    void hkx_tx_packet();
+    void hkx_tx_packet(bool reply = true);
     void hkx_rx_packet();
     void hkx_txrx_packet(int ack);
 
@@ -155,6 +156,12 @@ public:
      */
     std::string serialGetCurrentDevice();
 
+    /*!
+     * \brief Get the speed of the serial link associated with this HerkuleX instance.
+     * \return The baud rate of the serial link, or 0 if it is not opened.
+     */
+    int serialGetBaudRate();
+
     /*!
      * \brief Get the available serial devices.
      * \return A list of path to all the serial device nodes available (ex: "/dev/ttyUSB0").
@@ -167,6 +174,33 @@ public:
      */
     void serialSetLatency(int latency);
 
+    /*!
+     * \brief serialSwitchHighSpeed
+     * \return True if low latency settings are effective on the serial device.
+     *
+     * Reduce the latency of the serial device (adapter latency timer and driver
+     * low latency flag), when the serial port backend supports it (Linux only).
+     */
+    bool serialSwitchHighSpeed();
+
+    /*!
+     * \brief serialSetAdaptiveTimeOut
+     * \param enabled: Use timeouts learned from each device response latency (default), or only the serialSetLatency() value.
+     *
+     * Even with adaptive timeouts enabled, the serialSetLatency() value is used
+     * with devices that never answered, and as an upper bound.
+     */
+    void serialSetAdaptiveTimeOut(bool enabled);
+
+    /*!
+     * \brief serialSetTxBatching
+     * \param enabled: Queue instruction packets that do not expect an answer, and send them together.
+     *
+     * Queued packets are sent with the next packet expecting an answer, or when
+     * TX batching is disabled again.
+     */
+    void serialSetTxBatching(bool enabled);
+
     /*!
      * \brief setAckPolicy
      * \param ack: Ack policy value, using '::AckPolicy_e' enum.
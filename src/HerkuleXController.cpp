@@ -24,17 +24,24 @@
 #include "minitraces.h"
 
 // C++ standard libraries
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <mutex>
 
-// Enable latency timer
-//#define LATENCY_TIMER
-
 HerkuleXController::HerkuleXController(int ctrlFrequency, int servoSerie):
     ControllerAPI(ctrlFrequency)
 {
     this->servoSerie = servoSerie;
+
+    // Default refresh rates: positions at full rate, status at a quarter of
+    // the loop frequency, and voltage and temperature at 1 Hz
+    registerScheduler.setBuiltinRate(REG_ABSOLUTE_POSITION, 1.0, 2, true);
+    registerScheduler.setBuiltinRate(REG_ABSOLUTE_GOAL_POSITION, 1.0, 2, true);
+    registerScheduler.setBuiltinRate(REG_STATUS_ERROR, 0.25, 1, true);
+    registerScheduler.setBuiltinRate(REG_STATUS_DETAIL, 0.25, 1, true);
+    registerScheduler.setBuiltinRate(REG_CURRENT_VOLTAGE, 1.0, 0, false);
+    registerScheduler.setBuiltinRate(REG_CURRENT_TEMPERATURE, 1.0, 0, false);
 }
 
 HerkuleXController::~HerkuleXController()
@@ -106,6 +113,12 @@ int HerkuleXController::connect(std::string &devicePath, const int baud, const i
     // Connection
     int retcode = serialInitialize(devicePath, baud);
 
+    // The adapter type may have been autodetected by the serial port
+    if (this->serialDevice != serialDevice)
+    {
+        updateInternalSettings();
+    }
+
     if (retcode == 1)
     {
         startThread();
@@ -195,6 +208,7 @@ void HerkuleXController::autodetect_internal(int start, int stop)
 
                 // Add the servo to the controller
                 servoList.push_back(servo);
+                servoTable[servo->getId()] = servo;
 
                 // Mark it for an "initial read" and synchronization
                 updateList.push_back(servo->getId());
@@ -219,18 +233,53 @@ void HerkuleXController::autodetect_internal(int start, int stop)
     setState(state_scanned);
 }
 
+void HerkuleXController::planReads(std::vector <ScheduledRead> &reads)
+{
+    // Transfer time of one byte (10 bits with start and stop bits), in microseconds
+    int baudRate = serialGetBaudRate();
+    double byteTime = (baudRate > 0) ? (10000000.0 / static_cast<double>(baudRate)) : 10.0;
+
+    servoListLock.lock();
+
+    std::vector <int> ids;
+    for (auto id: syncList)
+    {
+        Servo *s = findServo_internal(id);
+
+        if (s != NULL && s->getStatusReturnLevel() != ACK_NO_REPLY)
+        {
+            ids.push_back(id);
+        }
+    }
+
+    registerScheduler.plan(ids, syncloopReadBudget(), [&](int id, int reg, bool) -> int
+    {
+        Servo *s = findServo_internal(id);
+
+        if (s == NULL || s->gaddr(reg) < 0)
+        {
+            return -1;
+        }
+
+        // Each register is read with its own RAM_READ instruction (9 bytes),
+        // answered by a status packet (13 bytes + data)
+        int size = getRegisterSize(s->getControlTable(), reg);
+        return SYNCLOOP_TURNAROUND_US + static_cast<int>((9 + 13 + size) * byteTime);
+    }, reads);
+
+    servoListLock.unlock();
+}
+
 void HerkuleXController::run()
 {
     TRACE_INFO(CAPI, "HerkuleXController::run(port: '%s' / tid: '%i')\n",
                serialGetCurrentDevice().c_str(), std::this_thread::get_id());
 
-    std::chrono::time_point<std::chrono::system_clock> start, end;
+    // Loop timer
+    syncloopStart();
 
     while (getState() >= state_started)
     {
-        // Loop timer
-        start = std::chrono::system_clock::now();
-
         // MESSAGE PARSING
         ////////////////////////////////////////////////////////////////////////
 
@@ -295,6 +344,9 @@ void HerkuleXController::run()
         // ACTION LOOP
         ////////////////////////////////////////////////////////////////////////
 
+        // Instructions without answer (actions, writes with no ack) are queued and sent together
+        serialSetTxBatching(true);
+
         servoListLock.lock();
         for (auto s: servoList)
         {
@@ -314,20 +366,7 @@ void HerkuleXController::run()
             if (rebootProgrammed == 1)
             {
                 // Remove servo from sync/update lists; Need to be added again after reboot!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
-                {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
-                }
+                unsyncServo_internal(id);
 
                 // Reboot
                 hkx_reboot(id, ack);
@@ -340,20 +379,7 @@ void HerkuleXController::run()
             if (resetProgrammed > 0)
             {
                 // Remove servo from sync/update lists; Need to be added again after reset!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
-                {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
-                }
+                unsyncServo_internal(id);
 
                 // Reset
                 hkx_reset(id, resetProgrammed, ack);
@@ -365,84 +391,85 @@ void HerkuleXController::run()
         }
         servoListLock.unlock();
 
+        // Send whatever is left in the batch
+        serialSetTxBatching(false);
+
         // INITIAL READ LOOP
         ////////////////////////////////////////////////////////////////////////
 
         servoListLock.lock();
         if (updateList.empty() == false)
         {
-            std::vector <int>::iterator itr;
-            for (itr = updateList.begin(); itr != updateList.end();)
+            setState(state_reading);
+
+            for (auto id: updateList)
             {
-                setState(state_reading);
+                Servo *s = findServo_internal(id);
 
-                for (auto s: servoList)
+                if (s != NULL)
                 {
-                    if (s->getId() == (*itr))
-                    {
-                        int id = s->getId();
-                        int ack = s->getStatusReturnLevel();
+                    int ack = s->getStatusReturnLevel();
 
-                        for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
-                        {
-                            struct RegisterInfos reg;
-                            int reg_name = getRegisterName(s->getControlTable(), ctid);
-                            getRegisterInfos(s->getControlTable(), reg_name, reg);
+                    for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
+                    {
+                        struct RegisterInfos reg;
+                        int reg_name = getRegisterName(s->getControlTable(), ctid);
+                        getRegisterInfos(s->getControlTable(), reg_name, reg);
 
-                            TRACE_1(HKX, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg.reg_addr, reg.reg_size);
+                        TRACE_1(HKX, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg.reg_addr, reg.reg_size);
 
-                            int reg_type = REGISTER_AUTO;
-                            if (reg.reg_addr_rom >= 0 && reg.reg_addr_ram >= 0)
-                                reg_type = REGISTER_BOTH;
-                            else if (reg.reg_addr_rom >= 0)
-                                reg_type = REGISTER_ROM;
-                            else if (reg.reg_addr_ram >= 0)
-                                reg_type = REGISTER_RAM;
+                        int reg_type = REGISTER_AUTO;
+                        if (reg.reg_addr_rom >= 0 && reg.reg_addr_ram >= 0)
+                            reg_type = REGISTER_BOTH;
+                        else if (reg.reg_addr_rom >= 0)
+                            reg_type = REGISTER_ROM;
+                        else if (reg.reg_addr_ram >= 0)
+                            reg_type = REGISTER_RAM;
 
-                            if (reg.reg_size == 1)
+                        if (reg.reg_size == 1)
+                        {
+                            if (reg_type == REGISTER_BOTH)
                             {
-                                if (reg_type == REGISTER_BOTH)
-                                {
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
-                                else if (reg_type == REGISTER_ROM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                }
-                                else if (reg_type == REGISTER_RAM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
+                                s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                                s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
                             }
-                            else //if (reg.reg_size == 2)
+                            else if (reg_type == REGISTER_ROM)
                             {
-                                if (reg_type == REGISTER_BOTH)
-                                {
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
-                                else if (reg_type == REGISTER_ROM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                }
-                                else if (reg_type == REGISTER_RAM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
+                                s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                            }
+                            else if (reg_type == REGISTER_RAM)
+                            {
+                                s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
+                            }
+                        }
+                        else //if (reg.reg_size == 2)
+                        {
+                            if (reg_type == REGISTER_BOTH)
+                            {
+                                s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                                s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
+                            }
+                            else if (reg_type == REGISTER_ROM)
+                            {
+                                s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                            }
+                            else if (reg_type == REGISTER_RAM)
+                            {
+                                s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
                             }
-
-                            s->setError(hkx_get_rxpacket_error());
-                            s->setStatus(hkx_get_rxpacket_status_detail());
-                            updateErrorCount(hkx_get_com_error_count());
-                            hkx_print_error();
                         }
 
-                        // Once all registers are read, remove the servo from the "updateList"
-                        itr = updateList.erase(itr);
+                        s->setError(hkx_get_rxpacket_error());
+                        s->setStatus(hkx_get_rxpacket_status_detail());
+                        updateErrorCount(hkx_get_com_error_count());
+                        hkx_print_error();
                     }
                 }
             }
+
+            // Once all registers are read, the devices leave the "updateList"
+            updateList.clear();
+
             setState(state_ready);
         }
         servoListLock.unlock();
@@ -450,214 +477,165 @@ void HerkuleXController::run()
         // SYNCHRONIZATION LOOP
         ////////////////////////////////////////////////////////////////////////
 
-        int cumulid = 0;
+        // Instructions without answer (writes with no ack) are queued and sent together
+        serialSetTxBatching(true);
+
+        // Registers to read this cycle
+        std::vector <ScheduledRead> reads;
+        planReads(reads);
+
+        // Planned reads of each device, as [first;last[ ranges in 'reads'
+        std::fill(readsFirst, readsFirst + BROADCAST_ID, 0);
+        std::fill(readsLast, readsLast + BROADCAST_ID, 0);
+
+        for (size_t i = 0; i < reads.size(); i++)
+        {
+            if (readsLast[reads[i].id] == 0)
+            {
+                readsFirst[reads[i].id] = i;
+            }
+            readsLast[reads[i].id] = i + 1;
+        }
 
         servoListLock.lock();
         for (auto id: syncList)
         {
-            cumulid++;
-            cumulid %= syncloopFrequency;
+            ServoHerkuleX *s = static_cast<ServoHerkuleX*>(findServo_internal(id));
 
-            for (auto s_raw: servoList)
+            if (s != NULL)
             {
-                servoListLock.unlock();
+                int ack = s->getStatusReturnLevel();
 
-                ServoHerkuleX *s = static_cast<ServoHerkuleX*>(s_raw);
+                // Unregister device if it reach an error count too high
+                // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
+                if (s->getErrorCount() > 16)
+                {
+                    TRACE_ERROR(HKX, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...\n", id, serialGetCurrentDevice().c_str());
+                    unregisterServo(s);
+                    continue;
+                }
 
-                if (s->getId() == id)
+                // Commit register modifications (only the registers flagged with a pending commit)
+                for (int ctid = s->getNextDirtyRegister(); ctid >= 0; ctid = s->getNextDirtyRegister(ctid + 1))
                 {
-                    int ack = s->getStatusReturnLevel();
+                    int regname = getRegisterName(s->getControlTable(), ctid);
+                    int regsize = getRegisterSize(s->getControlTable(), regname);
 
-                    // Unregister device if it reach an error count too high
-                    // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
-                    if (s->getErrorCount() > 16)
+                    if (s->getValueCommit(regname, REGISTER_ROM) == 1)
                     {
-                        TRACE_ERROR(HKX, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...\n", id, serialGetCurrentDevice().c_str());
-                        unregisterServo(s);
-                        continue;
-                    }
+                        int regaddr = getRegisterAddr(s->getControlTable(), regname, REGISTER_ROM);
 
-                    // Commit register modifications
-                    for (int ctid = 0; ctid < s->getRegisterCount(); ctid++)
-                    {
-                        int regname = getRegisterName(s->getControlTable(), ctid);
-                        int regsize = getRegisterSize(s->getControlTable(), regname);
+                        TRACE_1(HKX, "Writing ROM value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
+                                s->getValue(regname, REGISTER_ROM), ctid, getRegisterNameTxt(regname).c_str(), regaddr, regsize);
 
-                        if (s->getValueCommit(regname, REGISTER_ROM) == 1)
+                        if (regsize == 1)
                         {
-                            int regaddr = getRegisterAddr(s->getControlTable(), regname, REGISTER_ROM);
-
-                            TRACE_1(HKX, "Writing ROM value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
-                                    s->getValue(regname, REGISTER_ROM), ctid, getRegisterNameTxt(regname).c_str(), regaddr, regsize);
-
-                            if (regsize == 1)
-                            {
-                                hkx_write_byte(id, regaddr, s->getValue(regname, REGISTER_ROM), REGISTER_ROM, ack);
-                            }
-                            else //if (regsize == 2)
-                            {
-                                hkx_write_word(id, regaddr, s->getValue(regname, REGISTER_ROM), REGISTER_ROM, ack);
-                            }
-
-                            s->setError(hkx_get_rxpacket_error());
-                            s->setStatus(hkx_get_rxpacket_status_detail());
-                            s->commitValue(regname, 0, REGISTER_ROM);
-                            updateErrorCount(hkx_get_com_error_count());
-                            hkx_print_error();
-
-                            if (regname == REG_ID)
-                            {
-                                if (s->changeInternalId(s->getValue(regname)) == 1)
-                                {
-                                    s->reboot();
-                                }
-                            }
+                            hkx_write_byte(id, regaddr, s->getValue(regname, REGISTER_ROM), REGISTER_ROM, ack);
                         }
-
-                        if (s->getValueCommit(regname, REGISTER_RAM) == 1)
+                        else //if (regsize == 2)
                         {
-                            int regaddr = getRegisterAddr(s->getControlTable(), regname, REGISTER_RAM);
-
-                            TRACE_1(HKX, "Writing RAM value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
-                                    s->getValue(regname, REGISTER_RAM), ctid, getRegisterNameTxt(regname).c_str(), regaddr, regsize);
-
-                            if (regsize == 1)
-                            {
-                                hkx_write_byte(id, regaddr, s->getValue(regname, REGISTER_RAM), REGISTER_RAM, ack);
-                            }
-                            else //if (regsize == 2)
-                            {
-                                hkx_write_word(id, regaddr, s->getValue(regname, REGISTER_RAM), REGISTER_RAM, ack);
-                            }
-
-                            s->setError(hkx_get_rxpacket_error());
-                            s->setStatus(hkx_get_rxpacket_status_detail());
-                            s->commitValue(regname, 0, REGISTER_RAM);
-                            updateErrorCount(hkx_get_com_error_count());
-                            hkx_print_error();
-
-                            // FIXME: probably doesn't work...
-                            if (regname == REG_ID)
-                            {
-                                unregisterServo(s);
-                                if (s->changeInternalId(s->getValue(regname)) == 1)
-                                {
-                                    registerServo(s);
-                                }
-                            }
+                            hkx_write_word(id, regaddr, s->getValue(regname, REGISTER_ROM), REGISTER_ROM, ack);
                         }
-                    }
 
-                    // 1 Hz "low priority" update loop
-                    if (((syncloopCounter - cumulid) == 0) &&
-                        (ack != ACK_NO_REPLY))
-                    {
-                        // Read voltage
-                        s->updateValue(REG_CURRENT_VOLTAGE, hkx_read_byte(id, s->gaddr(REG_CURRENT_VOLTAGE), REGISTER_RAM, ack));
                         s->setError(hkx_get_rxpacket_error());
                         s->setStatus(hkx_get_rxpacket_status_detail());
+                        s->commitValue(regname, 0, REGISTER_ROM);
                         updateErrorCount(hkx_get_com_error_count());
                         hkx_print_error();
 
-                        // Read temp
-                        s->updateValue(REG_CURRENT_TEMPERATURE, hkx_read_byte(id, s->gaddr(REG_CURRENT_TEMPERATURE), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
+                        if (regname == REG_ID)
+                        {
+                            if (s->changeInternalId(s->getValue(regname)) == 1)
+                            {
+                                s->reboot();
+                            }
+                        }
                     }
 
-                    // x/4 Hz "feedback" update loop
-                    if (((syncloopCounter - cumulid) % 4 == 0) &&
-                        (ack != ACK_NO_REPLY))
+                    if (s->getValueCommit(regname, REGISTER_RAM) == 1)
                     {
-                        s->updateValue(REG_STATUS_ERROR, hkx_read_byte(id, s->gaddr(REG_STATUS_ERROR), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
+                        int regaddr = getRegisterAddr(s->getControlTable(), regname, REGISTER_RAM);
 
-                        s->updateValue(REG_STATUS_DETAIL, hkx_read_byte(id, s->gaddr(REG_STATUS_DETAIL), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-/*
-                        s->updateCurrentSpeed(hkx_read_word(id, s->gaddr(SERVO_CURRENT_SPEED), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
+                        TRACE_1(HKX, "Writing RAM value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
+                                s->getValue(regname, REGISTER_RAM), ctid, getRegisterNameTxt(regname).c_str(), regaddr, regsize);
 
-                        s->updateCurrentLoad(hkx_read_word(id, s->gaddr(SERVO_CURRENT_LOAD), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-*/
-                    }
+                        if (regsize == 1)
+                        {
+                            hkx_write_byte(id, regaddr, s->getValue(regname, REGISTER_RAM), REGISTER_RAM, ack);
+                        }
+                        else //if (regsize == 2)
+                        {
+                            hkx_write_word(id, regaddr, s->getValue(regname, REGISTER_RAM), REGISTER_RAM, ack);
+                        }
 
-                    // x Hz "full speed" update loop
-                    {
-                        // Get "current" values from devices, and write them into corresponding objects
-                        int cpos = hkx_read_word(id, s->gaddr(REG_ABSOLUTE_POSITION), REGISTER_RAM, ack);
-                        s->updateValue(REG_ABSOLUTE_POSITION, cpos);
                         s->setError(hkx_get_rxpacket_error());
                         s->setStatus(hkx_get_rxpacket_status_detail());
+                        s->commitValue(regname, 0, REGISTER_RAM);
                         updateErrorCount(hkx_get_com_error_count());
                         hkx_print_error();
 
-                        if (s->getGoalPositionCommited() == 1)
+                        // FIXME: probably doesn't work...
+                        if (regname == REG_ID)
                         {
-                            int gpos = s->getGoalPosition();
-
-                            hkx_i_jog(id, 0, gpos, ack);
-                            if (hkx_print_error() == 0)
+                            unregisterServo(s);
+                            if (s->changeInternalId(s->getValue(regname)) == 1)
                             {
-                                s->commitGoalPosition();
+                                registerServo(s);
                             }
                         }
+                    }
+                }
 
-                        s->updateValue(REG_ABSOLUTE_GOAL_POSITION, hkx_read_word(id, s->gaddr(REG_ABSOLUTE_GOAL_POSITION), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
+                // Goal position
+                if (s->getGoalPositionCommited() == 1)
+                {
+                    int gpos = s->getGoalPosition();
+
+                    hkx_i_jog(id, 0, gpos, ack);
+                    if (hkx_print_error() == 0)
+                    {
+                        s->commitGoalPosition();
                     }
                 }
 
-                servoListLock.lock();
+                // Planned register reads
+                for (size_t i = readsFirst[id]; i < readsLast[id]; i++)
+                {
+                    const ScheduledRead &r = reads[i];
+                    int reg_addr = s->gaddr(r.reg);
+
+                    if (reg_addr < 0)
+                    {
+                        continue;
+                    }
+
+                    if (getRegisterSize(s->getControlTable(), r.reg) == 1)
+                    {
+                        s->updateValue(r.reg, hkx_read_byte(id, reg_addr, REGISTER_RAM, ack));
+                    }
+                    else
+                    {
+                        s->updateValue(r.reg, hkx_read_word(id, reg_addr, REGISTER_RAM, ack));
+                    }
+
+                    s->setError(hkx_get_rxpacket_error());
+                    s->setStatus(hkx_get_rxpacket_status_detail());
+                    updateErrorCount(hkx_get_com_error_count());
+                    hkx_print_error();
+                }
             }
         }
-
-        // Make sure we unlock servoList
         servoListLock.unlock();
 
+        // Send whatever is left in the batch
+        serialSetTxBatching(false);
+
         // Loop control
         syncloopCounter++;
         syncloopCounter %= syncloopFrequency;
 
         // Loop timer
-        end = std::chrono::system_clock::now();
-        double loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
-        double waitd = (syncloopDuration * 1000.0) - loopd;
-
-#ifdef LATENCY_TIMER
-        if ((loopd / 1000.0) > syncloopDuration)
-        {
-            TRACE_WARNING(HKX, "Sync loop duration: %fms of the %fms budget.\n", (loopd / 1000.0), syncloopDuration);
-        }
-        else
-        {
-            TRACE_INFO(HKX, "Sync loop duration: %fms of the %fms budget.\n", (loopd / 1000.0), syncloopDuration);
-        }
-#endif
-
-        if (waitd > 0.0)
-        {
-            std::chrono::microseconds waittime(static_cast<int>(waitd));
-            std::this_thread::sleep_for(waittime);
-        }
+        syncloopWait();
     }
 
     TRACE_INFO(HKX, ">> THREAD (tid: '%i') termination by 'loop exit'\n", std::this_thread::get_id());
@@ -42,12 +42,21 @@
  */
 class HerkuleXController: public HerkuleX, public ControllerAPI
 {
+    size_t readsFirst[BROADCAST_ID]; //!< First planned read of each device during the current cycle (index in the reads list).
+    size_t readsLast[BROADCAST_ID];  //!< Last planned read of each device during the current cycle (index in the reads list, excluded).
+
     //! Compute some internal settings (ackPolicy, maxId, protocolVersion) depending on current servo serie and serial device.
     void updateInternalSettings();
 
     //! Read/write synchronization loop, running inside its own background thread
     void run();
 
+    /*!
+     * \brief Plan the register reads of the current cycle, using the register scheduler.
+     * \param[out] reads: The registers to read, grouped by device.
+     */
+    void planReads(std::vector <ScheduledRead> &reads);
+
 public:
     /*!
      * \brief HerkuleXController constructor.
@@ -148,3 +148,19 @@ int hkx_get_baudrate(const int baudnum, const int servo_serie)
 
     return baudRate;
 }
+
+unsigned short hkx_checksum(const unsigned char *packet, const int size)
+{
+    // (PacketSize ^ pID ^ CMD ^ Data[0] ^ Data[1] ^ ... ^ Data[n])&0xFE
+    int sum1 = packet[2] ^ packet[3] ^ packet[4];
+    for (int i = 7; i < size; i++)
+    {
+        sum1 ^= packet[i];
+    }
+    sum1 &= 0xFE;
+
+    int sum2 = (~sum1) & 0xFE;
+
+    // Make a word from these two bytes
+    return static_cast<unsigned short>(sum1 | (sum2 << 8));
+}
@@ -89,4 +89,14 @@ int hkx_get_servo_model(const int model_number);
  */
 int hkx_get_baudrate(const int baudnum, const int servo_serie = SERVO_DRS);
 
+/*!
+ * \brief Compute the checksum of an HerkuleX packet.
+ * \param packet: The packet, from its header to its last data byte.
+ * \param size: The size (in byte) of the packet.
+ * \return The checksum, 'checksum1' in the low byte and 'checksum2' in the high byte.
+ *
+ * The checksum fields themselves (bytes 5 and 6) are not part of the computation.
+ */
+unsigned short hkx_checksum(const unsigned char *packet, const int size);
+
 #endif /* HERKULEX_TOOLS_H */
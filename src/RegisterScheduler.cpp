@@ -0,0 +1,289 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file RegisterScheduler.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+
+#include "RegisterScheduler.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <cmath>
+
+RegisterScheduler::RegisterScheduler(int loopFrequency):
+    rulesChanged(false),
+    phaseCounter(0),
+    readCounter(0),
+    frequency(loopFrequency > 0 ? loopFrequency : 1)
+{
+    std::fill(deviceSlots, deviceSlots + BROADCAST_ID, -1);
+}
+
+void RegisterScheduler::storeRule(std::vector <Rule> &list, const Rule &rule)
+{
+    for (auto &r: list)
+    {
+        if (r.id == rule.id && r.reg == rule.reg)
+        {
+            r = rule;
+            return;
+        }
+    }
+
+    list.push_back(rule);
+}
+
+void RegisterScheduler::setRate(int id, int reg, double rate, int priority)
+{
+    std::lock_guard <std::mutex> lock(schedulerLock);
+
+    Rule r = {id, reg, std::max(rate, 0.0), false, priority};
+    storeRule(rules, r);
+    rulesChanged = true;
+}
+
+void RegisterScheduler::setBuiltinRate(int reg, double rate, int priority, bool loopShare)
+{
+    std::lock_guard <std::mutex> lock(schedulerLock);
+
+    Rule r = {-1, reg, std::max(rate, 0.0), loopShare, priority};
+    storeRule(builtinRules, r);
+    storeRule(rules, r);
+    rulesChanged = true;
+}
+
+void RegisterScheduler::resetRates(int id)
+{
+    std::lock_guard <std::mutex> lock(schedulerLock);
+
+    rules.erase(std::remove_if(rules.begin(), rules.end(),
+                               [id](const Rule &r) { return (r.id == id); }),
+                rules.end());
+
+    if (id == -1)
+    {
+        rules.insert(rules.begin(), builtinRules.begin(), builtinRules.end());
+    }
+
+    rulesChanged = true;
+}
+
+void RegisterScheduler::clear()
+{
+    std::lock_guard <std::mutex> lock(schedulerLock);
+
+    devices.clear();
+    std::fill(deviceSlots, deviceSlots + BROADCAST_ID, -1);
+    phaseCounter = 0;
+}
+
+void RegisterScheduler::applyRules(Device &dev, bool newDevice)
+{
+    // Each device starts its slow registers at its own phase, spaced by the
+    // golden ratio so any number of devices stays evenly spread over the cycles
+    double phase = std::fmod(phaseCounter * 0.6180339887, 1.0);
+    if (newDevice == true)
+    {
+        phaseCounter++;
+    }
+
+    std::vector <Entry> entries;
+
+    for (auto const &r: rules)
+    {
+        if (r.id != -1 && r.id != dev.id)
+        {
+            continue;
+        }
+
+        // Device settings override the default ones
+        auto it = std::find_if(entries.begin(), entries.end(),
+                               [&r](const Entry &e) { return e.reg == r.reg; });
+        if (it == entries.end())
+        {
+            Entry e = {r.reg, 0.0, r.priority, phase, 0, false};
+            it = entries.insert(entries.end(), e);
+        }
+        else if (r.id == -1)
+        {
+            continue;
+        }
+
+        it->rate = (r.loopShare == true) ? r.rate * frequency : r.rate;
+        it->priority = r.priority;
+
+        // Keep the credit of the registers already scheduled
+        for (auto const &old: dev.entries)
+        {
+            if (old.reg == r.reg)
+            {
+                it->credit = old.credit;
+            }
+        }
+    }
+
+    dev.entries = entries;
+}
+
+int RegisterScheduler::plan(const std::vector <int> &ids, int budget,
+                            const std::function<int(int id, int reg, bool first)> &cost,
+                            std::vector <ScheduledRead> &reads)
+{
+    std::lock_guard <std::mutex> lock(schedulerLock);
+
+    // Follow the device list, in its order
+    std::vector <Device> current;
+    current.reserve(ids.size());
+
+    for (auto id: ids)
+    {
+        if (id < 0 || id >= BROADCAST_ID)
+        {
+            continue;
+        }
+
+        int slot = deviceSlots[id];
+        if (slot >= 0 && devices[slot].id == id)
+        {
+            current.push_back(std::move(devices[slot]));
+            devices[slot].id = -1;
+
+            if (rulesChanged == true)
+            {
+                applyRules(current.back(), false);
+            }
+        }
+        else
+        {
+            Device d;
+            d.id = id;
+            applyRules(d, true);
+            current.push_back(std::move(d));
+        }
+    }
+
+    // Forget the devices not listed anymore, and index the others
+    for (auto const &d: devices)
+    {
+        if (d.id >= 0)
+        {
+            deviceSlots[d.id] = -1;
+        }
+    }
+    for (size_t i = 0; i < current.size(); i++)
+    {
+        deviceSlots[current[i].id] = static_cast<int>(i);
+    }
+
+    devices.swap(current);
+    rulesChanged = false;
+
+    // Earn credits, and gather the reads that are due
+    struct Candidate
+    {
+        size_t dev;
+        size_t entry;
+    };
+    std::vector <Candidate> due;
+
+    for (size_t d = 0; d < devices.size(); d++)
+    {
+        for (size_t e = 0; e < devices[d].entries.size(); e++)
+        {
+            Entry &entry = devices[d].entries[e];
+            entry.selected = false;
+
+            if (entry.rate > 0.0)
+            {
+                entry.credit += std::min(entry.rate / frequency, 1.0);
+                entry.credit = std::min(entry.credit, SCHEDULER_CREDIT_MAX);
+
+                if (entry.credit >= 1.0 - 1e-6)
+                {
+                    Candidate c = {d, e};
+                    due.push_back(c);
+                }
+            }
+        }
+    }
+
+    // Highest priority first, then the most late, then the least recently read
+    std::stable_sort(due.begin(), due.end(), [this](const Candidate &a, const Candidate &b)
+    {
+        const Entry &ea = devices[a.dev].entries[a.entry];
+        const Entry &eb = devices[b.dev].entries[b.entry];
+
+        if (ea.priority != eb.priority)
+        {
+            return ea.priority > eb.priority;
+        }
+
+        if (ea.credit != eb.credit)
+        {
+            return ea.credit > eb.credit;
+        }
+
+        return (readCounter - ea.lastRead) > (readCounter - eb.lastRead);
+    });
+
+    // Fill the budget. A read that does not fit is deferred, but smaller ones
+    // may still fit after it
+    std::vector <bool> devSelected(devices.size(), false);
+    int used = 0;
+
+    for (auto const &c: due)
+    {
+        Entry &entry = devices[c.dev].entries[c.entry];
+        int readCost = cost(devices[c.dev].id, entry.reg, !devSelected[c.dev]);
+
+        if (readCost < 0)
+        {
+            // This device cannot read this register, stop scheduling it
+            entry.rate = 0.0;
+            entry.credit = 0.0;
+            continue;
+        }
+
+        if (used + readCost > budget && used > 0)
+        {
+            continue;
+        }
+
+        entry.selected = true;
+        entry.credit -= 1.0;
+        entry.lastRead = ++readCounter;
+        devSelected[c.dev] = true;
+        used += readCost;
+    }
+
+    for (auto const &dev: devices)
+    {
+        for (auto const &entry: dev.entries)
+        {
+            if (entry.selected == true)
+            {
+                ScheduledRead r = {dev.id, entry.reg};
+                reads.push_back(r);
+            }
+        }
+    }
+
+    return used;
+}
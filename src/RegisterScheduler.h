@@ -0,0 +1,167 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file RegisterScheduler.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+
+#ifndef REGISTER_SCHEDULER_H
+#define REGISTER_SCHEDULER_H
+
+#include "Utils.h"
+
+// C++ standard libraries
+#include <vector>
+#include <mutex>
+#include <functional>
+
+/** \addtogroup ManagedAPIs
+ *  @{
+ */
+
+/*!
+ * \brief Maximum number of read(s) a register may lag behind its target rate, when the bus is too busy to keep up.
+ */
+#define SCHEDULER_CREDIT_MAX    (2.0)
+
+/*!
+ * \brief A register read selected by the RegisterScheduler for the current cycle.
+ */
+struct ScheduledRead
+{
+    int id;                 //!< Device ID.
+    int reg;                //!< Register name (see ::ControlTables_e).
+};
+
+/*!
+ * \brief The RegisterScheduler class, used by the controllers to decide which registers to read at each cycle.
+ *
+ * Each (device, register) pair has a target refresh rate (in Hz) and a
+ * priority. Default settings apply to every device, and can be overridden for
+ * a particular device. The built-in defaults set by the controllers can be
+ * expressed as a share of the loop frequency, so they follow it. At each cycle, every register earns a "credit" of
+ * rate / loop frequency, and is due once it has earned a full read. The due
+ * reads are then selected by priority (and by lateness for the same priority)
+ * until the bus budget of the cycle is spent. Reads that do not fit are
+ * deferred to the next cycle, keeping their credit, and the least recently
+ * read go first when several reads are equally late.
+ *
+ * Slow registers of different devices start with different phases, so their
+ * reads are spread across the cycles instead of all falling on the same one.
+ */
+class RegisterScheduler
+{
+    struct Rule
+    {
+        int id;             //!< Device ID, or -1 for the default settings.
+        int reg;
+        double rate;        //!< Target rate (in Hz). 0 to never read the register.
+        bool loopShare;     //!< If set, 'rate' is a share of the loop frequency instead of a rate in Hz.
+        int priority;       //!< Higher priorities are read first.
+    };
+
+    struct Entry
+    {
+        int reg;
+        double rate;
+        int priority;
+        double credit;      //!< Read(s) earned and not done yet.
+        unsigned lastRead;  //!< Sequence number of the last read, to rotate between reads capped at the same credit.
+        bool selected;      //!< Selected for the current cycle.
+    };
+
+    struct Device
+    {
+        int id;
+        std::vector <Entry> entries;
+    };
+
+    std::vector <Rule> rules;           //!< Refresh settings, default ones first.
+    std::vector <Rule> builtinRules;    //!< Built-in default settings, restored by resetRates(-1).
+    std::vector <Device> devices;       //!< Scheduling state of the devices seen by plan().
+    int deviceSlots[BROADCAST_ID];      //!< Index of each device ID in 'devices', or -1.
+    bool rulesChanged;                  //!< Set when the rules must be applied again to the devices.
+    unsigned phaseCounter;              //!< Used to give each new device its own phase.
+    unsigned readCounter;               //!< Number of reads selected so far, used as a sequence number.
+    int frequency;                      //!< Frequency of the synchronization loop, in Hz.
+    std::mutex schedulerLock;           //!< Lock for the rules and the scheduling state.
+
+    void applyRules(Device &dev, bool newDevice);
+    void storeRule(std::vector <Rule> &list, const Rule &rule);
+
+public:
+    /*!
+     * \brief RegisterScheduler constructor.
+     * \param loopFrequency: Frequency of the synchronization loop, in Hz.
+     */
+    RegisterScheduler(int loopFrequency);
+
+    /*!
+     * \brief Set the target refresh rate of a register.
+     * \param id: Device ID, or -1 to change the default settings of every device.
+     * \param reg: Register name (see ::ControlTables_e).
+     * \param rate: Target rate (in Hz). Rates higher than the loop frequency mean every cycle, 0 means never.
+     * \param priority: Reads with higher priorities are selected first when the bus budget is short.
+     *
+     * Settings given for a device ID take precedence over the default settings.
+     */
+    void setRate(int id, int reg, double rate, int priority);
+
+    /*!
+     * \brief Set the built-in default refresh rate of a register.
+     * \param reg: Register name (see ::ControlTables_e).
+     * \param rate: Target rate, in Hz, or as a share of the loop frequency if 'loopShare' is set (1.0 means every cycle).
+     * \param priority: Reads with higher priorities are selected first when the bus budget is short.
+     * \param loopShare: Set if 'rate' is a share of the loop frequency.
+     *
+     * Also sets the current default settings, like setRate(-1, ...).
+     */
+    void setBuiltinRate(int reg, double rate, int priority, bool loopShare);
+
+    /*!
+     * \brief Remove the settings of a device, so it uses the default settings again.
+     * \param id: Device ID, or -1 to restore the built-in default settings (the settings of each device are kept).
+     */
+    void resetRates(int id);
+
+    /*!
+     * \brief Forget the scheduling state of every device. The refresh settings are kept.
+     */
+    void clear();
+
+    /*!
+     * \brief Select the registers to read during the current cycle.
+     * \param ids: Devices to read, in [0;253]. Devices not listed anymore are forgotten.
+     * \param budget: Bus time available for the reads of this cycle (same unit as the cost function).
+     * \param cost: Bus time needed to read a register of a device. Called with 'first' set when this is the first register of the device selected in this cycle, and should return -1 if the device cannot read this register.
+     * \param[out] reads: The selected reads, grouped by device, in the order of 'ids'.
+     * \return The bus time used by the selected reads.
+     *
+     * At least one read is selected at each cycle (if any is due), even if it
+     * does not fit the budget, so the loop never stalls entirely. Apart from
+     * sorting the due reads, the cost is linear with the number of devices.
+     */
+    int plan(const std::vector <int> &ids, int budget,
+             const std::function<int(int id, int reg, bool first)> &cost,
+             std::vector <ScheduledRead> &reads);
+};
+
+/** @}*/
+
+#endif /* REGISTER_SCHEDULER_H */
@@ -0,0 +1,211 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialCapture.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#include "SerialCapture.h"
+#include "Deadline.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+/* ************************************************************************** */
+
+static const unsigned char captureMagic[6] = {'S', 'S', 'F', 'C', 'A', 'P'};
+
+static std::atomic <bool> captureEnabled(false);
+static std::mutex captureLock;
+static FILE *captureFile = NULL;
+static std::map <std::string, int> capturePorts;
+
+static void writeRecord(const int64_t timestamp, const int type, const int port, const unsigned char *data, const int length)
+{
+    unsigned char header[12];
+
+    for (int i = 0; i < 8; i++)
+    {
+        header[i] = static_cast<unsigned char>((static_cast<uint64_t>(timestamp) >> (8 * i)) & 0xFF);
+    }
+    header[8] = static_cast<unsigned char>(type);
+    header[9] = static_cast<unsigned char>(port);
+    header[10] = static_cast<unsigned char>(length & 0xFF);
+    header[11] = static_cast<unsigned char>((length >> 8) & 0xFF);
+
+    fwrite(header, 1, sizeof(header), captureFile);
+    if (length > 0)
+    {
+        fwrite(data, 1, length, captureFile);
+    }
+}
+
+/* ************************************************************************** */
+
+bool serialCaptureStart(const std::string &path)
+{
+    serialCaptureStop();
+
+    std::lock_guard <std::mutex> lock(captureLock);
+
+    captureFile = fopen(path.c_str(), "wb");
+    if (captureFile == NULL)
+    {
+        TRACE_ERROR(SERIAL, "Cannot create capture file '%s'\n", path.c_str());
+        return false;
+    }
+
+    unsigned char header[8];
+    memcpy(header, captureMagic, sizeof(captureMagic));
+    header[6] = SERIAL_CAPTURE_VERSION;
+    header[7] = 0;
+    fwrite(header, 1, sizeof(header), captureFile);
+
+    capturePorts.clear();
+    captureEnabled = true;
+
+    TRACE_INFO(SERIAL, "Serial traffic capture started into '%s'\n", path.c_str());
+
+    return true;
+}
+
+void serialCaptureStop()
+{
+    std::lock_guard <std::mutex> lock(captureLock);
+
+    if (captureFile != NULL)
+    {
+        captureEnabled = false;
+        fclose(captureFile);
+        captureFile = NULL;
+
+        TRACE_INFO(SERIAL, "Serial traffic capture stopped\n");
+    }
+}
+
+bool serialCaptureEnabled()
+{
+    return captureEnabled;
+}
+
+void serialCaptureWrite(const std::string &port, const int type, const unsigned char *data, const int length)
+{
+    if (captureEnabled == false || data == NULL || length <= 0)
+    {
+        return;
+    }
+
+    int64_t timestamp = getTimeNs();
+
+    std::lock_guard <std::mutex> lock(captureLock);
+
+    if (captureFile == NULL)
+    {
+        return;
+    }
+
+    // Declare the port the first time we see it
+    std::map <std::string, int>::iterator it = capturePorts.find(port);
+    int index = 0;
+
+    if (it == capturePorts.end())
+    {
+        if (capturePorts.size() >= 256)
+        {
+            return;
+        }
+
+        index = static_cast<int>(capturePorts.size());
+        capturePorts[port] = index;
+        writeRecord(timestamp, CAPTURE_PORT, index, reinterpret_cast<const unsigned char *>(port.c_str()), static_cast<int>(port.size()));
+    }
+    else
+    {
+        index = it->second;
+    }
+
+    // Records are limited to 64 KiB
+    for (int offset = 0; offset < length; offset += 65535)
+    {
+        int chunk = (length - offset > 65535) ? 65535 : (length - offset);
+        writeRecord(timestamp, type, index, data + offset, chunk);
+    }
+}
+
+int serialCaptureLoad(const std::string &path, std::vector <SerialCaptureRecord> &records, std::vector <std::string> &ports)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+    {
+        TRACE_ERROR(SERIAL, "Cannot open capture file '%s'\n", path.c_str());
+        return -1;
+    }
+
+    unsigned char header[12];
+    if (fread(header, 1, 8, f) != 8 ||
+        memcmp(header, captureMagic, sizeof(captureMagic)) != 0 ||
+        header[6] != SERIAL_CAPTURE_VERSION)
+    {
+        TRACE_ERROR(SERIAL, "'%s' is not a valid capture file\n", path.c_str());
+        fclose(f);
+        return -1;
+    }
+
+    records.clear();
+    ports.clear();
+
+    while (fread(header, 1, sizeof(header), f) == sizeof(header))
+    {
+        SerialCaptureRecord r;
+
+        uint64_t timestamp = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            timestamp |= static_cast<uint64_t>(header[i]) << (8 * i);
+        }
+        r.timestamp = static_cast<int64_t>(timestamp);
+        r.type = header[8];
+        r.port = header[9];
+        r.data.resize(header[10] | (header[11] << 8));
+
+        if (r.data.empty() == false && fread(r.data.data(), 1, r.data.size(), f) != r.data.size())
+        {
+            TRACE_WARNING(SERIAL, "Capture file '%s' is truncated\n", path.c_str());
+            break;
+        }
+
+        if (r.type == CAPTURE_PORT)
+        {
+            ports.resize(r.port + 1);
+            ports[r.port].assign(r.data.begin(), r.data.end());
+        }
+        else
+        {
+            records.push_back(r);
+        }
+    }
+
+    fclose(f);
+
+    return static_cast<int>(records.size());
+}
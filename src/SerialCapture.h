@@ -0,0 +1,108 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialCapture.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#ifndef SERIAL_CAPTURE_H
+#define SERIAL_CAPTURE_H
+
+// C++ standard libraries
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Serial traffic capture file format.
+ *
+ * A capture file starts with an 8 bytes header ("SSFCAP", a version byte and a
+ * reserved byte), followed by records. Each record has a 12 bytes header, then
+ * its data. All values are little endian:
+ * - int64: timestamp in nanoseconds, from the monotonic clock (see getTimeNs()).
+ * - uint8: record type, using ::SerialCaptureRecordType_e values.
+ * - uint8: port index.
+ * - uint16: data length in bytes.
+ *
+ * The first record of each port is a CAPTURE_PORT record, with the device path
+ * as data. Port indexes follow the order of these records, starting from 0.
+ */
+#define SERIAL_CAPTURE_VERSION      (1)
+
+/*!
+ * \brief Types of the records in a capture file.
+ */
+enum SerialCaptureRecordType_e
+{
+    CAPTURE_TX      = 0,    //!< Data written by tx()
+    CAPTURE_RX      = 1,    //!< Data read by rx()
+    CAPTURE_PORT    = 2     //!< Port declaration, data is the device path
+};
+
+/*!
+ * \brief SerialCaptureRecord structure, a record loaded from a capture file.
+ */
+typedef struct SerialCaptureRecord
+{
+    int64_t timestamp;                //!< Time of the record (in nanosecond)
+    int type;                         //!< Record type, using ::SerialCaptureRecordType_e values
+    int port;                         //!< Port index
+    std::vector <unsigned char> data; //!< Data
+
+} SerialCaptureRecord;
+
+/*!
+ * \brief Start capturing the traffic of all the serial ports into a file.
+ * \param path: Path of the capture file (overwritten if it already exists).
+ * \return True if the capture file has been created.
+ *
+ * Any capture in progress is stopped first.
+ */
+bool serialCaptureStart(const std::string &path);
+
+/*!
+ * \brief Stop the capture in progress, and close the capture file.
+ */
+void serialCaptureStop();
+
+/*!
+ * \brief Check if a capture is in progress.
+ */
+bool serialCaptureEnabled();
+
+/*!
+ * \brief Write a record into the capture file.
+ * \param port: Device path of the serial port.
+ * \param type: Record type, CAPTURE_TX or CAPTURE_RX.
+ * \param[in] data: Data written or read.
+ * \param length: Data length in byte(s).
+ *
+ * Thread safe. Does nothing if no capture is in progress.
+ */
+void serialCaptureWrite(const std::string &port, const int type, const unsigned char *data, const int length);
+
+/*!
+ * \brief Load a capture file.
+ * \param path: Path of the capture file.
+ * \param[out] records: TX and RX records, in capture order.
+ * \param[out] ports: Device path of each port, by port index.
+ * \return The number of records loaded, or -1 in case of error.
+ */
+int serialCaptureLoad(const std::string &path, std::vector <SerialCaptureRecord> &records, std::vector <std::string> &ports);
+
+#endif /* SERIAL_CAPTURE_H */
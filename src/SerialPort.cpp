@@ -25,6 +25,10 @@
 #include "HerkuleXTools.h"
 #include "minitraces.h"
 
+// C++ standard libraries
+#include <algorithm>
+#include <cstring>
+
 // Include the OS specific serialPortsScanner()
 #include "SerialPortLinux.h"
 #include "SerialPortMacOS.h"
@@ -39,11 +43,17 @@ SerialPort::SerialPort(const int serialDevice, const int servoDevices):
     ttyDeviceLockPath("null"),
     serialDevice(serialDevice),
     servoDevices(servoDevices),
-    packetStartTime(0.0),
-    packetWaitTime(0.0),
-    byteTransfertTime(0.0)
+    byteTransfertTime(10000),
+    ttyAdaptiveTimeOut(true),
+    packetId(-1),
+    packetLength(0),
+    rxBufferHead(0),
+    rxBufferTail(0),
+    txBatching(false),
+    txBufferSize(0),
+    txBufferPacketCount(0)
 {
-    //
+    resetLatencyStats();
 }
 
 SerialPort::~SerialPort()
@@ -200,6 +210,40 @@ std::vector <std::string> SerialPort::scanSerialPorts()
     return availableSerialPorts;
 }
 
+int SerialPort::getSerialDevice() const
+{
+    return serialDevice;
+}
+
+int identifySerialDevice(const int vid, const int pid, const std::string &manufacturer, const std::string &product)
+{
+    int device = SERIAL_UNKNOWN;
+
+    if (vid == 0x16D0 && pid == 0x06A7)
+    {
+        device = SERIAL_USB2AX;
+    }
+    else if (vid == 0x0403)
+    {
+        // ROBOTIS adapters use a stock FTDI VID/PID, only their strings differ
+        if (product.find("USB2Dynamixel") != std::string::npos ||
+            manufacturer.find("ROBOTIS") != std::string::npos)
+        {
+            device = SERIAL_USB2DYNAMIXEL;
+        }
+        else
+        {
+            device = SERIAL_OTHER_FTDI;
+        }
+    }
+    else if (vid == 0x10C4 && (pid & 0xFF00) == 0xEA00)
+    {
+        device = SERIAL_OTHER_CP210x;
+    }
+
+    return device;
+}
+
 bool SerialPort::isLocked()
 {
     return false;
@@ -215,6 +259,14 @@ bool SerialPort::removeLock()
     return false;
 }
 
+void SerialPort::capture(const int type, const unsigned char *data, const int length)
+{
+    if (length > 0 && serialCaptureEnabled() == true)
+    {
+        serialCaptureWrite(ttyDevicePath, type, data, length);
+    }
+}
+
 void SerialPort::setLatency(int latency)
 {
     if (latency > 0 && latency < 128)
@@ -227,6 +279,315 @@ void SerialPort::setLatency(int latency)
     }
 }
 
+int SerialPort::getLatency()
+{
+    return ttyDeviceLatencyTime;
+}
+
+bool SerialPort::switchHighSpeed()
+{
+    return false;
+}
+
+void SerialPort::resetLatencyStats()
+{
+    memset(latencyStats, 0, sizeof(latencyStats));
+    memset(&portLatencyStats, 0, sizeof(portLatencyStats));
+}
+
+void SerialPort::setTimeOut(int packetLength)
+{
+    setTimeOut(packetLength, -1);
+}
+
+void SerialPort::setTimeOut(int packetLength, int id)
+{
+    int64_t transfertTime = byteTransfertTime * static_cast<int64_t>(packetLength);
+    int64_t latencyTime = 2 * static_cast<int64_t>(ttyDeviceLatencyTime) * 1000000;
+
+    this->packetId = (id >= 0 && id < 254) ? id : -1;
+    this->packetLength = packetLength;
+
+    if (ttyAdaptiveTimeOut == true && packetId >= 0)
+    {
+        const LatencyStats &stats = latencyStats[packetId];
+        int t = stats.timeoutCount;
+
+        // Probe with the full timeout after 1, 2, 4, ... 64 consecutive timeouts, then every 64 timeouts
+        bool probe = (t > 0) && ((t < 64) ? ((t & (t - 1)) == 0) : ((t % 64) == 0));
+
+        if (probe == false)
+        {
+            if (stats.sampleCount >= LATENCY_SAMPLES_MIN)
+            {
+                latencyTime = std::min(latencyTime, stats.latency);
+            }
+            else if (t > 0 && portLatencyStats.sampleCount >= LATENCY_SAMPLES_MIN)
+            {
+                // This device never answered (enough), but others devices on
+                // the same adapter at the same speed did: use their latency
+                latencyTime = std::min(latencyTime, portLatencyStats.latency);
+            }
+        }
+    }
+
+    packetDeadline.set(transfertTime + latencyTime);
+}
+
+void SerialPort::setTimeOut(double msec)
+{
+    packetDeadline.set(static_cast<int64_t>(msec * 1000000.0));
+}
+
+int SerialPort::checkTimeOut()
+{
+    return (packetDeadline.expired() == true) ? 1 : 0;
+}
+
+/*!
+ * \brief Add a latency sample to a LatencyStats, and update its adaptive latency.
+ * \param stats: The LatencyStats to update.
+ * \param latency: The measured latency (in nanosecond).
+ */
+static void addLatencySample(LatencyStats &stats, const int64_t latency)
+{
+    stats.samples[stats.sampleIndex] = latency;
+    stats.sampleIndex = (stats.sampleIndex + 1) % LATENCY_SAMPLES;
+    if (stats.sampleCount < LATENCY_SAMPLES)
+    {
+        stats.sampleCount++;
+    }
+    stats.timeoutCount = 0;
+
+    // Use the 90th percentile of the last samples, plus 50% and a fixed safety margin
+    int64_t sorted[LATENCY_SAMPLES];
+    std::copy(stats.samples, stats.samples + stats.sampleCount, sorted);
+    std::sort(sorted, sorted + stats.sampleCount);
+
+    int64_t percentile = sorted[(stats.sampleCount * 9 - 1) / 10];
+    stats.latency = percentile + percentile / 2 + static_cast<int64_t>(LATENCY_MARGIN_US) * 1000;
+}
+
+void SerialPort::updateLatency(const int status)
+{
+    if (packetId < 0)
+    {
+        return;
+    }
+
+    LatencyStats &stats = latencyStats[packetId];
+
+    if (status == COMM_RXSUCCESS)
+    {
+        int64_t latency = packetDeadline.elapsed() - byteTransfertTime * static_cast<int64_t>(packetLength);
+        if (latency < 0)
+        {
+            latency = 0;
+        }
+
+        addLatencySample(stats, latency);
+        addLatencySample(portLatencyStats, latency);
+
+        TRACE_1(SERIAL, "Latency for device #%i: %lli us (adaptive timeout: %lli us)\n",
+                packetId, static_cast<long long>(latency / 1000), static_cast<long long>(stats.latency / 1000));
+    }
+    else if (status == COMM_RXTIMEOUT)
+    {
+        stats.timeoutCount++;
+    }
+
+    packetId = -1;
+}
+
+void SerialPort::setAdaptiveTimeOut(const bool enabled)
+{
+    ttyAdaptiveTimeOut = enabled;
+}
+
+int SerialPort::waitData()
+{
+    // No way to wait on the device from here, let the caller poll rx()
+    return (checkTimeOut() == 1) ? 0 : 1;
+}
+
+void SerialPort::setTxBatching(const bool enabled)
+{
+    if (enabled == false)
+    {
+        txBufferFlush();
+    }
+
+    txBatching = enabled;
+}
+
+bool SerialPort::getTxBatching() const
+{
+    return txBatching;
+}
+
+int SerialPort::txBufferPush(const unsigned char *packet, int packetLength)
+{
+    if (packet == NULL || packetLength <= 0)
+    {
+        TRACE_ERROR(SERIAL, "Cannot queue packet for serial port '%s': invalid packet buffer or size!\n", ttyDevicePath.c_str());
+        return -1;
+    }
+
+    // No more room? Send what we already have first
+    if ((txBufferSize + packetLength) > TX_BUFFER_SIZE || txBufferPacketCount >= TX_BUFFER_PACKETS)
+    {
+        if (txBufferFlush() < 0)
+        {
+            return -1;
+        }
+    }
+
+    // Packets larger than the whole buffer are sent right away
+    if (packetLength > TX_BUFFER_SIZE)
+    {
+        return tx(const_cast<unsigned char *>(packet), packetLength);
+    }
+
+    memcpy(&txBuffer[txBufferSize], packet, packetLength);
+    txBufferSize += packetLength;
+    txBufferPacketCount++;
+
+    return packetLength;
+}
+
+int SerialPort::txBufferFlush()
+{
+    int writeStatus = 0;
+
+    if (txBufferSize > 0)
+    {
+        // A write may be partial: send the remainder until the batch had enough
+        // time to go through the serial link
+        Deadline writeDeadline;
+        writeDeadline.set(byteTransfertTime * static_cast<int64_t>(txBufferSize) +
+                          2 * static_cast<int64_t>(ttyDeviceLatencyTime) * 1000000);
+
+        int sent = 0;
+        while (sent < txBufferSize)
+        {
+            int nWrite = tx(&txBuffer[sent], txBufferSize - sent);
+
+            if (nWrite > 0)
+            {
+                sent += nWrite;
+            }
+            else if (nWrite < 0 || writeDeadline.expired() == true)
+            {
+                break;
+            }
+        }
+
+        if (sent == txBufferSize)
+        {
+            writeStatus = sent;
+        }
+        else
+        {
+            TRACE_ERROR(SERIAL, "Cannot send %i queued packet(s) to serial port '%s' (%i/%i bytes sent)\n",
+                        txBufferPacketCount, ttyDevicePath.c_str(), sent, txBufferSize);
+            writeStatus = -1;
+        }
+
+        txBufferSize = 0;
+        txBufferPacketCount = 0;
+    }
+
+    return writeStatus;
+}
+
+int SerialPort::rxBufferFill()
+{
+    // Read as much as possible, in (up to) two chunks if the free space wraps around
+    for (int i = 0; i < 2; i++)
+    {
+        unsigned space = RX_BUFFER_SIZE - (rxBufferTail - rxBufferHead);
+        unsigned offset = rxBufferTail & (RX_BUFFER_SIZE - 1);
+        unsigned chunk = std::min(space, RX_BUFFER_SIZE - offset);
+
+        if (chunk == 0)
+        {
+            break;
+        }
+
+        int nRead = rx(&rxBuffer[offset], static_cast<int>(chunk));
+
+        if (nRead > 0)
+        {
+            rxBufferTail += static_cast<unsigned>(nRead);
+        }
+
+        if (nRead < static_cast<int>(chunk) || chunk == space)
+        {
+            break;
+        }
+    }
+
+    return rxBufferAvailable();
+}
+
+int SerialPort::rxBufferAvailable() const
+{
+    return static_cast<int>(rxBufferTail - rxBufferHead);
+}
+
+unsigned char SerialPort::rxBufferPeek(const int offset) const
+{
+    return rxBuffer[(rxBufferHead + static_cast<unsigned>(offset)) & (RX_BUFFER_SIZE - 1)];
+}
+
+int SerialPort::rxBufferPeekBlock(const unsigned char *&data) const
+{
+    unsigned offset = rxBufferHead & (RX_BUFFER_SIZE - 1);
+
+    data = &rxBuffer[offset];
+    return static_cast<int>(std::min(rxBufferTail - rxBufferHead, RX_BUFFER_SIZE - offset));
+}
+
+void SerialPort::rxBufferDrop(int count)
+{
+    if (count > rxBufferAvailable())
+    {
+        count = rxBufferAvailable();
+    }
+
+    if (count > 0)
+    {
+        rxBufferHead += static_cast<unsigned>(count);
+    }
+}
+
+int SerialPort::rxBufferPop(unsigned char *packet, int packetLength)
+{
+    int count = std::min(packetLength, rxBufferAvailable());
+
+    if (packet != NULL && count > 0)
+    {
+        unsigned offset = rxBufferHead & (RX_BUFFER_SIZE - 1);
+        unsigned first = std::min(static_cast<unsigned>(count), RX_BUFFER_SIZE - offset);
+
+        memcpy(packet, &rxBuffer[offset], first);
+        memcpy(packet + first, &rxBuffer[0], static_cast<unsigned>(count) - first);
+
+        rxBufferHead += static_cast<unsigned>(count);
+    }
+    else
+    {
+        count = 0;
+    }
+
+    return count;
+}
+
+void SerialPort::rxBufferClear()
+{
+    rxBufferHead = rxBufferTail = 0;
+}
+
 std::string SerialPort::getDeviceName()
 {
     return ttyDeviceName;
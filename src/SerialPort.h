@@ -24,6 +24,11 @@
 #define SERIALPORT_H
 
 #include "Utils.h"
+#include "Deadline.h"
+#include "SerialCapture.h"
+
+// C++ standard libraries
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -42,6 +47,58 @@
  */
 #define LATENCY_TIME_DEFAULT    (32)
 
+/*!
+ * \brief Number of response latency samples kept for each device ID.
+ *
+ * The adaptive timeout of a device is computed from a percentile of its last
+ * LATENCY_SAMPLES measured response latencies.
+ */
+#define LATENCY_SAMPLES         (16)
+
+/*!
+ * \brief Minimum number of latency samples needed before using an adaptive timeout for a device.
+ */
+#define LATENCY_SAMPLES_MIN     (8)
+
+/*!
+ * \brief Safety margin (in microseconds) added to the adaptive timeouts.
+ */
+#define LATENCY_MARGIN_US       (1000)
+
+/*!
+ * \brief LatencyStats structure, used to track the response latency of a device.
+ *
+ * The latency is the time spent waiting for a status packet, minus the time
+ * needed to actually transfer it on the serial link at the current baudrate.
+ */
+typedef struct LatencyStats
+{
+    int64_t samples[LATENCY_SAMPLES]; //!< Last measured latencies (in nanosecond)
+    int sampleCount;                  //!< Number of valid samples
+    int sampleIndex;                  //!< Index of the next sample to write
+    int64_t latency;                  //!< Latency percentile plus safety margin (in nanosecond)
+    int timeoutCount;                 //!< Number of consecutive timeouts
+
+} LatencyStats;
+
+/*!
+ * \brief Size (in byte) of the receive buffer of each serial port. Must be a power of 2.
+ *
+ * Should be large enough to hold all the status packets answering a single
+ * instruction (for instance with SYNC_READ or BULK_READ).
+ */
+#define RX_BUFFER_SIZE          (4096)
+
+/*!
+ * \brief Size (in byte) of the transmit batch buffer of each serial port.
+ */
+#define TX_BUFFER_SIZE          (2048)
+
+/*!
+ * \brief Maximum number of packets in the transmit batch buffer of each serial port.
+ */
+#define TX_BUFFER_PACKETS       (64)
+
 /*!
  * \brief Specify which serial device chip we are using.
  *
@@ -62,6 +119,37 @@ enum SerialDevices_e
     SERIAL_OTHER_CP210x  = 11,  //!< Devices based on CP210x chips
 };
 
+/*!
+ * \brief Informations about a serial port found by serialPortsScanner().
+ *
+ * USB descriptors are only available for USB adapters, and are left empty
+ * (or -1 for the IDs) otherwise.
+ */
+typedef struct SerialPortInfos
+{
+    std::string path;              //!< Serial port node (ex: "/dev/ttyUSB0").
+    int vid;                       //!< USB vendor ID, or -1 if unknown.
+    int pid;                       //!< USB product ID, or -1 if unknown.
+    std::string serial;            //!< USB serial number, if available.
+    std::string manufacturer;      //!< USB manufacturer string, if available.
+    std::string product;           //!< USB product string, if available.
+    int serialDevice;              //!< Adapter type deduced from the USB descriptors (using ::SerialDevices_e).
+} SerialPortInfos;
+
+/*!
+ * \brief Identify a serial adapter from its USB descriptors.
+ * \param vid: USB vendor ID.
+ * \param pid: USB product ID.
+ * \param manufacturer: USB manufacturer string.
+ * \param product: USB product string.
+ * \return The adapter type (using ::SerialDevices_e), or SERIAL_UNKNOWN.
+ *
+ * USB2AX adapters have their own VID/PID. USB2Dynamixel and U2D2 adapters use
+ * a stock FTDI chip, so they are told apart from other FTDI adapters with their
+ * descriptor strings.
+ */
+int identifySerialDevice(const int vid, const int pid, const std::string &manufacturer, const std::string &product);
+
 /*!
  * \brief The different return status code available for serial packet communication.
  */
@@ -115,15 +203,23 @@ protected:
     int serialDevice;              //!< Specify (if known) what TTL converter is in use. This information will be used to compute correct baudrate.
     int servoDevices;              //!< Specify if we use this serial port with Dynamixel or HerkuleX devices (using ::ServoDevices_e values). This information will be used to compute correct baudrate.
 
-    double packetStartTime;        //!< Time (in millisecond) when the packet was sent.
-    double packetWaitTime;         //!< Time (in millisecond) to wait for an answer.
-    double byteTransfertTime;      //!< Estimation of the time (in millisecond) needed to read/write one byte on the serial link.
+    Deadline packetDeadline;       //!< Deadline for the answer to the last packet sent, armed by setTimeOut().
+    int64_t byteTransfertTime;     //!< Estimation of the time (in nanosecond) needed to read/write one byte on the serial link.
 
-    /*!
-     * \brief Get the current time.
-     * \return The current time in milliseconds.
-     */
-    virtual double getTime() = 0;
+    bool ttyAdaptiveTimeOut;       //!< Use timeouts learned from the devices response latencies instead of ttyDeviceLatencyTime.
+    LatencyStats latencyStats[256];//!< Response latency statistics, for each device ID.
+    LatencyStats portLatencyStats; //!< Response latency statistics of all the devices on this serial port (so for this adapter at this baudrate).
+    int packetId;                  //!< ID of the device we are waiting an answer from (-1 if unknown).
+    int packetLength;              //!< Size of the expected answer (in byte).
+
+    unsigned char rxBuffer[RX_BUFFER_SIZE]; //!< Receive ring buffer.
+    unsigned rxBufferHead;         //!< Read counter of the receive ring buffer (use with a RX_BUFFER_SIZE-1 mask).
+    unsigned rxBufferTail;         //!< Write counter of the receive ring buffer (use with a RX_BUFFER_SIZE-1 mask).
+
+    bool txBatching;               //!< Queue packets in the transmit batch buffer instead of sending them right away.
+    unsigned char txBuffer[TX_BUFFER_SIZE]; //!< Transmit batch buffer.
+    int txBufferSize;              //!< Number of byte(s) queued in the transmit batch buffer.
+    int txBufferPacketCount;       //!< Number of packet(s) queued in the transmit batch buffer.
 
     /*!
      * \brief Set baudrate for this interface.
@@ -134,6 +230,14 @@ protected:
      */
     virtual void setBaudRate(const int baud) = 0;
 
+    /*!
+     * \brief Forget the response latency statistics of every device.
+     *
+     * Latencies learned at a given speed don't apply to another one, so this is
+     * called by setBaudRate().
+     */
+    void resetLatencyStats();
+
     /*!
      * \brief Check and convert (if needed) a Dynamixel / HerkuleX 'baudnum' into a regular 'baudrate' with a plausible value.
      * \param baud: Can be a 'baudrate' in bps or a Dynamixel / HerkuleX 'baudnum'.
@@ -173,6 +277,16 @@ protected:
      */
     virtual bool removeLock();
 
+    /*!
+     * \brief Write data sent or received on this port into the serial traffic capture, if any.
+     * \param type: CAPTURE_TX or CAPTURE_RX.
+     * \param[in] data: Data written or read.
+     * \param length: Data length in byte(s). Nothing is captured if <= 0.
+     *
+     * Backends must call it from tx() and rx() (and txBufferFlush() if overridden).
+     */
+    void capture(const int type, const unsigned char *data, const int length);
+
 public:
     /*!
      * \brief SerialPort constructor will only init some variables to default values.
@@ -198,6 +312,12 @@ public:
      */
     std::vector <std::string> scanSerialPorts();
 
+    /*!
+     * \brief Get the serial adapter type in use.
+     * \return The adapter type (using ::SerialDevices_e). Can be autodetected by the OS backend if it was not specified.
+     */
+    int getSerialDevice() const;
+
     /*!
      * \brief Open a serial link at given speed.
      * \return 1 if success, 0 if locked, -1 otherwise.
@@ -233,32 +353,178 @@ public:
 
     /*!
      * \brief Flush non-read input data.
+     *
+     * Implementations must also discard the receive buffer content, using rxBufferClear().
      */
     virtual void flush() = 0;
 
+    /*!
+     * \brief Enable or disable TX batching.
+     * \param enabled: If true, packets are queued with txBufferPush() until the next txBufferFlush().
+     *
+     * Disabling TX batching sends any packet still queued.
+     */
+    void setTxBatching(const bool enabled);
+
+    /*!
+     * \brief Check if TX batching is enabled.
+     */
+    bool getTxBatching() const;
+
+    /*!
+     * \brief Queue a packet into the transmit batch buffer.
+     * \param[in] packet: Data packet to queue (it is copied).
+     * \param packetLength: Size in byte(s) of data packet to queue.
+     * \return Size in byte(s) queued, or -1 in case of error.
+     *
+     * If the transmit batch buffer is full, the packets already queued are sent first.
+     * Packets larger than the transmit batch buffer are sent right away.
+     */
+    int txBufferPush(const unsigned char *packet, int packetLength);
+
+    /*!
+     * \brief Send all the packets queued in the transmit batch buffer.
+     * \return Size in byte(s) sent to the serial link, or -1 if the whole batch could not be sent.
+     *
+     * The queued packets are contiguous, so they are sent with a single tx() call.
+     * After a partial write, the remainder is sent again until the batch had
+     * enough time to go through the serial link. On error, the batch is dropped
+     * and the packet that triggered the flush should be reported as failed.
+     */
+    virtual int txBufferFlush();
+
+    /*!
+     * \brief Move all the data available on the serial link into the receive buffer.
+     * \return The number of byte(s) available in the receive buffer.
+     *
+     * Everything the OS has already received is read at once (as long as the
+     * receive buffer is not full), so a single system call is usually needed.
+     */
+    int rxBufferFill();
+
+    /*!
+     * \brief Get the number of byte(s) available in the receive buffer.
+     */
+    int rxBufferAvailable() const;
+
+    /*!
+     * \brief Read a byte from the receive buffer without removing it.
+     * \param offset: Position of the byte, from the beginning of the receive buffer. Must be < rxBufferAvailable().
+     */
+    unsigned char rxBufferPeek(const int offset) const;
+
+    /*!
+     * \brief Access the beginning of the receive buffer without copying it.
+     * \param[out] data: Pointer to the first byte of the receive buffer.
+     * \return The number of contiguous byte(s) readable from 'data'.
+     *
+     * As the receive buffer is a ring, the data available may be split in two
+     * blocks: once the first one has been consumed (with rxBufferDrop()), the
+     * next call returns the second one.
+     */
+    int rxBufferPeekBlock(const unsigned char *&data) const;
+
+    /*!
+     * \brief Remove byte(s) from the beginning of the receive buffer.
+     * \param count: Number of byte(s) to remove.
+     */
+    void rxBufferDrop(int count);
+
+    /*!
+     * \brief Move byte(s) from the beginning of the receive buffer into a packet.
+     * \param[out] packet: Data packet.
+     * \param packetLength: Number of byte(s) to move.
+     * \return The number of byte(s) moved.
+     */
+    int rxBufferPop(unsigned char *packet, int packetLength);
+
+    /*!
+     * \brief Discard the content of the receive buffer.
+     */
+    void rxBufferClear();
+
     /*!
      * \brief Set the serial port latency value, used to compute timeout duration for packet reception.
      * \param latency: The latency value in millisecond.
      */
     virtual void setLatency(int latency);
 
+    /*!
+     * \brief Get the serial port latency value.
+     * \return The latency value in millisecond.
+     */
+    int getLatency();
+
     /*!
      * \brief Set the maximum duration to wait for an answer, computed from packetLength and latencyTime.
      * \param packetLength: Number of byte to received, will be used to compute the duration of the timeout.
      */
-    virtual void setTimeOut(int packetLength) = 0;
+    virtual void setTimeOut(int packetLength);
+
+    /*!
+     * \brief Set the maximum duration to wait for an answer from a given device.
+     * \param packetLength: Number of byte to received, will be used to compute the duration of the timeout.
+     * \param id: The ID of the device that will answer.
+     *
+     * If enough latency samples have been gathered for this device, the timeout
+     * is computed from them (a percentile plus a safety margin). Otherwise, and
+     * if adaptive timeouts are disabled, the latencyTime based timeout is used.
+     * The latencyTime based timeout is always an upper bound.
+     *
+     * After a timeout, the latencyTime based timeout is used again from time
+     * to time (with an exponential backoff) to catch slower answers. Devices that
+     * never answered use the latency learned from the other devices of this port
+     * between these attempts, so missing devices do not stall the bus.
+     */
+    virtual void setTimeOut(int packetLength, int id);
 
     /*!
      * \brief Set the maximum duration to wait for an answer.
      * \param msec: Duration of the timeout in millisecond.
      */
-    virtual void setTimeOut(double msec) = 0;
+    virtual void setTimeOut(double msec);
 
     /*!
      * \brief Check if the response has timeouted.
      * \return 1 if timeout, 0 if we still need to wait.
      */
-    virtual int checkTimeOut() = 0;
+    virtual int checkTimeOut();
+
+    /*!
+     * \brief Update the latency statistics of the device we were waiting an answer from.
+     * \param status: The status of the transaction, using ::SerialErrorCodes_e values.
+     *
+     * Must be called once the transaction armed with setTimeOut(packetLength, id) is over.
+     * Only COMM_RXSUCCESS and COMM_RXTIMEOUT status are used.
+     */
+    void updateLatency(const int status);
+
+    /*!
+     * \brief Enable or disable adaptive timeouts.
+     * \param enabled: If false, only the latencyTime based timeout will be used.
+     */
+    void setAdaptiveTimeOut(const bool enabled);
+
+    /*!
+     * \brief Wait until some data are available on the serial link, or until the current timeout is reached.
+     * \return 1 if data are available, 0 if the timeout has been reached, -1 in case of error.
+     *
+     * This function put the calling thread to sleep instead of spinning on rx()
+     * while waiting for a status packet. The timeout is the one set with the last
+     * call to setTimeOut().
+     *
+     * The default implementation does not block and only reports timeouts, serial
+     * port backends able to wait on their device (poll(), ...) should override it.
+     */
+    virtual int waitData();
+
+    /*!
+     * \brief Setup the serial device for low latency communication, if the serial port backend supports it.
+     * \return True if low latency settings are effective on the device.
+     *
+     * The default implementation does nothing and returns false.
+     */
+    virtual bool switchHighSpeed();
 
     /*!
      * \brief Get serial device name.
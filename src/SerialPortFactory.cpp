@@ -0,0 +1,117 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortFactory.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#include "SerialPortFactory.h"
+#include "SerialPortLoopback.h"
+#include "SerialPortReplay.h"
+#include "SerialPortLinux.h"
+#include "SerialPortWindows.h"
+#include "SerialPortMacOS.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <map>
+#include <mutex>
+
+static SerialPort *createLoopbackPort(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices)
+{
+    return new SerialPortLoopback(devicePath, baud, serialDevice, servoDevices);
+}
+
+static SerialPort *createReplayPort(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices)
+{
+    return new SerialPortReplay(devicePath, baud, serialDevice, servoDevices);
+}
+
+/*!
+ * \brief Registered backends, indexed by device path prefix.
+ */
+static std::map <std::string, SerialPortBackend_t> &serialPortBackends()
+{
+    static std::map <std::string, SerialPortBackend_t> backends = {{"loop://", createLoopbackPort},
+                                                                  {"replay://", createReplayPort}};
+    return backends;
+}
+
+static std::mutex serialPortBackendsLock;
+
+bool registerSerialPortBackend(const std::string &prefix, SerialPortBackend_t backend)
+{
+    bool status = false;
+
+    if (prefix.empty() == false)
+    {
+        std::lock_guard <std::mutex> lock(serialPortBackendsLock);
+
+        if (backend != NULL)
+        {
+            serialPortBackends()[prefix] = backend;
+            TRACE_INFO(SERIAL, "Serial port backend registered for '%s' devices\n", prefix.c_str());
+        }
+        else
+        {
+            serialPortBackends().erase(prefix);
+        }
+
+        status = true;
+    }
+    else
+    {
+        TRACE_ERROR(SERIAL, "Cannot register a serial port backend without device path prefix!\n");
+    }
+
+    return status;
+}
+
+SerialPort *createSerialPort(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices)
+{
+    SerialPortBackend_t backend = NULL;
+
+    {
+        std::lock_guard <std::mutex> lock(serialPortBackendsLock);
+
+        for (auto const &b: serialPortBackends())
+        {
+            if (devicePath.compare(0, b.first.size(), b.first) == 0)
+            {
+                backend = b.second;
+                break;
+            }
+        }
+    }
+
+    if (backend != NULL)
+    {
+        return backend(devicePath, baud, serialDevice, servoDevices);
+    }
+
+    // Instanciate a different serial subclass, depending on the current OS
+#if defined(__linux__) || defined(__gnu_linux)
+    return new SerialPortLinux(devicePath, baud, serialDevice, servoDevices);
+#elif defined(_WIN32) || defined(_WIN64)
+    return new SerialPortWindows(devicePath, baud, serialDevice, servoDevices);
+#elif defined(__APPLE__) || defined(__MACH__)
+    return new SerialPortMacOS(devicePath, baud, serialDevice, servoDevices);
+#else
+    #error "No compatible operating system detected!"
+#endif
+}
@@ -0,0 +1,66 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortFactory.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#ifndef SERIALPORT_FACTORY_H
+#define SERIALPORT_FACTORY_H
+
+#include "SerialPort.h"
+
+// C++ standard libraries
+#include <string>
+
+/*!
+ * \brief Function creating a SerialPort instance, used to register a serial port backend.
+ * \param devicePath: The path to the serial device, including the backend prefix.
+ * \param baud: The baudrate or Dynamixel / HerkuleX 'baudnum'.
+ * \param serialDevice: Specify (if known) what TTL converter is in use (using ::SerialDevices_e).
+ * \param servoDevices: Specify if we use this serial port with Dynamixel or HerkuleX devices (using ::ServoDevices_e).
+ * \return A new SerialPort instance (owned by the caller), or NULL in case of error.
+ */
+typedef SerialPort *(*SerialPortBackend_t)(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices);
+
+/*!
+ * \brief Register a serial port backend.
+ * \param prefix: Device path prefix handled by this backend (ex: "loop://").
+ * \param backend: Function creating the SerialPort instances, or NULL to unregister the prefix.
+ * \return True if the backend has been (un)registered.
+ *
+ * Device paths starting with a registered prefix are handled by the matching
+ * backend. Other device paths (or "auto") use the serial port implementation
+ * of the current operating system.
+ */
+bool registerSerialPortBackend(const std::string &prefix, SerialPortBackend_t backend);
+
+/*!
+ * \brief Create a SerialPort instance for a device path, using the matching backend.
+ * \param devicePath: The path to the serial device (ex: "/dev/ttyUSB0", "COM1", "loop://bus0").
+ * \param baud: The baudrate or Dynamixel / HerkuleX 'baudnum'.
+ * \param serialDevice: Specify (if known) what TTL converter is in use (using ::SerialDevices_e).
+ * \param servoDevices: Specify if we use this serial port with Dynamixel or HerkuleX devices (using ::ServoDevices_e).
+ * \return A new SerialPort instance (owned by the caller), or NULL in case of error.
+ *
+ * The "loop://" and "replay://" prefixes are always available, and create
+ * SerialPortLoopback and SerialPortReplay instances.
+ */
+SerialPort *createSerialPort(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices);
+
+#endif /* SERIALPORT_FACTORY_H */
@@ -27,10 +27,12 @@
 
 // Linux specifics
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <linux/serial.h>
 #include <sys/ioctl.h>
-#include <sys/time.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 // Device lock support
 #include <lockdev.h>
@@ -43,71 +45,250 @@
 // C++ standard libraries
 #include <fstream>
 #include <sstream>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <mutex>
 #include <thread>
 
-int serialPortsScanner(std::vector <std::string> &availableSerialPorts)
+// Serial ports scanner cache
+static std::mutex scannerCacheLock;
+static std::string scannerCacheRoot;
+static std::string scannerCacheSignature;
+static std::vector <SerialPortInfos> scannerCache;
+
+/*!
+ * \brief Read the first line of a sysfs attribute file.
+ * \param path: The path to the sysfs attribute.
+ * \return The value read, or an empty string.
+ */
+static std::string sysfsReadString(const std::string &path)
 {
-    int retcode = 0;
-    std::string portBase = "/dev/tty";
-    std::string portVariations[4] = {"USB", "ACM", "S", ""};
+    std::string value;
+    std::ifstream file(path);
 
-    TRACE_INFO(SERIAL, "serialPortsScanner() [Linux variant]\n");
+    if (file.good())
+    {
+        std::getline(file, value);
+    }
 
-    // Serial ports from USB adapters (/dev/ttyUSB*) (ftdi or other chips)
-    // Serial ports from USB adapters (/dev/ttyACM*) ("abstract control model")
-    // Regular Serial ports from motherboards (/dev/ttyS*)
-    // Regular Serial ports from motherboards (/dev/tty*)
+    return value;
+}
 
-    for (int i = 0; i < 2; i++)
+/*!
+ * \brief Read an hexadecimal value (like USB IDs) from a sysfs attribute file.
+ * \param path: The path to the sysfs attribute.
+ * \return The value read, or -1.
+ */
+static int sysfsReadHex(const std::string &path)
+{
+    int value = -1;
+    std::string str = sysfsReadString(path);
+
+    if (str.empty() == false)
+    {
+        char *end = NULL;
+        long v = strtol(str.c_str(), &end, 16);
+
+        if (end != str.c_str())
+        {
+            value = static_cast<int>(v);
+        }
+    }
+
+    return value;
+}
+
+/*!
+ * \brief Read the USB descriptors of a tty from sysfs.
+ * \param classPath: Path to the tty class ("<sysfs>/class/tty").
+ * \param name: Name of the tty (ex: "ttyUSB0").
+ * \return The serial port informations.
+ */
+static SerialPortInfos serialPortDescribe(const std::string &classPath, const std::string &name)
+{
+    SerialPortInfos infos;
+    infos.path = "/dev/" + name;
+    infos.vid = -1;
+    infos.pid = -1;
+    infos.serialDevice = SERIAL_UNKNOWN;
+
+    // Walk up from the tty device (an USB interface, or an usb-serial port
+    // below it) to the USB device holding the descriptors
+    char *real_path = realpath((classPath + "/" + name + "/device").c_str(), NULL);
+    if (real_path != NULL)
+    {
+        std::string usbPath(real_path);
+        free(real_path);
+
+        for (int i = 0; i < 4 && usbPath.size() > 1; i++)
+        {
+            if (access((usbPath + "/idVendor").c_str(), F_OK) == 0)
+            {
+                infos.vid = sysfsReadHex(usbPath + "/idVendor");
+                infos.pid = sysfsReadHex(usbPath + "/idProduct");
+                infos.serial = sysfsReadString(usbPath + "/serial");
+                infos.manufacturer = sysfsReadString(usbPath + "/manufacturer");
+                infos.product = sysfsReadString(usbPath + "/product");
+                break;
+            }
+
+            usbPath = usbPath.substr(0, usbPath.find_last_of('/'));
+        }
+    }
+
+    infos.serialDevice = identifySerialDevice(infos.vid, infos.pid, infos.manufacturer, infos.product);
+
+    return infos;
+}
+
+/*!
+ * \brief Serial ports ordering: ttyUSB* first, then ttyACM*, each in numerical order.
+ */
+static bool serialPortOrder(const SerialPortInfos &a, const SerialPortInfos &b)
+{
+    int rank_a = (a.path.find("ttyUSB") != std::string::npos) ? 0 : 1;
+    int rank_b = (b.path.find("ttyUSB") != std::string::npos) ? 0 : 1;
+
+    if (rank_a != rank_b)
+    {
+        return rank_a < rank_b;
+    }
+    if (a.path.size() != b.path.size())
+    {
+        return a.path.size() < b.path.size();
+    }
+
+    return a.path < b.path;
+}
+
+int serialPortsScanner(std::vector <SerialPortInfos> &availableSerialPorts, const std::string &sysfsRoot)
+{
+    std::string classPath = sysfsRoot + "/class/tty";
+    std::vector <std::string> names;
+    std::string signature;
+
+    TRACE_INFO(SERIAL, "serialPortsScanner() [Linux variant]\n");
+
+    // List the tty entries backed by an USB device. This only reads the sysfs
+    // symlinks, and doubles as the cache signature: sysfs entries are created
+    // again (with new inodes) when an adapter is plugged or replaced.
+    DIR *dir = opendir(classPath.c_str());
+    if (dir != NULL)
     {
-        for (int j = 0; j < 8; j++)
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL)
         {
-            std::string portPath = portBase + portVariations[i] + std::to_string(j);
-            std::string portName = "tty" + portVariations[i] + std::to_string(j);
+            if (entry->d_name[0] == '.')
+            {
+                continue;
+            }
 
-            // Open arguments:
-            // O_RDONLY: Request opening the file read/write
-            // O_NOCTTY: If the named file is a terminal device, don't make it the controlling terminal for the process
+            std::string entryPath = classPath + "/" + entry->d_name;
+            char target[512];
 
-            int fd = open(portPath.c_str(), O_RDONLY | O_NOCTTY);
-            if (fd > 0)
+            ssize_t len = readlink(entryPath.c_str(), target, sizeof(target) - 1);
+            if (len > 0)
             {
-//#ifdef LOCK_LOCKDEV
-//                if (dev_testlock(portName.c_str()) == 0)
-//#endif
+                target[len] = '\0';
+
+                if (strstr(target, "/usb") != NULL)
                 {
-                    // Used to validate existing serial port availability (currently disabled)
-                    //struct serial_struct serinfo;
-                    //if (ioctl(fd, TIOCGSERIAL, &serinfo) > -1)
+                    struct stat st;
+                    if (lstat(entryPath.c_str(), &st) == 0)
                     {
-                        TRACE_INFO(SERIAL, "- Scanning for serial port on '%s' > FOUND\n", portPath.c_str());
-                        availableSerialPorts.push_back(portPath);
-                        retcode++;
+                        names.push_back(entry->d_name);
+                        signature += std::string(entry->d_name) + ">" + target + "@" + std::to_string(st.st_ino) + ";";
                     }
                 }
-//#ifdef LOCK_LOCKDEV
-//                else
-//                {
-//                    TRACE_WARNING(SERIAL, "- Scanning for serial port on '%s' > LOCKED\n", portPath.c_str());
-//                }
-//#endif
-                close(fd);
             }
         }
+
+        closedir(dir);
+    }
+    else
+    {
+        TRACE_WARNING(SERIAL, "Unable to list serial ports from '%s'\n", classPath.c_str());
+    }
+
+    std::lock_guard <std::mutex> lock(scannerCacheLock);
+
+    if (sysfsRoot != scannerCacheRoot || signature != scannerCacheSignature)
+    {
+        scannerCache.clear();
+
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            scannerCache.push_back(serialPortDescribe(classPath, names.at(i)));
+        }
+        std::sort(scannerCache.begin(), scannerCache.end(), serialPortOrder);
+
+        for (size_t i = 0; i < scannerCache.size(); i++)
+        {
+            TRACE_INFO(SERIAL, "- Scanning for serial port on '%s' > FOUND (%04x:%04x '%s')\n",
+                       scannerCache.at(i).path.c_str(), scannerCache.at(i).vid, scannerCache.at(i).pid,
+                       scannerCache.at(i).product.c_str());
+        }
+
+        scannerCacheRoot = sysfsRoot;
+        scannerCacheSignature = signature;
+    }
+
+    availableSerialPorts.insert(availableSerialPorts.end(), scannerCache.begin(), scannerCache.end());
+
+    return static_cast<int>(scannerCache.size());
+}
+
+int serialPortsScanner(std::vector <std::string> &availableSerialPorts)
+{
+    std::vector <SerialPortInfos> ports;
+    int retcode = serialPortsScanner(ports);
+
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        availableSerialPorts.push_back(ports.at(i).path);
     }
 
     return retcode;
 }
 
+int serialPortIdentify(const std::string &devicePath, const std::string &sysfsRoot)
+{
+    int device = SERIAL_UNKNOWN;
+    std::string path = devicePath;
+
+    // Resolve symlinks (ex: "/dev/serial/by-id/xxx" > "/dev/ttyUSB0")
+    char *real_path = realpath(devicePath.c_str(), NULL);
+    if (real_path != NULL)
+    {
+        path = real_path;
+        free(real_path);
+    }
+
+    std::vector <SerialPortInfos> ports;
+    serialPortsScanner(ports, sysfsRoot);
+
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        if (ports.at(i).path == path)
+        {
+            device = ports.at(i).serialDevice;
+            break;
+        }
+    }
+
+    return device;
+}
+
 SerialPortLinux::SerialPortLinux(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices):
     SerialPort(serialDevice, servoDevices),
     ttyDeviceFileDescriptor(-1),
     ttyDeviceBaudRateFlag(B1000000),
     ttyCustomSpeed(false),
-    ttyLowLatency(false)
+    ttyLowLatency(false),
+    ttySysfsRoot("/sys")
 {
     if (devicePath.empty() == 1 || devicePath == "auto")
     {
@@ -120,6 +301,12 @@ SerialPortLinux::SerialPortLinux(std::string &devicePath, const int baud, const
 
     if (ttyDevicePath != "null")
     {
+        // Identify the adapter from its USB descriptors, if not specified
+        if (this->serialDevice == SERIAL_UNKNOWN)
+        {
+            this->serialDevice = serialPortIdentify(ttyDevicePath, ttySysfsRoot);
+        }
+
         size_t found = ttyDevicePath.rfind("/");
         if (found != std::string::npos && found != ttyDevicePath.size())
         {
@@ -136,14 +323,13 @@ SerialPortLinux::SerialPortLinux(std::string &devicePath, const int baud, const
         TRACE_INFO(SERIAL, "- Device node has been set to: '%s'\n", ttyDevicePath.c_str());
         TRACE_INFO(SERIAL, "- Device baud rate has been set to: '%i'\n", ttyDeviceBaudRate);
     }
-/*
+
     // Autodetect latency time value for FTDI based devices
-    if (serialDevice == SERIAL_USB2DYNAMIXEL || serialDevice == SERIAL_OTHER_FTDI)
+    if (this->serialDevice == SERIAL_USB2DYNAMIXEL || this->serialDevice == SERIAL_OTHER_FTDI)
     {
         setLatency(0);
         TRACE_INFO(SERIAL, "- Device latency time has been set to: '%i'\n", ttyDeviceLatencyTime);
     }
-*/
 }
 
 SerialPortLinux::~SerialPortLinux()
@@ -161,7 +347,10 @@ void SerialPortLinux::setBaudRate(const int baud)
 
     // Compute the time needed to transfert one byte through the serial interface
     // (1000 / baudrate(= bit per msec)) * 10(= start bit + 8 data bit + stop bit)
-    byteTransfertTime = (1000.0 / static_cast<double>(ttyDeviceBaudRate)) * 10.0;
+    byteTransfertTime = 10000000000LL / static_cast<int64_t>(ttyDeviceBaudRate);
+
+    // The response latencies learned at the previous speed don't apply anymore
+    resetLatencyStats();
 }
 
 static int rate_to_constant(int baudrate)
@@ -489,31 +678,45 @@ int SerialPortLinux::openLink()
         // Get current serial_struct values
         if (ioctl(ttyDeviceFileDescriptor, TIOCGSERIAL, &serinfo) < 0)
         {
-            TRACE_ERROR(SERIAL, "Cannot get serial infos structure from serial port: '%s'\n", ttyDevicePath.c_str());
-            goto OPEN_LINK_ERROR;
-        }
+            if (ttyCustomSpeed == true)
+            {
+                TRACE_ERROR(SERIAL, "Cannot get serial infos structure from serial port: '%s'\n", ttyDevicePath.c_str());
+                goto OPEN_LINK_ERROR;
+            }
 
-        if (ttyCustomSpeed == true)
+            // The low latency flag is only an optimization, and many drivers
+            // (PTYs, USB-ACM, ...) don't support these ioctls
+            TRACE_WARNING(SERIAL, "Cannot get serial infos structure from serial port: '%s', ASYNC_LOW_LATENCY flag not set\n", ttyDevicePath.c_str());
+        }
+        else
         {
-            serinfo.flags &= ~ASYNC_SPD_MASK;
-            serinfo.flags |= ASYNC_SPD_CUST;
-            serinfo.custom_divisor = serinfo.baud_base / ttyDeviceBaudRate;
-            if (serinfo.custom_divisor < 1)
+            if (ttyCustomSpeed == true)
             {
-                serinfo.custom_divisor = 1;
+                serinfo.flags &= ~ASYNC_SPD_MASK;
+                serinfo.flags |= ASYNC_SPD_CUST;
+                serinfo.custom_divisor = serinfo.baud_base / ttyDeviceBaudRate;
+                if (serinfo.custom_divisor < 1)
+                {
+                    serinfo.custom_divisor = 1;
+                }
             }
-        }
 
-        if (ttyLowLatency == true)
-        {
-            serinfo.flags |= ASYNC_LOW_LATENCY;
-        }
+            if (ttyLowLatency == true)
+            {
+                serinfo.flags |= ASYNC_LOW_LATENCY;
+            }
 
-        // Set serial_struct
-        if (ioctl(ttyDeviceFileDescriptor, TIOCSSERIAL, &serinfo) < 0)
-        {
-            TRACE_ERROR(SERIAL, "Cannot set serial infos structure with custom baud divisor (%s) to serial port: '%s'\n", ttyDeviceBaudRate, ttyDevicePath.c_str());
-            goto OPEN_LINK_ERROR;
+            // Set serial_struct
+            if (ioctl(ttyDeviceFileDescriptor, TIOCSSERIAL, &serinfo) < 0)
+            {
+                if (ttyCustomSpeed == true)
+                {
+                    TRACE_ERROR(SERIAL, "Cannot set serial infos structure with custom baud divisor (%i) to serial port: '%s'\n", ttyDeviceBaudRate, ttyDevicePath.c_str());
+                    goto OPEN_LINK_ERROR;
+                }
+
+                TRACE_WARNING(SERIAL, "Cannot set ASYNC_LOW_LATENCY flag on serial port: '%s'\n", ttyDevicePath.c_str());
+            }
         }
     }
 
@@ -564,6 +767,7 @@ int SerialPortLinux::tx(unsigned char *packet, int packetLength)
         if (packet != NULL && packetLength > 0)
         {
             writeStatus = write(ttyDeviceFileDescriptor, packet, packetLength);
+            capture(CAPTURE_TX, packet, writeStatus);
 
             if (writeStatus < 0)
             {
@@ -591,8 +795,8 @@ int SerialPortLinux::rx(unsigned char *packet, int packetLength)
     {
         if (packet != NULL && packetLength > 0)
         {
-            memset(packet, 0, packetLength);
             readStatus = read(ttyDeviceFileDescriptor, packet, packetLength);
+            capture(CAPTURE_RX, packet, readStatus);
 
             if (readStatus < 0)
             {
@@ -622,90 +826,265 @@ void SerialPortLinux::flush()
 
         tcflush(ttyDeviceFileDescriptor, TCIFLUSH);
     }
+
+    rxBufferClear();
 }
 
-double SerialPortLinux::getTime()
+int SerialPortLinux::waitData()
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+    int status = -1;
 
-    return (static_cast<double>(tv.tv_sec) * 1000.0 + static_cast<double>(tv.tv_usec) / 1000.0);
+    if (isOpen() == true)
+    {
+        int64_t time_left = packetDeadline.remaining();
+
+        if (time_left > 0)
+        {
+            struct pollfd pfd;
+            pfd.fd = ttyDeviceFileDescriptor;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+
+            // ppoll() takes a timespec, so sub-millisecond timeouts are not rounded up
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(time_left / 1000000000LL);
+            ts.tv_nsec = static_cast<long>(time_left % 1000000000LL);
+
+            int pollStatus = ppoll(&pfd, 1, &ts, NULL);
+
+            if (pollStatus > 0)
+            {
+                status = 1;
+            }
+            else if (pollStatus == 0)
+            {
+                status = 0;
+            }
+            else if (errno == EINTR)
+            {
+                // Interrupted by a signal, let the caller try again
+                status = 1;
+            }
+            else
+            {
+                TRACE_ERROR(SERIAL, "Cannot wait on serial port '%s': ppoll() failed with error code '%i'!\n", ttyDevicePath.c_str(), errno);
+            }
+        }
+        else
+        {
+            status = 0;
+        }
+    }
+    else
+    {
+        TRACE_ERROR(SERIAL, "Cannot wait on serial port '%s': invalid device!\n", ttyDevicePath.c_str());
+    }
+
+    return status;
 }
 
-bool SerialPortLinux::switchHighSpeed()
+/*!
+ * \brief Read an integer value from a sysfs attribute file.
+ * \param path: The path to the sysfs attribute.
+ * \param[out] value: The value read.
+ * \return True if the value has been read successfully.
+ */
+static bool sysfsReadInt(const std::string &path, int &value)
 {
     bool status = false;
+    std::ifstream file(path);
 
-    // TODO // enables "ASYNC_LOW_LATENCY" flag
-    // reduce the "/sys/bus/usb-serial/devices/ttyXXX/latency_timer" value
+    if (file.good())
+    {
+        int v = 0;
+        file >> v;
+
+        if (!file.fail())
+        {
+            value = v;
+            status = true;
+        }
+    }
 
     return status;
 }
 
-void SerialPortLinux::setLatency(int latency)
+/*!
+ * \brief Write an integer value into a sysfs attribute file.
+ * \param path: The path to the sysfs attribute.
+ * \param value: The value to write.
+ * \return True if the value has been written successfully.
+ */
+static bool sysfsWriteInt(const std::string &path, const int value)
 {
-    // "auto-detect" latency value if possible
-    // note: this doesn't really produce expected results yet..
-    if (latency == 0)
+    bool status = false;
+    std::ofstream file(path);
+
+    if (file.good())
     {
-        size_t lastbackslash = ttyDevicePath.find_last_of('/');
+        file << value << std::endl;
+        status = !file.fail();
+    }
 
-        if (lastbackslash != std::string::npos)
+    return status;
+}
+
+void SerialPortLinux::setSysfsRoot(const std::string &root)
+{
+    ttySysfsRoot = root;
+}
+
+std::string SerialPortLinux::getLatencyTimerPath()
+{
+    std::string latency_path;
+    std::string tty = ttyDeviceName;
+
+    // Resolve symlinks (ex: "/dev/serial/by-id/xxx" > "/dev/ttyUSB0")
+    char *real_path = realpath(ttyDevicePath.c_str(), NULL);
+    if (real_path != NULL)
+    {
+        std::string rp(real_path);
+        free(real_path);
+
+        size_t found = rp.find_last_of('/');
+        if (found != std::string::npos)
+        {
+            tty = rp.substr(found + 1);
+        }
+    }
+
+    // The latency_timer attribute can be found through the usb-serial bus or the tty class
+    std::string candidates[2] = {ttySysfsRoot + "/bus/usb-serial/devices/" + tty + "/latency_timer",
+                                 ttySysfsRoot + "/class/tty/" + tty + "/device/latency_timer"};
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (access(candidates[i].c_str(), F_OK) == 0)
         {
-            std::string latency_path = "/sys/bus/usb-serial/devices/" + ttyDevicePath.substr(lastbackslash+1) + "/latency_timer";
-            std::ifstream latency_file(latency_path);
+            latency_path = candidates[i];
+            break;
+        }
+    }
+
+    return latency_path;
+}
 
-            if (latency_file.good())
+bool SerialPortLinux::switchHighSpeed()
+{
+    bool status = true;
+
+    // Reduce the latency_timer value of the adapter (FTDI based adapters only)
+    ////////////////////////////////////////////////////////////////////////////
+
+    std::string latency_path = getLatencyTimerPath();
+
+    if (latency_path.empty() == false)
+    {
+        int latency_timer = -1;
+        sysfsReadInt(latency_path, latency_timer);
+
+        if (latency_timer != 1)
+        {
+            // Writing into latency_timer usually requires root credentials
+            if (sysfsWriteInt(latency_path, 1) == false)
             {
-                char latency_value[8];
-                latency_file.getline(latency_value, 8);
-                latency = std::stoi(latency_value);
+                TRACE_WARNING(SERIAL, "Unable to write into '%s' (missing credentials?)\n", latency_path.c_str());
             }
-            latency_file.close();
+
+            // Read back the effective value
+            sysfsReadInt(latency_path, latency_timer);
         }
-        else
+
+        if (latency_timer > 0)
         {
-            TRACE_ERROR(SERIAL, "Unable to find latency info for the current device: '%s'\n", ttyDevicePath.substr(lastbackslash+1).c_str());
+            setLatency(latency_timer);
         }
+
+        if (latency_timer != 1)
+        {
+            status = false;
+        }
+
+        TRACE_INFO(SERIAL, "- Device latency_timer is: '%i' ms\n", latency_timer);
+    }
+    else
+    {
+        TRACE_INFO(SERIAL, "- No latency_timer found for device '%s' (not an FTDI based adapter?)\n", ttyDevicePath.c_str());
+        status = false;
     }
 
-    if (latency > 0 && latency < 128)
+    // Enable the ASYNC_LOW_LATENCY flag
+    ////////////////////////////////////////////////////////////////////////////
+
+    // Will be applied on next openLink() if the link is not open yet
+    ttyLowLatency = true;
+
+    if (isOpen() == true)
     {
-        ttyDeviceLatencyTime = latency;
+        struct serial_struct serinfo;
+        memset(&serinfo, 0, sizeof(serinfo));
+
+        if (ioctl(ttyDeviceFileDescriptor, TIOCGSERIAL, &serinfo) == 0)
+        {
+            if ((serinfo.flags & ASYNC_LOW_LATENCY) == 0)
+            {
+                serinfo.flags |= ASYNC_LOW_LATENCY;
+                ioctl(ttyDeviceFileDescriptor, TIOCSSERIAL, &serinfo);
+
+                // Read back the effective flags
+                memset(&serinfo, 0, sizeof(serinfo));
+                ioctl(ttyDeviceFileDescriptor, TIOCGSERIAL, &serinfo);
+            }
+
+            if (serinfo.flags & ASYNC_LOW_LATENCY)
+            {
+                TRACE_INFO(SERIAL, "- Device ASYNC_LOW_LATENCY flag is: 'enabled'\n");
+            }
+            else
+            {
+                TRACE_WARNING(SERIAL, "- Device ASYNC_LOW_LATENCY flag is: 'disabled'\n");
+                status = false;
+            }
+        }
+        else
+        {
+            TRACE_WARNING(SERIAL, "Cannot get serial infos structure from serial port: '%s'\n", ttyDevicePath.c_str());
+            status = false;
+        }
     }
     else
     {
-        TRACE_WARNING(SERIAL, "Invalid latency value: '%i', not in ]0;128[ range.\n", latency);
+        // Nothing to read back yet
+        TRACE_INFO(SERIAL, "- Device ASYNC_LOW_LATENCY flag will be set on next openLink()\n");
+        status = false;
     }
-}
 
-void SerialPortLinux::setTimeOut(int packetLength)
-{
-    packetStartTime = getTime();
-    packetWaitTime  = (byteTransfertTime * static_cast<double>(packetLength) + 2.0 * static_cast<double>(ttyDeviceLatencyTime));
-}
+    TRACE_INFO(SERIAL, "- Device latency time has been set to: '%i'\n", ttyDeviceLatencyTime);
 
-void SerialPortLinux::setTimeOut(double msec)
-{
-    packetStartTime = getTime();
-    packetWaitTime  = msec;
+    return status;
 }
 
-int SerialPortLinux::checkTimeOut()
+void SerialPortLinux::setLatency(int latency)
 {
-    int status = 0;
-    double time_elapsed = getTime() - packetStartTime;
+    // "auto-detect" latency value if possible, using the adapter latency_timer
+    if (latency == 0)
+    {
+        std::string latency_path = getLatencyTimerPath();
+
+        if (latency_path.empty() == true || sysfsReadInt(latency_path, latency) == false)
+        {
+            TRACE_ERROR(SERIAL, "Unable to find latency info for the current device: '%s'\n", ttyDevicePath.c_str());
+        }
+    }
 
-    if (time_elapsed > packetWaitTime)
+    if (latency > 0 && latency < 128)
     {
-        status = 1;
+        ttyDeviceLatencyTime = latency;
     }
-    else if (time_elapsed < 0)
+    else
     {
-        packetStartTime = getTime();
+        TRACE_WARNING(SERIAL, "Invalid latency value: '%i', not in ]0;128[ range.\n", latency);
     }
-
-    return status;
 }
 
 #endif /* __linux__ || __gnu_linux */
@@ -32,14 +32,34 @@
  * \param[out] availableSerialPorts: A list of serial port nodes (ex: /dev/ttyUSB0).
  * \return The number of serial ports found.
  *
- * \todo Use stat() instead of open().
- *
- * Scans for /dev/ttyUSB* and /dev/ttyACM* ports. Regular serial devices on
- * /dev/ttyS* are not scanned as they are always considered as valid even with
- * no USB2Dynamixel / USB2AX or TTL adapter attached.
+ * Scans for USB serial ports (/dev/ttyUSB* and /dev/ttyACM*) through sysfs,
+ * see the SerialPortInfos variant. Regular serial devices on /dev/ttyS* are
+ * not scanned as they are always considered as valid even with no
+ * USB2Dynamixel / USB2AX or TTL adapter attached.
  */
 int serialPortsScanner(std::vector <std::string> &availableSerialPorts);
 
+/*!
+ * \brief The serial ports scanner function, with USB adapter informations.
+ * \param[out] availableSerialPorts: A list of serial ports, with their USB descriptors and adapter type.
+ * \param sysfsRoot: Root of the sysfs filesystem (default is "/sys").
+ * \return The number of serial ports found.
+ *
+ * Lists "<sysfs>/class/tty" and keeps the entries backed by an USB device.
+ * Device nodes are never opened, so ports used by other processes are not
+ * disturbed. The results are cached, and only refreshed when the list of USB
+ * tty entries changes (adapter plugged, unplugged or replaced).
+ */
+int serialPortsScanner(std::vector <SerialPortInfos> &availableSerialPorts, const std::string &sysfsRoot = "/sys");
+
+/*!
+ * \brief Identify the adapter behind a serial port.
+ * \param devicePath: The serial port node, or a symlink to it (ex: /dev/serial/by-id/...).
+ * \param sysfsRoot: Root of the sysfs filesystem (default is "/sys").
+ * \return The adapter type (using ::SerialDevices_e), or SERIAL_UNKNOWN.
+ */
+int serialPortIdentify(const std::string &devicePath, const std::string &sysfsRoot = "/sys");
+
 /*!
  * \brief The SerialPortLinux class.
  */
@@ -49,12 +69,17 @@ class SerialPortLinux: public SerialPort
     int ttyDeviceBaudRateFlag;     //!< Speed of the serial device, from a <termios.h> enum.
     bool ttyCustomSpeed;           //!< Try to set custom speed on the serial port.
     bool ttyLowLatency;            //!< Try to set low latency flag on the serial port (works only on FTDI based adapters).
+    std::string ttySysfsRoot;      //!< Root of the sysfs filesystem, used to find the latency_timer attribute of the device (default is "/sys").
 
     /*!
-     * \brief Get current time since the Epoch.
-     * \return Current time since the Epoch in milliseconds.
+     * \brief Find the latency_timer sysfs attribute of the current device.
+     * \return The path to the latency_timer attribute, or an empty string if the device doesn't have one.
+     *
+     * Only FTDI based adapters expose a latency_timer. It can be found either
+     * through "<sysfs>/bus/usb-serial/devices/<tty>/latency_timer" or
+     * "<sysfs>/class/tty/<tty>/device/latency_timer".
      */
-    double getTime();
+    std::string getLatencyTimerPath();
 
     /*!
      * \brief Set baudrate for this interface.
@@ -123,17 +148,40 @@ public:
     void flush();
 
     /*!
-     * \brief switchHighSpeed() should enable ASYNC_LOW_LATENCY flag and reduce latency_timer per tty device (need root credential)
-     * \return True in case of success.
-     * \todo This function is not implemented yet.
-     * \todo latency_timer value auto-detection doesn't produce intended result yet.
+     * \brief Setup the serial device for low latency communication.
+     * \return True if both the 1 ms latency_timer and the ASYNC_LOW_LATENCY flag are effective.
+     *         False if any of them could not be applied or verified, including when
+     *         the adapter has no latency_timer (not FTDI based) or the link is not open yet.
+     *
+     * - Write 1 ms into the device latency_timer sysfs attribute (FTDI based
+     *   adapters only, usually need root credentials).
+     * - Set the ASYNC_LOW_LATENCY flag (now if the link is open, otherwise on
+     *   the next openLink()). Failing to set it never prevents opening the link.
+     *
+     * The effective values are read back, reported, and the effective latency_timer
+     * is used as the new latency time of this serial port.
      */
     bool switchHighSpeed();
 
+    /*!
+     * \brief Set the root of the sysfs filesystem.
+     * \param root: Path to the sysfs root (default is "/sys").
+     *
+     * Can be used to point the latency_timer discovery to a fake directory tree.
+     */
+    void setSysfsRoot(const std::string &root);
+
+    /*!
+     * \brief Set the serial port latency value, used to compute timeout duration for packet reception.
+     * \param latency: The latency value in millisecond. Use '0' to read it from the device latency_timer, if available.
+     */
     void setLatency(int latency);
-    void setTimeOut(int packetLength);
-    void setTimeOut(double msec);
-    int checkTimeOut();
+
+    /*!
+     * \brief Sleep (using ppoll()) until some data are available on the serial device or the timeout is reached.
+     * \return 1 if data are available, 0 if the timeout has been reached, -1 in case of error.
+     */
+    int waitData();
 };
 
 #endif /* __linux__ || __gnu_linux */
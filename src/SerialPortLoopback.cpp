@@ -0,0 +1,226 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortLoopback.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#include "SerialPortLoopback.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <cstring>
+#include <map>
+#include <mutex>
+
+/*!
+ * \brief Devices attached to the loopback buses, indexed by bus name.
+ */
+static std::map <std::string, LoopbackDevice *> loopbackDevices;
+static std::mutex loopbackDevicesLock;
+
+SerialPortLoopback::SerialPortLoopback(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices):
+    SerialPort(serialDevice, servoDevices),
+    busOpen(false),
+    loopbackReadIndex(0)
+{
+    ttyDevicePath = devicePath;
+
+    size_t found = ttyDevicePath.find("://");
+    busName = (found != std::string::npos) ? ttyDevicePath.substr(found + 3) : ttyDevicePath;
+    ttyDeviceName = "loop-" + busName;
+
+    // Only a few bytes are in flight at any time
+    loopbackData.reserve(RX_BUFFER_SIZE);
+
+    setBaudRate(baud);
+
+    TRACE_INFO(SERIAL, "- Device name has been set to: '%s'\n", ttyDeviceName.c_str());
+    TRACE_INFO(SERIAL, "- Device node has been set to: '%s'\n", ttyDevicePath.c_str());
+    TRACE_INFO(SERIAL, "- Device baud rate has been set to: '%i'\n", ttyDeviceBaudRate);
+}
+
+SerialPortLoopback::~SerialPortLoopback()
+{
+    closeLink();
+}
+
+bool SerialPortLoopback::attachDevice(const std::string &bus, LoopbackDevice *device)
+{
+    std::lock_guard <std::mutex> lock(loopbackDevicesLock);
+
+    if (device != NULL)
+    {
+        if (loopbackDevices.count(bus) > 0 && loopbackDevices[bus] != device)
+        {
+            TRACE_ERROR(SERIAL, "Cannot attach device to loopback bus '%s': a device is already attached!\n", bus.c_str());
+            return false;
+        }
+
+        loopbackDevices[bus] = device;
+    }
+    else
+    {
+        loopbackDevices.erase(bus);
+    }
+
+    return true;
+}
+
+void SerialPortLoopback::setBaudRate(const int baud)
+{
+    // Get valid baud rate
+    ttyDeviceBaudRate = checkBaudRate(baud);
+
+    // Compute the time needed to transfert one byte through the serial interface
+    byteTransfertTime = 10000000000LL / static_cast<int64_t>(ttyDeviceBaudRate);
+
+    // The response latencies learned at the previous speed don't apply anymore
+    resetLatencyStats();
+}
+
+int SerialPortLoopback::openLink()
+{
+    busOpen = true;
+    flush();
+
+    TRACE_INFO(SERIAL, "Loopback bus '%s' opened\n", busName.c_str());
+
+    return 1;
+}
+
+bool SerialPortLoopback::isOpen()
+{
+    return busOpen;
+}
+
+void SerialPortLoopback::closeLink()
+{
+    if (busOpen == true)
+    {
+        flush();
+        busOpen = false;
+    }
+}
+
+int SerialPortLoopback::tx(unsigned char *packet, int packetLength)
+{
+    int writeStatus = -1;
+
+    if (isOpen() == true)
+    {
+        if (packet != NULL && packetLength > 0)
+        {
+            // Compact already consumed data before appending new data
+            if (loopbackReadIndex >= loopbackData.size())
+            {
+                loopbackData.clear();
+                loopbackReadIndex = 0;
+            }
+
+            LoopbackDevice *device = NULL;
+            {
+                std::lock_guard <std::mutex> lock(loopbackDevicesLock);
+                std::map <std::string, LoopbackDevice *>::iterator it = loopbackDevices.find(busName);
+                if (it != loopbackDevices.end())
+                {
+                    device = it->second;
+                }
+            }
+
+            if (device != NULL)
+            {
+                device->receive(packet, packetLength, loopbackData);
+            }
+            else
+            {
+                loopbackData.insert(loopbackData.end(), packet, packet + packetLength);
+            }
+
+            writeStatus = packetLength;
+            capture(CAPTURE_TX, packet, writeStatus);
+        }
+        else
+        {
+            TRACE_ERROR(SERIAL, "Cannot write to loopback bus '%s': invalid packet buffer or size!\n", busName.c_str());
+        }
+    }
+    else
+    {
+        TRACE_ERROR(SERIAL, "Cannot write to loopback bus '%s': bus is closed!\n", busName.c_str());
+    }
+
+    return writeStatus;
+}
+
+int SerialPortLoopback::rx(unsigned char *packet, int packetLength)
+{
+    int readStatus = -1;
+
+    if (isOpen() == true)
+    {
+        if (packet != NULL && packetLength > 0)
+        {
+            size_t available = loopbackData.size() - loopbackReadIndex;
+            size_t count = (static_cast<size_t>(packetLength) < available) ? static_cast<size_t>(packetLength) : available;
+
+            if (count > 0)
+            {
+                memcpy(packet, &loopbackData[loopbackReadIndex], count);
+                loopbackReadIndex += count;
+            }
+
+            readStatus = static_cast<int>(count);
+            capture(CAPTURE_RX, packet, readStatus);
+        }
+        else
+        {
+            TRACE_ERROR(SERIAL, "Cannot read from loopback bus '%s': invalid packet buffer or size!\n", busName.c_str());
+        }
+    }
+    else
+    {
+        TRACE_ERROR(SERIAL, "Cannot read from loopback bus '%s': bus is closed!\n", busName.c_str());
+    }
+
+    return readStatus;
+}
+
+void SerialPortLoopback::flush()
+{
+    loopbackData.clear();
+    loopbackReadIndex = 0;
+    rxBufferClear();
+}
+
+int SerialPortLoopback::waitData()
+{
+    // Answers are produced synchronously by tx(), nothing else will ever arrive
+    return (loopbackReadIndex < loopbackData.size()) ? 1 : 0;
+}
+
+int SerialPortLoopback::checkTimeOut()
+{
+    // No data left to read means no answer is coming: timeout right away
+    if (loopbackReadIndex >= loopbackData.size())
+    {
+        return 1;
+    }
+
+    return SerialPort::checkTimeOut();
+}
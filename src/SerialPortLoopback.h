@@ -0,0 +1,112 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortLoopback.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#ifndef SERIALPORT_LOOPBACK_H
+#define SERIALPORT_LOOPBACK_H
+
+#include "SerialPort.h"
+
+// C++ standard libraries
+#include <string>
+#include <vector>
+
+/*!
+ * \brief The LoopbackDevice interface, used to simulate the devices behind a SerialPortLoopback.
+ *
+ * A LoopbackDevice is attached to a named loopback bus. It receives every byte
+ * written on that bus, and can immediately queue the bytes to send back (usually
+ * status packets). Data is given as a raw byte stream: a single call can contain
+ * several instruction packets (TX batching), and implementations should not
+ * assume packets are never split.
+ */
+class LoopbackDevice
+{
+public:
+    virtual ~LoopbackDevice() {}
+
+    /*!
+     * \brief Process data written on the loopback bus.
+     * \param[in] data: Bytes written by the host.
+     * \param length: Number of byte(s) written by the host.
+     * \param[out] answer: Bytes to send back to the host, to append to.
+     */
+    virtual void receive(const unsigned char *data, const int length, std::vector <unsigned char> &answer) = 0;
+};
+
+/*!
+ * \brief The SerialPortLoopback class, an in-process serial port backend.
+ *
+ * Used with "loop://<bus>" device paths (ex: "loop://bus0"). Nothing leaves the
+ * process: packets written to the port are handed to the LoopbackDevice attached
+ * to the bus (if any), and its answer is made available to rx() right away. If
+ * no device is attached, written bytes are echoed back.
+ *
+ * Since answers are produced synchronously, a transaction never waits: a missing
+ * answer times out as soon as the receive buffer is empty. This makes it possible
+ * to run (and benchmark) the full protocol and controller stack in memory,
+ * without serial adapters or tty overhead.
+ *
+ * Bus devices must be attached before use, and stay valid until detached.
+ */
+class SerialPortLoopback: public SerialPort
+{
+    std::string busName;           //!< Name of the loopback bus, computed from ttyDevicePath.
+    bool busOpen;                  //!< Loopback link state.
+    std::vector <unsigned char> loopbackData; //!< Bytes waiting to be read by rx().
+    size_t loopbackReadIndex;      //!< Position of the next byte to read in loopbackData.
+
+    /*!
+     * \brief Set baudrate for this interface.
+     * \param baud: Can be a 'baudrate' (in bps) or a Dynamixel / HerkuleX 'baudnum'.
+     *
+     * The baudrate is only used to compute timeouts, nothing is slowed down.
+     */
+    void setBaudRate(const int baud);
+
+public:
+    SerialPortLoopback(std::string &devicePath, const int baud, const int serialDevice = SERIAL_UNKNOWN, const int servoDevices = SERVO_UNKNOWN);
+    ~SerialPortLoopback();
+
+    /*!
+     * \brief Attach a simulated device to a loopback bus.
+     * \param bus: Name of the loopback bus (ex: "bus0" for "loop://bus0").
+     * \param device: The device to attach, or NULL to detach the current one.
+     * \return True if the device has been attached.
+     *
+     * Only one LoopbackDevice can be attached to a bus, but it can simulate any
+     * number of servos. The device is not owned by the bus.
+     */
+    static bool attachDevice(const std::string &bus, LoopbackDevice *device);
+
+    int openLink();
+    bool isOpen();
+    void closeLink();
+
+    int tx(unsigned char *packet, int packetLength);
+    int rx(unsigned char *packet, int packetLength);
+    void flush();
+
+    int waitData();
+    int checkTimeOut();
+};
+
+#endif /* SERIALPORT_LOOPBACK_H */
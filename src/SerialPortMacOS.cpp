@@ -246,7 +246,10 @@ void SerialPortMacOS::setBaudRate(const int baud)
 
     // Compute the time needed to transfert one byte through the serial interface
     // (1000 / baudrate(= bit per msec)) * 10(= start bit + 8 data bit + stop bit)
-    byteTransfertTime = (1000.0 / static_cast<double>(ttyDeviceBaudRate)) * 10.0;
+    byteTransfertTime = 10000000000LL / static_cast<int64_t>(ttyDeviceBaudRate);
+
+    // The response latencies learned at the previous speed don't apply anymore
+    resetLatencyStats();
 }
 
 static int rate_to_constant(int baudrate)
@@ -626,6 +629,7 @@ int SerialPortMacOS::tx(unsigned char *packet, int packetLength)
         if (packet != NULL && packetLength > 0)
         {
             writeStatus = write(ttyDeviceFileDescriptor, packet, packetLength);
+            capture(CAPTURE_TX, packet, writeStatus);
 
             if (writeStatus < 0)
             {
@@ -653,8 +657,8 @@ int SerialPortMacOS::rx(unsigned char *packet, int packetLength)
     {
         if (packet != NULL && packetLength > 0)
         {
-            memset(packet, 0, packetLength);
             readStatus = read(ttyDeviceFileDescriptor, packet, packetLength);
+            capture(CAPTURE_RX, packet, readStatus);
 
             if (readStatus < 0)
             {
@@ -692,43 +696,8 @@ void SerialPortMacOS::flush()
 
         tcflush(ttyDeviceFileDescriptor, TCIFLUSH);
     }
-}
-
-double SerialPortMacOS::getTime()
-{
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-
-    return (static_cast<double>(tv.tv_sec) * 1000.0 + static_cast<double>(tv.tv_usec) / 1000.0);
-}
-
-void SerialPortMacOS::setTimeOut(int packetLength)
-{
-    packetStartTime = getTime();
-    packetWaitTime  = (byteTransfertTime * static_cast<double>(packetLength) + 2.0 * static_cast<double>(ttyDeviceLatencyTime));
-}
-
-void SerialPortMacOS::setTimeOut(double msec)
-{
-    packetStartTime = getTime();
-    packetWaitTime  = msec;
-}
-
-int SerialPortMacOS::checkTimeOut()
-{
-    int status = 0;
-    double time_elapsed = getTime() - packetStartTime;
-
-    if (time_elapsed > packetWaitTime)
-    {
-        status = 1;
-    }
-    else if (time_elapsed < 0)
-    {
-        packetStartTime = getTime();
-    }
 
-    return status;
+    rxBufferClear();
 }
 
 #endif /* defined(__APPLE__) || defined(__MACH__) */
@@ -47,12 +47,6 @@ class SerialPortMacOS: public SerialPort
     int ttyDeviceBaudRateFlag;     //!< Speed of the serial device, from a <termios.h> enum.
     bool ttyCustomSpeed;           //!< Try to set custom speed on the serial port.
 
-    /*!
-     * \brief Get current time since the Epoch.
-     * \return Current time since the Epoch in milliseconds.
-     */
-    double getTime();
-
     /*!
      * \brief Set baudrate for this interface.
      * \param baud: Can be a 'baudrate' (in bps) or a Dynamixel / HerkuleX 'baudnum'.
@@ -107,9 +101,6 @@ public:
     int rx(unsigned char *packet, int packetLength);
     void flush();
 
-    void setTimeOut(int packetLength);
-    void setTimeOut(double msec);
-    int checkTimeOut();
 };
 
 #endif /* defined(__APPLE__) || defined(__MACH__) */
@@ -0,0 +1,289 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortReplay.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#include "SerialPortReplay.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+SerialPortReplay::SerialPortReplay(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices):
+    SerialPort(serialDevice, servoDevices),
+    replayPort(0),
+    replayFast(false),
+    replayOpen(false),
+    recordIndex(0),
+    mismatchCount(0),
+    pendingIndex(0),
+    pendingOffset(0),
+    pendingEnd(0)
+{
+    ttyDevicePath = devicePath;
+
+    // Parse "replay://<file>[#port][?fast]"
+    size_t found = devicePath.find("://");
+    replayFile = (found != std::string::npos) ? devicePath.substr(found + 3) : devicePath;
+
+    found = replayFile.rfind("?fast");
+    if (found != std::string::npos && found == replayFile.size() - 5)
+    {
+        replayFast = true;
+        replayFile.erase(found);
+    }
+
+    found = replayFile.rfind('#');
+    if (found != std::string::npos)
+    {
+        replayPort = std::atoi(replayFile.c_str() + found + 1);
+        replayFile.erase(found);
+    }
+
+    found = replayFile.rfind('/');
+    ttyDeviceName = "replay-" + ((found != std::string::npos) ? replayFile.substr(found + 1) : replayFile);
+
+    setBaudRate(baud);
+
+    TRACE_INFO(SERIAL, "- Device name has been set to: '%s'\n", ttyDeviceName.c_str());
+    TRACE_INFO(SERIAL, "- Device node has been set to: '%s'\n", ttyDevicePath.c_str());
+    TRACE_INFO(SERIAL, "- Device baud rate has been set to: '%i'\n", ttyDeviceBaudRate);
+}
+
+SerialPortReplay::~SerialPortReplay()
+{
+    closeLink();
+}
+
+void SerialPortReplay::setBaudRate(const int baud)
+{
+    // Get valid baud rate
+    ttyDeviceBaudRate = checkBaudRate(baud);
+
+    // Compute the time needed to transfert one byte through the serial interface
+    byteTransfertTime = 10000000000LL / static_cast<int64_t>(ttyDeviceBaudRate);
+
+    // The response latencies learned at the previous speed don't apply anymore
+    resetLatencyStats();
+}
+
+int SerialPortReplay::openLink()
+{
+    std::vector <SerialCaptureRecord> all;
+    std::vector <std::string> ports;
+
+    if (serialCaptureLoad(replayFile, all, ports) < 0)
+    {
+        return -1;
+    }
+
+    if (replayPort < 0 || replayPort >= static_cast<int>(ports.size()))
+    {
+        TRACE_ERROR(SERIAL, "Capture file '%s' has no port #%i\n", replayFile.c_str(), replayPort);
+        return -1;
+    }
+
+    records.clear();
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        if (all[i].port == replayPort)
+        {
+            records.push_back(all[i]);
+        }
+    }
+
+    recordIndex = 0;
+    mismatchCount = 0;
+    flush();
+    replayOpen = true;
+
+    TRACE_INFO(SERIAL, "Replaying %u record(s) from '%s' (port '%s', %s timing)\n",
+               static_cast<unsigned>(records.size()), replayFile.c_str(),
+               ports[replayPort].c_str(), replayFast ? "no" : "original");
+
+    return 1;
+}
+
+bool SerialPortReplay::isOpen()
+{
+    return replayOpen;
+}
+
+void SerialPortReplay::closeLink()
+{
+    if (replayOpen == true)
+    {
+        if (mismatchCount > 0)
+        {
+            TRACE_WARNING(SERIAL, "%i packet(s) sent did not match the capture '%s'\n", mismatchCount, replayFile.c_str());
+        }
+
+        flush();
+        records.clear();
+        replayOpen = false;
+    }
+}
+
+int SerialPortReplay::tx(unsigned char *packet, int packetLength)
+{
+    if (isOpen() == false || packet == NULL || packetLength <= 0)
+    {
+        TRACE_ERROR(SERIAL, "Cannot write to replay port '%s'!\n", ttyDevicePath.c_str());
+        return -1;
+    }
+
+    // Answers to the previous packet that were not read are lost
+    pendingTimes.clear();
+    pendingRecords.clear();
+    pendingIndex = 0;
+    pendingOffset = 0;
+
+    // Find the next TX record
+    while (recordIndex < records.size() && records[recordIndex].type != CAPTURE_TX)
+    {
+        recordIndex++;
+    }
+
+    if (recordIndex >= records.size())
+    {
+        TRACE_WARNING(SERIAL, "End of capture reached on replay port '%s'\n", ttyDevicePath.c_str());
+        return packetLength;
+    }
+
+    const SerialCaptureRecord &txRecord = records[recordIndex++];
+
+    if (txRecord.data.size() != static_cast<size_t>(packetLength) ||
+        memcmp(txRecord.data.data(), packet, packetLength) != 0)
+    {
+        mismatchCount++;
+        TRACE_1(SERIAL, "Packet sent does not match the capture (record #%u)\n", static_cast<unsigned>(recordIndex - 1));
+    }
+
+    // Schedule the answers, with their original delay
+    int64_t now = getTimeNs();
+    while (recordIndex < records.size() && records[recordIndex].type == CAPTURE_RX)
+    {
+        int64_t delay = replayFast ? 0 : (records[recordIndex].timestamp - txRecord.timestamp);
+        pendingTimes.push_back(now + delay);
+        pendingRecords.push_back(&records[recordIndex]);
+        recordIndex++;
+    }
+
+    // No more answer after the next packet
+    pendingEnd = now;
+    if (replayFast == false && recordIndex < records.size())
+    {
+        pendingEnd += records[recordIndex].timestamp - txRecord.timestamp;
+    }
+
+    return packetLength;
+}
+
+int SerialPortReplay::rx(unsigned char *packet, int packetLength)
+{
+    if (isOpen() == false || packet == NULL || packetLength <= 0)
+    {
+        TRACE_ERROR(SERIAL, "Cannot read from replay port '%s'!\n", ttyDevicePath.c_str());
+        return -1;
+    }
+
+    int readStatus = 0;
+    int64_t now = replayFast ? 0 : getTimeNs();
+
+    while (readStatus < packetLength && pendingIndex < pendingRecords.size() &&
+           (replayFast || pendingTimes[pendingIndex] <= now))
+    {
+        const std::vector <unsigned char> &data = pendingRecords[pendingIndex]->data;
+        size_t count = std::min(data.size() - pendingOffset, static_cast<size_t>(packetLength - readStatus));
+
+        memcpy(packet + readStatus, data.data() + pendingOffset, count);
+        readStatus += static_cast<int>(count);
+        pendingOffset += count;
+
+        if (pendingOffset >= data.size())
+        {
+            pendingIndex++;
+            pendingOffset = 0;
+        }
+    }
+
+    return readStatus;
+}
+
+void SerialPortReplay::flush()
+{
+    pendingTimes.clear();
+    pendingRecords.clear();
+    pendingIndex = 0;
+    pendingOffset = 0;
+    rxBufferClear();
+}
+
+int SerialPortReplay::waitData()
+{
+    int64_t deadline = getTimeNs() + packetDeadline.remaining();
+
+    if (pendingIndex < pendingRecords.size())
+    {
+        if (replayFast == false && pendingTimes[pendingIndex] > deadline)
+        {
+            // The answer comes too late
+            std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - getTimeNs()));
+            return 0;
+        }
+
+        int64_t wait = pendingTimes[pendingIndex] - getTimeNs();
+        if (replayFast == false && wait > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+
+        return 1;
+    }
+
+    // Nothing else to come, wait as long as the original timeout
+    int64_t wait = std::min(deadline, pendingEnd) - getTimeNs();
+    if (wait > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    }
+
+    return 0;
+}
+
+int SerialPortReplay::checkTimeOut()
+{
+    // No more answer to come
+    if (pendingIndex >= pendingRecords.size() && (replayFast == true || getTimeNs() >= pendingEnd))
+    {
+        return 1;
+    }
+
+    return SerialPort::checkTimeOut();
+}
+
+int SerialPortReplay::getMismatchCount() const
+{
+    return mismatchCount;
+}
@@ -0,0 +1,100 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortReplay.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#ifndef SERIALPORT_REPLAY_H
+#define SERIALPORT_REPLAY_H
+
+#include "SerialPort.h"
+#include "SerialCapture.h"
+
+// C++ standard libraries
+#include <string>
+#include <vector>
+
+/*!
+ * \brief The SerialPortReplay class, a serial port backend replaying a capture file.
+ *
+ * Used with "replay://<capture file>[#port][?fast]" device paths (ex:
+ * "replay:///tmp/robot.cap#1?fast"). The capture is made with serialCaptureStart().
+ * If it contains several ports, '#port' selects the port index to replay (0 by default).
+ *
+ * Each packet sent with tx() consumes the next TX record of the capture. The RX
+ * records following it (up to the next TX record) are then made available to
+ * rx() with their original delay, relative to the TX record. Missing answers time
+ * out when the next packet was sent in the capture (or at the regular timeout).
+ * With the '?fast' option, answers are available and missing answers time out
+ * right away.
+ *
+ * Sent packets are compared with the captured ones, mismatches are only counted
+ * and reported.
+ */
+class SerialPortReplay: public SerialPort
+{
+    std::string replayFile;        //!< Path to the capture file.
+    int replayPort;                //!< Index of the captured port to replay.
+    bool replayFast;               //!< Replay as fast as possible, instead of using the original timing.
+    bool replayOpen;               //!< Replay link state.
+
+    std::vector <SerialCaptureRecord> records; //!< TX and RX records of the replayed port.
+    size_t recordIndex;            //!< Index of the next record to replay.
+    int mismatchCount;             //!< Number of sent packets not matching the captured ones.
+
+    std::vector <int64_t> pendingTimes; //!< Time (in nanosecond) when each pending RX record becomes available.
+    std::vector <SerialCaptureRecord *> pendingRecords; //!< RX records scheduled by the last tx().
+    size_t pendingIndex;           //!< Index of the next pending RX record.
+    size_t pendingOffset;          //!< Number of byte(s) already read from the next pending RX record.
+    int64_t pendingEnd;            //!< Time (in nanosecond) when the next packet was sent in the capture, so when no more answer is expected.
+
+    /*!
+     * \brief Set baudrate for this interface.
+     * \param baud: Can be a 'baudrate' (in bps) or a Dynamixel / HerkuleX 'baudnum'.
+     *
+     * The baudrate is only used to compute timeouts.
+     */
+    void setBaudRate(const int baud);
+
+public:
+    SerialPortReplay(std::string &devicePath, const int baud, const int serialDevice = SERIAL_UNKNOWN, const int servoDevices = SERVO_UNKNOWN);
+    ~SerialPortReplay();
+
+    /*!
+     * \brief Load the capture file.
+     * \return 1 if success, -1 otherwise.
+     */
+    int openLink();
+    bool isOpen();
+    void closeLink();
+
+    int tx(unsigned char *packet, int packetLength);
+    int rx(unsigned char *packet, int packetLength);
+    void flush();
+
+    int waitData();
+    int checkTimeOut();
+
+    /*!
+     * \brief Get the number of sent packets that did not match the captured ones.
+     */
+    int getMismatchCount() const;
+};
+
+#endif /* SERIALPORT_REPLAY_H */
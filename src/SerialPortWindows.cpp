@@ -122,7 +122,10 @@ void SerialPortWindows::setBaudRate(const int baud)
 
     // Compute the time needed to transfert one byte through the serial interface
     // (1000 / baudrate(= bit per msec)) * 10(= start bit + 8 data bit + stop bit)
-    byteTransfertTime = (1000.0 / static_cast<double>(ttyDeviceBaudRate)) * 10.0;
+    byteTransfertTime = 10000000000LL / static_cast<int64_t>(ttyDeviceBaudRate);
+
+    // The response latencies learned at the previous speed don't apply anymore
+    resetLatencyStats();
 }
 
 int SerialPortWindows::openLink()
@@ -295,6 +298,7 @@ int SerialPortWindows::tx(unsigned char *packet, int packetLength)
             if (WriteFile(ttyDeviceFileDescriptor, packet, dwToWrite, &dwWritten, NULL) == TRUE)
             {
                 status = static_cast<int>(dwWritten);
+                capture(CAPTURE_TX, packet, status);
             }
             else
             {
@@ -340,6 +344,7 @@ int SerialPortWindows::rx(unsigned char *packet, int packetLength)
             if (ReadFile(ttyDeviceFileDescriptor, packet, dwToRead, &dwRead, NULL) == TRUE)
             {
                 readStatus = static_cast<int>(dwRead);
+                capture(CAPTURE_RX, packet, readStatus);
             }
             else
             {
@@ -370,50 +375,8 @@ void SerialPortWindows::flush()
 
         PurgeComm(ttyDeviceFileDescriptor, PURGE_RXABORT | PURGE_RXCLEAR);
     }
-}
-
-double SerialPortWindows::getTime()
-{
-    LARGE_INTEGER time;
-    QueryPerformanceCounter(&time);
-
-    return static_cast<double>(time.QuadPart);
-}
-
-void SerialPortWindows::setTimeOut(int packetLength)
-{
-    packetStartTime = getTime();
-    packetWaitTime  = (byteTransfertTime * static_cast<double>(packetLength) + 2.0 * static_cast<double>(ttyDeviceLatencyTime));
-}
-
-void SerialPortWindows::setTimeOut(double msec)
-{
-    packetStartTime = getTime();
-    packetWaitTime  = msec;
-}
-
-int SerialPortWindows::checkTimeOut()
-{
-    LARGE_INTEGER end, freq;
-    int status = 0;
-    double time_elapsed = 0.0;
-
-    QueryPerformanceCounter(&end);
-    QueryPerformanceFrequency(&freq);
-
-    time_elapsed = static_cast<double>(end.QuadPart - packetStartTime) / static_cast<double>(freq.QuadPart);
-    time_elapsed *= 1000.0;
-
-    if (time_elapsed > packetWaitTime)
-    {
-        status = 1;
-    }
-    else if (time_elapsed < 0)
-    {
-        packetStartTime = getTime();
-    }
 
-    return status;
+    rxBufferClear();
 }
 
 #endif /* _WIN32 || _WIN64 */
@@ -55,12 +55,6 @@ class SerialPortWindows: public SerialPort
 {
     HANDLE ttyDeviceFileDescriptor; //!< The file descriptor that will be used to write to the serial device.
 
-    /*!
-     * \brief Retrieves the current value of the performance counter, which is a high resolution (<1us) time stamp that can be used for time-interval measurements.
-     * \return A high resolution time stamp (unit?).
-     */
-    double getTime();
-
     /*!
      * \brief Set baudrate for this interface.
      * \param baud: Can be a 'baudrate' (in bps) or a Dynamixel / HerkuleX 'baudnum'.
@@ -92,9 +86,6 @@ public:
     int rx(unsigned char *packet, int packetLength);
     void flush();
 
-    void setTimeOut(int packetLength);
-    void setTimeOut(double msec);
-    int checkTimeOut();
 };
 
 #endif /* defined(_WIN32) || defined(_WIN64) */
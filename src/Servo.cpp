@@ -36,6 +36,7 @@ Servo::Servo()
     registerTableSize = 0;
     registerTableValues = NULL;
     registerTableCommits = NULL;
+    registerTableDirty = 0;
 
     servoId = 0;
     servoModel = 0;
@@ -370,6 +371,7 @@ void Servo::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        markDirty(gid(REG_ID));
     }
 }
 
@@ -383,6 +385,7 @@ void Servo::setCWLimit(int limit)
 
         registerTableValues[gid(REG_MIN_POSITION)] = limit;
         registerTableCommits[gid(REG_MIN_POSITION)] = 1;
+        markDirty(gid(REG_MIN_POSITION));
     }
 }
 
@@ -396,6 +399,7 @@ void Servo::setCCWLimit(int limit)
 
         registerTableValues[gid(REG_MAX_POSITION)] = limit;
         registerTableCommits[gid(REG_MAX_POSITION)] = 1;
+        markDirty(gid(REG_MAX_POSITION));
     }
 }
 
@@ -478,6 +482,7 @@ void Servo::setValue(int reg_name, int reg_value, int reg_type)
                     // Set value
                     registerTableValues[infos.reg_index] = reg_value;
                     registerTableCommits[infos.reg_index] = 1;
+                    markDirty(infos.reg_index);
                 }
                 else
                 {
@@ -561,6 +566,14 @@ void Servo::commitValue(int reg_name, int commit, int reg_type)
 
                 // Set value
                 registerTableCommits[infos.reg_index] = commit;
+                if (commit == 1)
+                {
+                    markDirty(infos.reg_index);
+                }
+                else
+                {
+                    clearDirty(infos.reg_index);
+                }
             }
             else
             {
@@ -579,3 +592,36 @@ void Servo::commitValue(int reg_name, int commit, int reg_type)
 }
 
 /* ************************************************************************** */
+
+void Servo::markDirty(const int reg_index)
+{
+    if (reg_index >= 0 && reg_index < 64)
+    {
+        registerTableDirty.fetch_or(1ULL << reg_index);
+    }
+}
+
+void Servo::clearDirty(const int reg_index)
+{
+    if (reg_index >= 0 && reg_index < 64)
+    {
+        registerTableDirty.fetch_and(~(1ULL << reg_index));
+    }
+}
+
+int Servo::getNextDirtyRegister(const int from)
+{
+    if (from < 0 || from >= 64)
+    {
+        return -1;
+    }
+
+    uint64_t dirty = registerTableDirty.load() & (~0ULL << from);
+
+    if (dirty == 0)
+    {
+        return -1;
+    }
+
+    return count_trailing_zeros(dirty);
+}
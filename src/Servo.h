@@ -28,6 +28,8 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
 
 /** \addtogroup ManagedAPIs
  *  @{
@@ -58,6 +60,18 @@ protected:
     int *registerTableValues;
     int *registerTableCommits;
 
+    /*!
+     * Bitmap of the registers with a pending commit, indexed like registerTableCommits.
+     * Control tables never have more than 64 registers (see getRegisterCount()).
+     * Must be kept in sync with registerTableCommits, using markDirty() and clearDirty().
+     */
+    std::atomic <uint64_t> registerTableDirty;
+
+    //! Flag a register (by control table index) as having a pending commit.
+    void markDirty(const int reg_index);
+    //! Remove the pending commit flag of a register (by control table index).
+    void clearDirty(const int reg_index);
+
     int servoId;
     int servoModel;
     int servoSerie;
@@ -162,6 +176,16 @@ public:
     virtual void setValue(const int reg_reg, int reg_value, int reg_type = REGISTER_AUTO);
     virtual void updateValue(const int reg_reg, int reg_value, int reg_type = REGISTER_AUTO);
     virtual void commitValue(const int reg_reg, int commit, int reg_type = REGISTER_AUTO);
+
+    /*!
+     * \brief Find the next register with a pending commit.
+     * \param from: Control table index to start from.
+     * \return The control table index of the next register with a pending commit (at or after 'from'), or -1 if there is none.
+     *
+     * Only reads the bitmap of pending commits, so the controllers can skip
+     * the registers left untouched without taking the servo lock.
+     */
+    int getNextDirtyRegister(const int from = 0);
 };
 
 /** @}*/
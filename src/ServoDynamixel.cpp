@@ -56,6 +56,12 @@ ServoDynamixel::ServoDynamixel(const int control_table[][8], int dynamixel_id, i
         }
     }
 
+    // The dirty register mask only has room for 64 registers
+    if (ct[registerTableSize][0] != 999)
+    {
+        TRACE_ERROR(DXL, "Control table has more than 64 registers, only the first 64 will be used!\n");
+    }
+
     // Init register tables (value and commit info) with value-initialization
     registerTableValues = new int [registerTableSize]();
     registerTableCommits = new int [registerTableSize]();
@@ -326,6 +332,7 @@ void ServoDynamixel::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        markDirty(gid(REG_ID));
     }
 }
 
@@ -339,6 +346,7 @@ void ServoDynamixel::setCWLimit(int limit)
 
         registerTableValues[gid(REG_MIN_POSITION)] = limit;
         registerTableCommits[gid(REG_MIN_POSITION)] = 1;
+        markDirty(gid(REG_MIN_POSITION));
     }
 }
 
@@ -352,6 +360,7 @@ void ServoDynamixel::setCCWLimit(int limit)
 
         registerTableValues[gid(REG_MAX_POSITION)] = limit;
         registerTableCommits[gid(REG_MAX_POSITION)] = 1;
+        markDirty(gid(REG_MAX_POSITION));
     }
 }
 
@@ -376,6 +385,7 @@ void ServoDynamixel::setGoalPosition(int pos)
         // Set position
         registerTableValues[gid(REG_GOAL_POSITION)] = pos;
         registerTableCommits[gid(REG_GOAL_POSITION)] = 1;
+        markDirty(gid(REG_GOAL_POSITION));
     }
     else
     {
@@ -419,9 +429,11 @@ void ServoDynamixel::setGoalPosition(int pos, int time_budget_ms)
             // Set position and speed
             registerTableValues[gid(REG_GOAL_POSITION)] = pos;
             registerTableCommits[gid(REG_GOAL_POSITION)] = 1;
+            markDirty(gid(REG_GOAL_POSITION));
 
             registerTableValues[gid(REG_GOAL_SPEED)] = speed;
             registerTableCommits[gid(REG_GOAL_SPEED)] = 1;
+            markDirty(gid(REG_GOAL_SPEED));
         }
         else
         {
@@ -468,6 +480,7 @@ void ServoDynamixel::setMovingSpeed(int speed)
         {
             registerTableValues[gid(REG_GOAL_SPEED)] = speed;
             registerTableCommits[gid(REG_GOAL_SPEED)] = 1;
+            markDirty(gid(REG_GOAL_SPEED));
         }
     }
     else
@@ -476,6 +489,7 @@ void ServoDynamixel::setMovingSpeed(int speed)
         {
             registerTableValues[gid(REG_GOAL_SPEED)] = speed;
             registerTableCommits[gid(REG_GOAL_SPEED)] = 1;
+            markDirty(gid(REG_GOAL_SPEED));
         }
     }
 }
@@ -490,6 +504,7 @@ void ServoDynamixel::setMaxTorque(int torque)
 
         registerTableValues[gid(REG_MAX_TORQUE)] = torque;
         registerTableCommits[gid(REG_MAX_TORQUE)] = 1;
+        markDirty(gid(REG_MAX_TORQUE));
     }
 }
 
@@ -511,6 +526,7 @@ void ServoDynamixel::setLed(int led)
 
     registerTableValues[gid(REG_LED)] = led;
     registerTableCommits[gid(REG_LED)] = 1;
+    markDirty(gid(REG_LED));
 }
 
 void ServoDynamixel::setTorqueEnabled(int torque)
@@ -524,4 +540,5 @@ void ServoDynamixel::setTorqueEnabled(int torque)
 
     registerTableValues[gid(REG_TORQUE_ENABLE)] = torque;
     registerTableCommits[gid(REG_TORQUE_ENABLE)] = 1;
+    markDirty(gid(REG_TORQUE_ENABLE));
 }
@@ -55,6 +55,12 @@ ServoHerkuleX::ServoHerkuleX(const int control_table[][8], int herkulex_id, int
         }
     }
 
+    // The dirty register mask only has room for 64 registers
+    if (ct[registerTableSize][0] != 999)
+    {
+        TRACE_ERROR(HKX, "Control table has more than 64 registers, only the first 64 will be used!\n");
+    }
+
     // Init register tables (value and commit info) with value-initialization
     registerTableValues = new int [registerTableSize]();
     registerTableCommits = new int [registerTableSize]();
@@ -426,6 +432,7 @@ void ServoHerkuleX::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        markDirty(gid(REG_ID));
     }
 }
 
@@ -439,6 +446,7 @@ void ServoHerkuleX::setCWLimit(int limit, const int reg_type)
 
         registerTableValues[gid(REG_MIN_POSITION)] = limit;
         registerTableCommits[gid(REG_MIN_POSITION)] = 1;
+        markDirty(gid(REG_MIN_POSITION));
     }
 }
 
@@ -452,6 +460,7 @@ void ServoHerkuleX::setCCWLimit(int limit, const int reg_type)
 
         registerTableValues[gid(REG_MAX_POSITION)] = limit;
         registerTableCommits[gid(REG_MAX_POSITION)] = 1;
+        markDirty(gid(REG_MAX_POSITION));
     }
 }
 
@@ -501,6 +510,7 @@ void ServoHerkuleX::setLed(int led)
 
     registerTableValuesRAM[gid(REG_LED)] = color;
     registerTableCommitsRAM[gid(REG_LED)] = 1;
+    markDirty(gid(REG_LED));
 }
 
 void ServoHerkuleX::setTorqueEnabled(int torque)
@@ -520,6 +530,7 @@ void ServoHerkuleX::setTorqueEnabled(int torque)
 
         registerTableValuesRAM[gid(REG_TORQUE_ENABLE)] = torque;
         registerTableCommitsRAM[gid(REG_TORQUE_ENABLE)] = 1;
+        markDirty(gid(REG_TORQUE_ENABLE));
     }
     else
     {
@@ -552,6 +563,7 @@ void ServoHerkuleX::moveGoalPosition(int move)
     {
         registerTableValues[gid(SERVO_GOAL_POSITION)] = registerTableValues[gid(SERVO_CURRENT_POSITION)] + move;
         registerTableCommits[gid(SERVO_GOAL_POSITION)] = 1;
+        markDirty(gid(SERVO_GOAL_POSITION));
     }
     else
     {
@@ -573,6 +585,7 @@ void ServoHerkuleX::setMovingSpeed(int speed)
         {
             registerTableValues[gid(SERVO_GOAL_SPEED)] = speed;
             registerTableCommits[gid(SERVO_GOAL_SPEED)] = 1;
+            markDirty(gid(SERVO_GOAL_SPEED));
         }
     }
     else
@@ -581,6 +594,7 @@ void ServoHerkuleX::setMovingSpeed(int speed)
         {
             registerTableValues[gid(SERVO_GOAL_SPEED)] = speed;
             registerTableCommits[gid(SERVO_GOAL_SPEED)] = 1;
+            markDirty(gid(SERVO_GOAL_SPEED));
         }
     }
 }
@@ -595,6 +609,7 @@ void ServoHerkuleX::setMaxTorque(int torque)
 
         registerTableValues[gid(SERVO_MAX_TORQUE)] = torque;
         registerTableCommits[gid(SERVO_MAX_TORQUE)] = 1;
+        markDirty(gid(SERVO_MAX_TORQUE));
     }
 }
 */
@@ -719,12 +734,14 @@ void ServoHerkuleX::setValue(int reg_name, int reg_value, int reg_type)
                     {
                         registerTableValues[infos.reg_index] = reg_value;
                         registerTableCommits[infos.reg_index] = 1;
+                        markDirty(infos.reg_index);
                     }
 
                     if (reg_type == REGISTER_RAM || reg_type == REGISTER_BOTH)
                     {
                         registerTableValuesRAM[infos.reg_index] = reg_value;
                         registerTableCommitsRAM[infos.reg_index] = 1;
+                        markDirty(infos.reg_index);
                     }
                 }
                 else
@@ -845,6 +862,16 @@ void ServoHerkuleX::commitValue(int reg_name, int commit, int reg_type)
                 {
                     registerTableCommits[infos.reg_index] = commit;
                 }
+
+                // The register stays flagged while its ROM or RAM value still needs a commit
+                if (registerTableCommits[infos.reg_index] == 1 || registerTableCommitsRAM[infos.reg_index] == 1)
+                {
+                    markDirty(infos.reg_index);
+                }
+                else
+                {
+                    clearDirty(infos.reg_index);
+                }
             }
             else
             {
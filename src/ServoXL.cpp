@@ -119,6 +119,7 @@ void ServoXL::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        markDirty(gid(REG_ID));
     }
 }
 
@@ -357,7 +357,9 @@ enum RegisterNames_e
     REG_REMOCON_TX_DATA_0,
     REG_REMOCON_TX_DATA_1,
     REG_IR_DETECT_COMPARE,
-    REG_LIGHT_DETECT_COMPARE
+    REG_LIGHT_DETECT_COMPARE,
+
+    REG_COUNT                   //!< Number of register names (not a register)
 };
 
 /* ************************************************************************** */
@@ -418,6 +420,36 @@ inline unsigned char get_highbyte(const int word)
 
 /* ************************************************************************** */
 
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*!
+ * \brief Count the trailing zero bits of a 64b word.
+ * \param value: The word to look at. Must not be 0.
+ * \return The index of the lowest bit set.
+ */
+inline int count_trailing_zeros(const uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while (((value >> index) & 1) == 0)
+    {
+        index++;
+    }
+    return index;
+#endif
+}
+
+/* ************************************************************************** */
+
 #include <string>
 
 /*!
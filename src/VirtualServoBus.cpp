@@ -0,0 +1,893 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file VirtualServoBus.cpp
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#include "VirtualServoBus.h"
+#include "ControlTables.h"
+#include "DynamixelTools.h"
+#include "HerkuleXTools.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <cstring>
+
+/* ************************************************************************** */
+
+/*!
+ * \brief Instructions understood by the simulated devices.
+ */
+enum {
+    VINST_PING          = 1,
+    VINST_READ          = 2,
+    VINST_WRITE         = 3,
+    VINST_REG_WRITE     = 4,
+    VINST_ACTION        = 5,
+    VINST_FACTORY_RESET = 6,
+    VINST_REBOOT        = 8,
+    VINST_STATUS        = 85,  // 0x55
+    VINST_SYNC_READ     = 130, // 0x82
+    VINST_SYNC_WRITE    = 131, // 0x83
+    VINST_BULK_READ     = 146, // 0x92
+    VINST_BULK_WRITE    = 147, // 0x93
+
+    VCMD_EEP_WRITE      = 1,
+    VCMD_EEP_READ       = 2,
+    VCMD_RAM_WRITE      = 3,
+    VCMD_RAM_READ       = 4,
+    VCMD_I_JOG          = 5,
+    VCMD_S_JOG          = 6,
+    VCMD_STAT           = 7,
+};
+
+/*!
+ * \brief Maximum size of a packet accepted by the simulated devices.
+ */
+#define VIRTUAL_PACKET_MAX (MAX_PACKET_LENGTH_dxlv2)
+
+/*!
+ * \brief Protocol v2 byte stuffing: add a 0xFD after each 0xFF 0xFF 0xFD sequence
+ *        found in the packet, from its instruction field.
+ */
+static void dxl2Stuff(std::vector <unsigned char> &packet, const size_t start)
+{
+    size_t first = start + 9;
+    while (first < packet.size() &&
+           !(packet[first] == 0xFD && packet[first-1] == 0xFF && packet[first-2] == 0xFF))
+    {
+        first++;
+    }
+    if (first >= packet.size())
+    {
+        // Nothing to escape
+        return;
+    }
+
+    std::vector <unsigned char> stuffed(packet.begin(), packet.begin() + start + 7);
+
+    for (size_t i = start + 7; i < packet.size(); i++)
+    {
+        stuffed.push_back(packet[i]);
+
+        if (packet[i] == 0xFD && i >= start + 9 && packet[i-1] == 0xFF && packet[i-2] == 0xFF)
+        {
+            stuffed.push_back(0xFD);
+        }
+    }
+
+    int length = static_cast<int>(stuffed.size() - start) - 7 + 2;
+    stuffed[start + 5] = static_cast<unsigned char>(length & 0xFF);
+    stuffed[start + 6] = static_cast<unsigned char>(length >> 8);
+    packet.swap(stuffed);
+}
+
+/*!
+ * \brief Protocol v2 byte unstuffing: remove the 0xFD added after each 0xFF 0xFF 0xFD
+ *        sequence of a complete packet.
+ * \return The size of the unstuffed packet.
+ */
+static int dxl2Unstuff(unsigned char *packet, const int size)
+{
+    int out = 7;
+
+    for (int in = 7; in < size - 2; in++, out++)
+    {
+        packet[out] = packet[in];
+
+        if (packet[out] == 0xFD && out >= 9 && packet[out-1] == 0xFF && packet[out-2] == 0xFF &&
+            (in + 1) < (size - 2) && packet[in+1] == 0xFD)
+        {
+            in++;
+        }
+    }
+
+    packet[out] = packet[size - 2];
+    packet[out+1] = packet[size - 1];
+    packet[5] = static_cast<unsigned char>((out - 5) & 0xFF);
+    packet[6] = static_cast<unsigned char>((out - 5) >> 8);
+
+    return out + 2;
+}
+
+/* ************************************************************************** */
+
+VirtualServoBus::VirtualServoBus(const int servoSerie, const int protocolVersion):
+    servoSerie(servoSerie),
+    protocolVersion(protocolVersion),
+    packetCount(0),
+    errorCount(0)
+{
+    updateIndex();
+}
+
+VirtualServoBus::~VirtualServoBus()
+{
+    //
+}
+
+int VirtualServoBus::addServo(const int id, const int model_number)
+{
+    if (id < 0 || id >= BROADCAST_ID || servoIndex[id] != -1)
+    {
+        TRACE_ERROR(TOOLS, "Cannot add virtual servo #%i: invalid or already used ID\n", id);
+        return 0;
+    }
+
+    VirtualServo servo;
+    servo.id = id;
+    servo.model_number = model_number;
+
+    if (servoSerie >= SERVO_HERKULEX)
+    {
+        hkx_get_model_infos(model_number, servo.servo_serie, servo.servo_model);
+    }
+    else
+    {
+        dxl_get_model_infos(model_number, servo.servo_serie, servo.servo_model);
+    }
+
+    servo.ct = getRegisterTable(servo.servo_serie, servo.servo_model);
+    if (servo.ct == NULL)
+    {
+        TRACE_ERROR(TOOLS, "Cannot add virtual servo #%i: unknown model number '0x%04X'\n", id, model_number);
+        return 0;
+    }
+
+    initServo(servo);
+    servos.push_back(servo);
+    updateIndex();
+
+    TRACE_INFO(TOOLS, "Virtual servo #%i added (model '0x%04X')\n", id, model_number);
+
+    return 1;
+}
+
+void VirtualServoBus::removeServo(const int id)
+{
+    for (std::vector <VirtualServo>::iterator it = servos.begin(); it != servos.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            servos.erase(it);
+            break;
+        }
+    }
+
+    updateIndex();
+}
+
+int VirtualServoBus::getServoCount() const
+{
+    return static_cast<int>(servos.size());
+}
+
+unsigned VirtualServoBus::getPacketCount() const
+{
+    return packetCount;
+}
+
+unsigned VirtualServoBus::getErrorCount() const
+{
+    return errorCount;
+}
+
+void VirtualServoBus::initServo(VirtualServo &servo)
+{
+    int id = servo.id;
+    bool hkx = (servoSerie >= SERVO_HERKULEX);
+
+    // Size the memory areas from the control table
+    int romSize = 0, ramSize = 0;
+    for (unsigned i = 0; i < getRegisterCount(servo.ct); i++)
+    {
+        romSize = std::max(romSize, servo.ct[i][3] + servo.ct[i][1]);
+        ramSize = std::max(ramSize, servo.ct[i][4] + servo.ct[i][1]);
+    }
+
+    if (hkx == false)
+    {
+        // Dynamixel devices use a single address space
+        ramSize = std::max(romSize, ramSize);
+        romSize = 0;
+    }
+
+    servo.rom.assign(romSize, 0);
+    servo.ram.assign(ramSize, 0);
+
+    // Initial register values
+    for (unsigned i = 0; i < getRegisterCount(servo.ct); i++)
+    {
+        int reg_name = servo.ct[i][0];
+        int reg_size = servo.ct[i][1];
+        int value = servo.ct[i][5];
+
+        if (reg_name == REG_MODEL_NUMBER)
+        {
+            value = servo.model_number;
+        }
+        else if (reg_name == REG_FIRMWARE_VERSION)
+        {
+            value = 1;
+        }
+        else if (reg_name == REG_ID)
+        {
+            value = id;
+        }
+        else if (reg_name == REG_STATUS_RETURN_LEVEL)
+        {
+            value = 2;
+        }
+        else if (value < 0)
+        {
+            value = 0;
+        }
+
+        for (int b = 0; b < reg_size; b++)
+        {
+            unsigned char byte = static_cast<unsigned char>((value >> (8 * b)) & 0xFF);
+
+            if (hkx == true)
+            {
+                if (servo.ct[i][3] >= 0) servo.rom[servo.ct[i][3] + b] = byte;
+                if (servo.ct[i][4] >= 0) servo.ram[servo.ct[i][4] + b] = byte;
+            }
+            else
+            {
+                int addr = (servo.ct[i][3] >= 0) ? servo.ct[i][3] : servo.ct[i][4];
+                servo.ram[addr + b] = byte;
+            }
+        }
+    }
+
+    if (hkx == true)
+    {
+        // HerkuleX goal positions are set through I_JOG / S_JOG
+        servo.addrId = getRegisterAddr(servo.ct, REG_ID, REGISTER_RAM);
+        servo.addrReturnLevel = getRegisterAddr(servo.ct, REG_STATUS_RETURN_LEVEL, REGISTER_RAM);
+        servo.addrGoalPosition = getRegisterAddr(servo.ct, REG_ABSOLUTE_GOAL_POSITION, REGISTER_RAM);
+        servo.addrCurrentPosition = getRegisterAddr(servo.ct, REG_ABSOLUTE_POSITION, REGISTER_RAM);
+    }
+    else
+    {
+        servo.addrId = getRegisterAddr(servo.ct, REG_ID);
+        servo.addrReturnLevel = getRegisterAddr(servo.ct, REG_STATUS_RETURN_LEVEL);
+        servo.addrGoalPosition = getRegisterAddr(servo.ct, REG_GOAL_POSITION);
+        servo.addrCurrentPosition = getRegisterAddr(servo.ct, REG_CURRENT_POSITION);
+    }
+
+    servo.registeredAddr = -1;
+    servo.registeredData.clear();
+}
+
+void VirtualServoBus::updateIndex()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        servoIndex[i] = -1;
+    }
+
+    for (size_t i = 0; i < servos.size(); i++)
+    {
+        servoIndex[servos[i].id & 0xFF] = static_cast<int>(i);
+    }
+}
+
+VirtualServo *VirtualServoBus::getServo(const int id)
+{
+    if (id >= 0 && id < 256 && servoIndex[id] >= 0)
+    {
+        return &servos[servoIndex[id]];
+    }
+
+    return NULL;
+}
+
+void VirtualServoBus::writeRegisters(VirtualServo &servo, std::vector <unsigned char> &mem, const int addr, const unsigned char *data, const int length)
+{
+    if (addr < 0 || length <= 0 || (addr + length) > static_cast<int>(mem.size()))
+    {
+        return;
+    }
+
+    memcpy(&mem[addr], data, length);
+
+    if (&mem == &servo.ram)
+    {
+        // Moves complete instantly
+        if (servo.addrGoalPosition >= 0 && servo.addrCurrentPosition >= 0 &&
+            addr <= servo.addrGoalPosition + 1 && (addr + length) > servo.addrGoalPosition)
+        {
+            servo.ram[servo.addrCurrentPosition] = servo.ram[servo.addrGoalPosition];
+            servo.ram[servo.addrCurrentPosition + 1] = servo.ram[servo.addrGoalPosition + 1];
+        }
+
+        // ID change
+        if (servo.addrId >= 0 && addr <= servo.addrId && (addr + length) > servo.addrId)
+        {
+            int newId = servo.ram[servo.addrId];
+            if (newId != servo.id && newId < BROADCAST_ID && getServo(newId) == NULL)
+            {
+                TRACE_INFO(TOOLS, "Virtual servo #%i is now #%i\n", servo.id, newId);
+                servo.id = newId;
+                updateIndex();
+            }
+            else
+            {
+                servo.ram[servo.addrId] = static_cast<unsigned char>(servo.id);
+            }
+        }
+    }
+}
+
+bool VirtualServoBus::statusReturn(VirtualServo &servo, const bool read)
+{
+    int level = 2;
+    if (servo.addrReturnLevel >= 0)
+    {
+        level = servo.ram[servo.addrReturnLevel];
+    }
+
+    return (level >= 2 || (level == 1 && read == true));
+}
+
+/* ************************************************************************** */
+
+void VirtualServoBus::receive(const unsigned char *data, const int length, std::vector <unsigned char> &answer)
+{
+    input.insert(input.end(), data, data + length);
+
+    size_t pos = 0;
+    while (pos < input.size())
+    {
+        int size = parsePacket(&input[pos], static_cast<int>(input.size() - pos));
+
+        if (size > 0)
+        {
+            packetCount++;
+
+            if (servoSerie >= SERVO_HERKULEX)
+            {
+                processHerkuleX(&input[pos], size, answer);
+            }
+            else if (protocolVersion == 2)
+            {
+                std::vector <unsigned char> packet(input.begin() + pos, input.begin() + pos + size);
+                int packetSize = dxl2Unstuff(packet.data(), size);
+                processDynamixel(packet.data(), packetSize, answer);
+            }
+            else
+            {
+                processDynamixel(&input[pos], size, answer);
+            }
+
+            pos += size;
+        }
+        else if (size < 0)
+        {
+            // Not a (valid) packet header, skip one byte
+            pos++;
+        }
+        else
+        {
+            // Wait for the rest of the packet
+            break;
+        }
+    }
+
+    input.erase(input.begin(), input.begin() + pos);
+}
+
+int VirtualServoBus::parsePacket(const unsigned char *data, const int length)
+{
+    if (length < 2)
+    {
+        return 0;
+    }
+    if (data[0] != 0xFF || data[1] != 0xFF)
+    {
+        return -1;
+    }
+
+    int size = 0;
+
+    if (servoSerie >= SERVO_HERKULEX)
+    {
+        if (length < 7)
+        {
+            return 0;
+        }
+
+        size = data[2];
+        if (size < 7)
+        {
+            return -1;
+        }
+        if (length < size)
+        {
+            return 0;
+        }
+
+        unsigned short checksum = hkx_checksum(data, size);
+        if (data[5] != (checksum & 0xFF) || data[6] != (checksum >> 8))
+        {
+            errorCount++;
+            return -1;
+        }
+    }
+    else if (protocolVersion == 2)
+    {
+        if (length < 7)
+        {
+            return 0;
+        }
+        if (data[2] != 0xFD || data[3] != 0x00)
+        {
+            return -1;
+        }
+
+        size = (data[5] | (data[6] << 8)) + 7;
+        if (size < 10 || size > VIRTUAL_PACKET_MAX)
+        {
+            return -1;
+        }
+        if (length < size)
+        {
+            return 0;
+        }
+
+        unsigned short crc = dxl2_crc16(0, data, size - 2);
+        if (data[size - 2] != (crc & 0xFF) || data[size - 1] != (crc >> 8))
+        {
+            errorCount++;
+            return -1;
+        }
+    }
+    else
+    {
+        if (length < 4)
+        {
+            return 0;
+        }
+        if (data[2] == 0xFF)
+        {
+            return -1;
+        }
+
+        size = data[3] + 4;
+        if (size < 6)
+        {
+            return -1;
+        }
+        if (length < size)
+        {
+            return 0;
+        }
+
+        unsigned char checksum = 0;
+        for (int i = 2; i < size - 1; i++)
+        {
+            checksum += data[i];
+        }
+        if (data[size - 1] != static_cast<unsigned char>(~checksum))
+        {
+            errorCount++;
+            return -1;
+        }
+    }
+
+    return size;
+}
+
+/* ************************************************************************** */
+
+void VirtualServoBus::dxlStatus(std::vector <unsigned char> &answer, const int id, const int error, const unsigned char *params, const int count)
+{
+    size_t start = answer.size();
+
+    if (protocolVersion == 2)
+    {
+        int length = count + 4;
+        unsigned char header[] = {0xFF, 0xFF, 0xFD, 0x00, static_cast<unsigned char>(id),
+                                  static_cast<unsigned char>(length & 0xFF), static_cast<unsigned char>(length >> 8),
+                                  VINST_STATUS, static_cast<unsigned char>(error)};
+        answer.insert(answer.end(), header, header + sizeof(header));
+        if (count > 0)
+        {
+            answer.insert(answer.end(), params, params + count);
+        }
+        dxl2Stuff(answer, start);
+
+        unsigned short crc = dxl2_crc16(0, &answer[start], static_cast<int>(answer.size() - start));
+        answer.push_back(static_cast<unsigned char>(crc & 0xFF));
+        answer.push_back(static_cast<unsigned char>(crc >> 8));
+    }
+    else
+    {
+        unsigned char header[] = {0xFF, 0xFF, static_cast<unsigned char>(id),
+                                  static_cast<unsigned char>(count + 2), static_cast<unsigned char>(error)};
+        answer.insert(answer.end(), header, header + sizeof(header));
+        if (count > 0)
+        {
+            answer.insert(answer.end(), params, params + count);
+        }
+
+        unsigned char checksum = 0;
+        for (size_t i = start + 2; i < answer.size(); i++)
+        {
+            checksum += answer[i];
+        }
+        answer.push_back(static_cast<unsigned char>(~checksum));
+    }
+}
+
+void VirtualServoBus::dxlReadStatus(std::vector <unsigned char> &answer, VirtualServo &servo, const int addr, const int length)
+{
+    if (addr < 0 || length <= 0 || (addr + length) > static_cast<int>(servo.ram.size()))
+    {
+        dxlStatus(answer, servo.id, (protocolVersion == 2) ? static_cast<int>(ERRBIT2_DATA_RANGE) : static_cast<int>(ERRBIT1_RANGE), NULL, 0);
+    }
+    else
+    {
+        dxlStatus(answer, servo.id, 0, &servo.ram[addr], length);
+    }
+}
+
+void VirtualServoBus::processDynamixel(const unsigned char *packet, const int packetSize, std::vector <unsigned char> &answer)
+{
+    bool v2 = (protocolVersion == 2);
+    int id = v2 ? packet[4] : packet[2];
+    int inst = v2 ? packet[7] : packet[4];
+    const unsigned char *params = v2 ? &packet[8] : &packet[5];
+    int count = v2 ? (packetSize - 10) : (packetSize - 6);
+    int addrSize = v2 ? 2 : 1; // size of the address and length fields
+
+    bool broadcast = (id == BROADCAST_ID);
+    VirtualServo *servo = getServo(id);
+
+    if (broadcast == false && servo == NULL &&
+        inst != VINST_SYNC_READ && inst != VINST_SYNC_WRITE &&
+        inst != VINST_BULK_READ && inst != VINST_BULK_WRITE)
+    {
+        // Nobody home
+        return;
+    }
+
+    switch (inst)
+    {
+    case VINST_PING:
+        for (size_t i = 0; i < servos.size(); i++)
+        {
+            VirtualServo &s = servos[i];
+            if (&s == servo || (broadcast == true && v2 == true))
+            {
+                unsigned char infos[] = {static_cast<unsigned char>(s.model_number & 0xFF),
+                                         static_cast<unsigned char>((s.model_number >> 8) & 0xFF), 1};
+                dxlStatus(answer, s.id, 0, infos, v2 ? 3 : 0);
+            }
+        }
+        break;
+
+    case VINST_READ:
+        if (servo != NULL && count >= addrSize * 2 && statusReturn(*servo, true))
+        {
+            int addr = v2 ? (params[0] | (params[1] << 8)) : params[0];
+            int length = v2 ? (params[2] | (params[3] << 8)) : params[1];
+            dxlReadStatus(answer, *servo, addr, length);
+        }
+        break;
+
+    case VINST_WRITE:
+    case VINST_REG_WRITE:
+        if (count > addrSize)
+        {
+            int addr = v2 ? (params[0] | (params[1] << 8)) : params[0];
+
+            for (size_t i = 0; i < servos.size(); i++)
+            {
+                VirtualServo &s = servos[i];
+                if (&s == servo || broadcast == true)
+                {
+                    if (inst == VINST_WRITE)
+                    {
+                        writeRegisters(s, s.ram, addr, params + addrSize, count - addrSize);
+                    }
+                    else
+                    {
+                        s.registeredAddr = addr;
+                        s.registeredData.assign(params + addrSize, params + count);
+                    }
+                }
+            }
+
+            if (servo != NULL && broadcast == false && statusReturn(*servo, false))
+            {
+                dxlStatus(answer, servo->id, 0, NULL, 0);
+            }
+        }
+        break;
+
+    case VINST_ACTION:
+        for (size_t i = 0; i < servos.size(); i++)
+        {
+            VirtualServo &s = servos[i];
+            if ((&s == servo || broadcast == true) && s.registeredAddr >= 0)
+            {
+                writeRegisters(s, s.ram, s.registeredAddr, s.registeredData.data(), static_cast<int>(s.registeredData.size()));
+                s.registeredAddr = -1;
+            }
+        }
+        if (servo != NULL && broadcast == false && statusReturn(*servo, false))
+        {
+            dxlStatus(answer, servo->id, 0, NULL, 0);
+        }
+        break;
+
+    case VINST_FACTORY_RESET:
+    case VINST_REBOOT:
+        if (servo != NULL)
+        {
+            if (inst == VINST_FACTORY_RESET)
+            {
+                initServo(*servo);
+            }
+            if (broadcast == false && statusReturn(*servo, false))
+            {
+                dxlStatus(answer, servo->id, 0, NULL, 0);
+            }
+        }
+        break;
+
+    case VINST_SYNC_WRITE:
+        if (count > addrSize * 2)
+        {
+            int addr = v2 ? (params[0] | (params[1] << 8)) : params[0];
+            int length = v2 ? (params[2] | (params[3] << 8)) : params[1];
+
+            for (int i = addrSize * 2; length > 0 && (i + 1 + length) <= count; i += 1 + length)
+            {
+                VirtualServo *s = getServo(params[i]);
+                if (s != NULL)
+                {
+                    writeRegisters(*s, s->ram, addr, &params[i + 1], length);
+                }
+            }
+        }
+        break;
+
+    case VINST_SYNC_READ:
+        if (v2 == true && count > 4)
+        {
+            int addr = params[0] | (params[1] << 8);
+            int length = params[2] | (params[3] << 8);
+
+            for (int i = 4; i < count; i++)
+            {
+                VirtualServo *s = getServo(params[i]);
+                if (s != NULL)
+                {
+                    dxlReadStatus(answer, *s, addr, length);
+                }
+            }
+        }
+        break;
+
+    case VINST_BULK_READ:
+        if (v2 == true)
+        {
+            for (int i = 0; (i + 5) <= count; i += 5)
+            {
+                VirtualServo *s = getServo(params[i]);
+                if (s != NULL)
+                {
+                    dxlReadStatus(answer, *s, params[i + 1] | (params[i + 2] << 8), params[i + 3] | (params[i + 4] << 8));
+                }
+            }
+        }
+        else
+        {
+            // First parameter is always 0x00
+            for (int i = 1; (i + 3) <= count; i += 3)
+            {
+                VirtualServo *s = getServo(params[i + 1]);
+                if (s != NULL)
+                {
+                    dxlReadStatus(answer, *s, params[i + 2], params[i]);
+                }
+            }
+        }
+        break;
+
+    case VINST_BULK_WRITE:
+        if (v2 == true)
+        {
+            for (int i = 0; (i + 5) <= count;)
+            {
+                int length = params[i + 3] | (params[i + 4] << 8);
+                if ((i + 5 + length) > count)
+                {
+                    break;
+                }
+
+                VirtualServo *s = getServo(params[i]);
+                if (s != NULL)
+                {
+                    writeRegisters(*s, s->ram, params[i + 1] | (params[i + 2] << 8), &params[i + 5], length);
+                }
+
+                i += 5 + length;
+            }
+        }
+        break;
+
+    default:
+        if (servo != NULL && broadcast == false)
+        {
+            dxlStatus(answer, servo->id, v2 ? static_cast<int>(ERRBIT2_INSTRUCTION) : static_cast<int>(ERRBIT1_INSTRUCTION), NULL, 0);
+        }
+        break;
+    }
+}
+
+/* ************************************************************************** */
+
+void VirtualServoBus::hkxStatus(std::vector <unsigned char> &answer, const int id, const int cmd, const unsigned char *data, const int count, const int error, const int detail)
+{
+    size_t start = answer.size();
+    int size = 7 + count + 2;
+
+    unsigned char header[] = {0xFF, 0xFF, static_cast<unsigned char>(size), static_cast<unsigned char>(id),
+                              static_cast<unsigned char>(cmd + 0x40), 0, 0};
+    answer.insert(answer.end(), header, header + sizeof(header));
+    if (count > 0)
+    {
+        answer.insert(answer.end(), data, data + count);
+    }
+    answer.push_back(static_cast<unsigned char>(error));
+    answer.push_back(static_cast<unsigned char>(detail));
+
+    unsigned short checksum = hkx_checksum(&answer[start], size);
+    answer[start + 5] = static_cast<unsigned char>(checksum & 0xFF);
+    answer[start + 6] = static_cast<unsigned char>(checksum >> 8);
+}
+
+void VirtualServoBus::processHerkuleX(const unsigned char *packet, const int packetSize, std::vector <unsigned char> &answer)
+{
+    int id = packet[3];
+    int cmd = packet[4];
+    const unsigned char *data = &packet[7];
+    int count = packetSize - 7;
+
+    bool broadcast = (id == BROADCAST_ID);
+    VirtualServo *servo = getServo(id);
+
+    if (broadcast == false && servo == NULL)
+    {
+        return;
+    }
+
+    switch (cmd)
+    {
+    case VCMD_EEP_WRITE:
+    case VCMD_RAM_WRITE:
+        if (count >= 2)
+        {
+            int length = std::min(static_cast<int>(data[1]), count - 2);
+
+            for (size_t i = 0; i < servos.size(); i++)
+            {
+                VirtualServo &s = servos[i];
+                if (&s == servo || broadcast == true)
+                {
+                    writeRegisters(s, (cmd == VCMD_EEP_WRITE) ? s.rom : s.ram, data[0], &data[2], length);
+                }
+            }
+
+            if (servo != NULL && broadcast == false && statusReturn(*servo, false))
+            {
+                hkxStatus(answer, servo->id, cmd, NULL, 0, 0, 0);
+            }
+        }
+        break;
+
+    case VCMD_EEP_READ:
+    case VCMD_RAM_READ:
+        if (servo != NULL && broadcast == false && count >= 2 && statusReturn(*servo, true))
+        {
+            std::vector <unsigned char> &mem = (cmd == VCMD_EEP_READ) ? servo->rom : servo->ram;
+            int addr = data[0];
+            int length = data[1];
+
+            if ((addr + length) > static_cast<int>(mem.size()))
+            {
+                hkxStatus(answer, servo->id, cmd, data, 2, ERRBIT_INVALID_PKT, STATBIT_RANGE);
+            }
+            else
+            {
+                std::vector <unsigned char> payload(data, data + 2);
+                payload.insert(payload.end(), mem.begin() + addr, mem.begin() + addr + length);
+                hkxStatus(answer, servo->id, cmd, payload.data(), static_cast<int>(payload.size()), 0, 0);
+            }
+        }
+        break;
+
+    case VCMD_I_JOG:
+    case VCMD_S_JOG:
+    {
+        // I_JOG: (JOG_L, JOG_H, SET, ID, playtime) for each servo
+        // S_JOG: playtime, then (JOG_L, JOG_H, SET, ID) for each servo
+        int recordSize = (cmd == VCMD_I_JOG) ? 5 : 4;
+        int first = (cmd == VCMD_I_JOG) ? 0 : 1;
+
+        for (int i = first; (i + recordSize) <= count; i += recordSize)
+        {
+            VirtualServo *s = getServo(data[i + 3]);
+
+            // Only position control is simulated (no continuous rotation)
+            if (s != NULL && (data[i + 2] & 0x02) == 0 && s->addrGoalPosition >= 0)
+            {
+                unsigned char position[2] = {data[i], static_cast<unsigned char>(data[i + 1] & 0x7F)};
+                writeRegisters(*s, s->ram, s->addrGoalPosition, position, 2);
+            }
+        }
+
+        if (servo != NULL && broadcast == false && statusReturn(*servo, false))
+        {
+            hkxStatus(answer, servo->id, cmd, NULL, 0, 0, 0);
+        }
+        break;
+    }
+
+    case VCMD_STAT:
+        if (servo != NULL && broadcast == false)
+        {
+            hkxStatus(answer, servo->id, cmd, NULL, 0, 0, 0);
+        }
+        break;
+
+    default:
+        // ROLLBACK, REBOOT...
+        if (servo != NULL && broadcast == false && statusReturn(*servo, false))
+        {
+            hkxStatus(answer, servo->id, cmd, NULL, 0, 0, 0);
+        }
+        break;
+    }
+}
@@ -0,0 +1,145 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file VirtualServoBus.h
+ * \date 16/10/2026
+ * \author agent <agent@local>
+ */
+
+#ifndef VIRTUAL_SERVO_BUS_H
+#define VIRTUAL_SERVO_BUS_H
+
+#include "SerialPortLoopback.h"
+
+// C++ standard libraries
+#include <vector>
+
+/*!
+ * \brief VirtualServo structure, the state of a simulated device.
+ */
+typedef struct VirtualServo
+{
+    int id;                        //!< Current device ID.
+    int model_number;              //!< Model number reported by the device.
+    int servo_serie;               //!< Servo serie using '::ServoDevices_e' enum.
+    int servo_model;               //!< Servo model using '::ServoDevices_e' enum.
+    const int (*ct)[8];            //!< Control table of the device.
+
+    std::vector <unsigned char> rom; //!< EEPROM area. Only used by HerkuleX devices, Dynamixel use a single address space.
+    std::vector <unsigned char> ram; //!< RAM area, or the whole register space for Dynamixel devices.
+
+    int addrId;                    //!< Address of the ID register (in 'ram').
+    int addrReturnLevel;           //!< Address of the status return level register (in 'ram').
+    int addrGoalPosition;          //!< Address of the goal position register (in 'ram'), or -1.
+    int addrCurrentPosition;       //!< Address of the current position register (in 'ram'), or -1.
+
+    int registeredAddr;            //!< Address of the write staged by REG_WRITE, or -1.
+    std::vector <unsigned char> registeredData; //!< Data of the write staged by REG_WRITE.
+
+} VirtualServo;
+
+/*!
+ * \brief The VirtualServoBus class simulates a bus of Dynamixel or HerkuleX devices.
+ *
+ * Instruction packets are parsed from the incoming byte stream, and the matching
+ * status packets are generated using the control tables from ControlTablesDynamixel.h
+ * and ControlTablesHerkuleX.h. It can be attached to a SerialPortLoopback bus,
+ * or fed from any other transport (like a pseudo-terminal).
+ *
+ * Supported instructions:
+ * - Dynamixel v1/v2: PING, READ, WRITE, REG_WRITE, ACTION, FACTORY_RESET, REBOOT,
+ *   SYNC_WRITE, SYNC_READ (v2), BULK_READ and BULK_WRITE (v2).
+ * - HerkuleX: EEP_WRITE, EEP_READ, RAM_WRITE, RAM_READ, I_JOG and S_JOG (position
+ *   control only), STAT, and acknowledgement only for ROLLBACK and REBOOT.
+ *
+ * Devices answer according to their status return level register. Goal positions
+ * are copied to current positions right away, so moves complete instantly.
+ */
+class VirtualServoBus: public LoopbackDevice
+{
+    int servoSerie;                //!< Servo serie simulated on this bus (using ::ServoDevices_e), only Dynamixel or HerkuleX family matters.
+    int protocolVersion;           //!< Dynamixel communication protocol version (1 or 2).
+
+    std::vector <VirtualServo> servos; //!< Simulated devices.
+    int servoIndex[256];           //!< Index of each ID in 'servos', or -1.
+
+    std::vector <unsigned char> input; //!< Incoming bytes not yet processed.
+    unsigned packetCount;          //!< Number of valid instruction packets processed.
+    unsigned errorCount;           //!< Number of corrupted instruction packets dropped.
+
+    void initServo(VirtualServo &servo);
+    void updateIndex();
+    VirtualServo *getServo(const int id);
+    void writeRegisters(VirtualServo &servo, std::vector <unsigned char> &mem, const int addr, const unsigned char *data, const int length);
+    bool statusReturn(VirtualServo &servo, const bool read);
+
+    int parsePacket(const unsigned char *data, const int length);
+    void processDynamixel(const unsigned char *packet, const int packetSize, std::vector <unsigned char> &answer);
+    void processHerkuleX(const unsigned char *packet, const int packetSize, std::vector <unsigned char> &answer);
+
+    void dxlStatus(std::vector <unsigned char> &answer, const int id, const int error, const unsigned char *params, const int count);
+    void dxlReadStatus(std::vector <unsigned char> &answer, VirtualServo &servo, const int addr, const int length);
+    void hkxStatus(std::vector <unsigned char> &answer, const int id, const int cmd, const unsigned char *data, const int count, const int error, const int detail);
+
+public:
+    /*!
+     * \brief VirtualServoBus constructor.
+     * \param servoSerie: Servo serie simulated on this bus (using ::ServoDevices_e).
+     * \param protocolVersion: Dynamixel communication protocol version (1 or 2). Ignored for HerkuleX devices.
+     */
+    VirtualServoBus(const int servoSerie, const int protocolVersion = 1);
+    ~VirtualServoBus();
+
+    /*!
+     * \brief Add a simulated device to the bus.
+     * \param id: ID of the device.
+     * \param model_number: Model number of the device (ex: 0x000C for an AX-12A, 0x0101 for a DRS-0101).
+     * \return 1 if success, 0 if the model is unknown or the ID is invalid or already used.
+     */
+    int addServo(const int id, const int model_number);
+
+    /*!
+     * \brief Remove a simulated device from the bus.
+     * \param id: ID of the device.
+     */
+    void removeServo(const int id);
+
+    /*!
+     * \brief Get the number of simulated devices on the bus.
+     */
+    int getServoCount() const;
+
+    /*!
+     * \brief Get the number of valid instruction packets processed.
+     */
+    unsigned getPacketCount() const;
+
+    /*!
+     * \brief Get the number of corrupted instruction packets dropped.
+     */
+    unsigned getErrorCount() const;
+
+    /*!
+     * \brief Process data written on the bus.
+     * \param[in] data: Bytes written by the host.
+     * \param length: Number of byte(s) written by the host.
+     * \param[out] answer: Status packets to send back to the host are appended here.
+     */
+    void receive(const unsigned char *data, const int length, std::vector <unsigned char> &answer);
+};
+
+#endif /* VIRTUAL_SERVO_BUS_H */